@@ -62,6 +62,11 @@
 #include "contin_array.h"
 #include "pcm_mix.h"
 #include "streamctrl.h"
+#include "audio_proc.h"
+#include "audio_trace.h"
+#if (CONFIG_PROMPT_MIXER)
+#include "prompt_mixer.h"
+#endif /* (CONFIG_PROMPT_MIXER) */
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(audio_datapath, CONFIG_LOG_AUDIO_DATAPATH_LEVEL);
@@ -123,6 +128,12 @@ LOG_MODULE_REGISTER(audio_datapath, CONFIG_LOG_AUDIO_DATAPATH_LEVEL);
 /* How often to print underrun warning */
 #define UNDERRUN_LOG_INTERVAL_BLKS 5000
 
+enum ttfa_state {
+	TTFA_STATE_IDLE,
+	TTFA_STATE_WAIT_FRAME, /* Waiting for the first decoded frame */
+	TTFA_STATE_WAIT_PLAY, /* Waiting for the frame to be played out over I2S */
+};
+
 enum drift_comp_state {
 	DRIFT_STATE_INIT, /* Waiting for data to be received */
 	DRIFT_STATE_CALIB, /* Calibrate and zero out local delay */
@@ -154,6 +165,9 @@ static const char *const pres_comp_state_names[] = {
 static struct {
 	bool datapath_initialized;
 	bool stream_started;
+#if (CONFIG_AUDIO_WARM_PAUSE)
+	bool stream_paused;
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
 	void *decoded_data;
 
 	struct {
@@ -170,14 +184,21 @@ static struct {
 	} out;
 
 	uint32_t previous_sdu_ref_us;
+	/* Any timestamp is valid, including 0, so validity is kept separately */
+	bool previous_sdu_ref_valid;
 	uint32_t current_pres_dly_us;
 
 	struct {
 		enum drift_comp_state state : 8;
 		uint16_t ctr; /* Count func calls. Used for waiting */
-		uint32_t meas_start_time_us;
+		/* On the 64 bit timebase, so a timer clear by the NET core does not
+		 * corrupt the measurement
+		 */
+		uint64_t meas_start_time_us;
 		uint32_t center_freq;
 		bool hfclkaudio_comp_enabled;
+		/* Target I2S block start relative to sdu_ref, modulo block period */
+		uint32_t phase_offset_us;
 	} drift_comp;
 
 	struct {
@@ -186,6 +207,14 @@ static struct {
 		int32_t sum_err_dly_us;
 		uint32_t pres_delay_us;
 	} pres_comp;
+
+	/* Time to first audio */
+	struct {
+		enum ttfa_state state;
+		bool warm;
+		uint32_t start_cyc;
+		uint32_t last_us;
+	} ttfa;
 } ctrl_blk;
 
 static bool tone_active;
@@ -217,6 +246,7 @@ static void drift_comp_state_set(enum drift_comp_state new_state)
 	ctrl_blk.drift_comp.ctr = 0;
 
 	ctrl_blk.drift_comp.state = new_state;
+	AUDIO_TRACE(AUDIO_TRACE_DRIFT_STATE, new_state, 0, 0);
 	LOG_INF("Drft comp state: %s", drift_comp_state_names[new_state]);
 }
 
@@ -232,8 +262,9 @@ static void audio_datapath_drift_compensation(uint32_t frame_start_ts)
 	switch (ctrl_blk.drift_comp.state) {
 	case DRIFT_STATE_INIT: {
 		/* Check if audio data has been received */
-		if (ctrl_blk.previous_sdu_ref_us) {
-			ctrl_blk.drift_comp.meas_start_time_us = ctrl_blk.previous_sdu_ref_us;
+		if (ctrl_blk.previous_sdu_ref_valid) {
+			ctrl_blk.drift_comp.meas_start_time_us =
+				audio_sync_timer_ts_extend(ctrl_blk.previous_sdu_ref_us);
 
 			drift_comp_state_set(DRIFT_STATE_CALIB);
 		}
@@ -245,8 +276,9 @@ static void audio_datapath_drift_compensation(uint32_t frame_start_ts)
 			return;
 		}
 
-		int32_t err_us = DRIFT_MEAS_PERIOD_US - (ctrl_blk.previous_sdu_ref_us -
-							 ctrl_blk.drift_comp.meas_start_time_us);
+		int32_t err_us = DRIFT_MEAS_PERIOD_US -
+				 (int32_t)(audio_sync_timer_ts_extend(ctrl_blk.previous_sdu_ref_us) -
+					   ctrl_blk.drift_comp.meas_start_time_us);
 
 		int32_t freq_adj = APLL_FREQ_ADJ(err_us);
 
@@ -265,16 +297,19 @@ static void audio_datapath_drift_compensation(uint32_t frame_start_ts)
 		break;
 	}
 	case DRIFT_STATE_OFFSET: {
+		if (!ctrl_blk.previous_sdu_ref_valid) {
+			/* Waiting for the first frame of a resumed stream */
+			return;
+		}
+
 		if (++ctrl_blk.drift_comp.ctr < DRIFT_COMP_WAITING_CNT) {
 			/* Waiting */
 			return;
 		}
 
-		int32_t err_us = (ctrl_blk.previous_sdu_ref_us - frame_start_ts) % BLK_PERIOD_US;
-
-		if (err_us > (BLK_PERIOD_US / 2)) {
-			err_us = err_us - BLK_PERIOD_US;
-		}
+		int32_t err_us = audio_sync_timer_phase_us(
+			ctrl_blk.previous_sdu_ref_us + ctrl_blk.drift_comp.phase_offset_us,
+			frame_start_ts, BLK_PERIOD_US);
 
 		int32_t freq_adj = APLL_FREQ_ADJ(err_us);
 
@@ -292,11 +327,9 @@ static void audio_datapath_drift_compensation(uint32_t frame_start_ts)
 			return;
 		}
 
-		int32_t err_us = (ctrl_blk.previous_sdu_ref_us - frame_start_ts) % BLK_PERIOD_US;
-
-		if (err_us > (BLK_PERIOD_US / 2)) {
-			err_us = err_us - BLK_PERIOD_US;
-		}
+		int32_t err_us = audio_sync_timer_phase_us(
+			ctrl_blk.previous_sdu_ref_us + ctrl_blk.drift_comp.phase_offset_us,
+			frame_start_ts, BLK_PERIOD_US);
 
 		/* Use asymptotic correction with small errors */
 		err_us /= 2;
@@ -329,6 +362,7 @@ static void pres_comp_state_set(enum pres_comp_state new_state)
 	ctrl_blk.pres_comp.ctr = 0;
 
 	ctrl_blk.pres_comp.state = new_state;
+	AUDIO_TRACE(AUDIO_TRACE_PRES_STATE, new_state, 0, 0);
 	LOG_INF("Pres comp state: %s", pres_comp_state_names[new_state]);
 	if (new_state == PRES_STATE_LOCKED) {
 		ret = led_on(LED_APP_2_GREEN);
@@ -364,8 +398,8 @@ static void audio_datapath_presentation_compensation(uint32_t recv_frame_ts_us,
 		pres_comp_state_set(PRES_STATE_WAIT);
 	}
 
-	int32_t wanted_pres_dly_us =
-		ctrl_blk.pres_comp.pres_delay_us - (recv_frame_ts_us - sdu_ref_us);
+	int32_t wanted_pres_dly_us = ctrl_blk.pres_comp.pres_delay_us -
+				     audio_sync_timer_diff_us(recv_frame_ts_us, sdu_ref_us);
 	int32_t pres_adj_us = 0;
 
 	switch (ctrl_blk.pres_comp.state) {
@@ -422,6 +456,8 @@ static void audio_datapath_presentation_compensation(uint32_t recv_frame_ts_us,
 		return;
 	}
 
+	AUDIO_TRACE(AUDIO_TRACE_PRES_ADJ, 0, 0, (uint32_t)pres_adj_us);
+
 	if (pres_adj_us >= 0) {
 		pres_adj_us += (BLK_PERIOD_US / 2);
 	} else {
@@ -514,7 +550,13 @@ void audio_datapath_tone_stop(void)
 	k_work_submit(&tone_stop_work);
 }
 
-static void tone_mix(uint8_t *tx_buf)
+#if (CONFIG_AUDIO_PROC_NODE_TEST_TONE)
+static bool tone_mix_active(void)
+{
+	return tone_active;
+}
+
+static void tone_mix(void *const tx_buf, size_t size)
 {
 	int ret;
 	int8_t tone_buf_continuous[BLK_MONO_SIZE_OCTETS];
@@ -524,11 +566,14 @@ static void tone_mix(uint8_t *tx_buf)
 				  test_tone_size, &finite_pos);
 	ERR_CHK(ret);
 
-	ret = pcm_mix(tx_buf, BLK_STEREO_SIZE_OCTETS, tone_buf_continuous, BLK_MONO_SIZE_OCTETS,
+	ret = pcm_mix(tx_buf, size, tone_buf_continuous, BLK_MONO_SIZE_OCTETS,
 		      B_MONO_INTO_A_STEREO_L);
 	ERR_CHK(ret);
 }
 
+AUDIO_PROC_NODE_DEFINE(test_tone, 10, AUDIO_PROC_STAGE_BLOCK, tone_mix_active, tone_mix);
+#endif /* (CONFIG_AUDIO_PROC_NODE_TEST_TONE) */
+
 /* Alternate-buffers used when there is no active audio stream.
  * Used interchangably by I2S.
  */
@@ -586,6 +631,20 @@ static void alt_buffer_free_both(void)
 	alt.buf_1_in_use = false;
 }
 
+#if (CONFIG_FIFO_RX_SPSC)
+/* I2S RX target when in.fifo is full. Never locked into the FIFO */
+static uint32_t rx_scratch[WB_UP(BLOCK_SIZE_BYTES) / sizeof(uint32_t)];
+#endif /* (CONFIG_FIFO_RX_SPSC) */
+
+static void ttfa_done(void)
+{
+	ctrl_blk.ttfa.last_us = k_cyc_to_us_floor32(k_cycle_get_32() - ctrl_blk.ttfa.start_cyc);
+	ctrl_blk.ttfa.state = TTFA_STATE_IDLE;
+
+	LOG_INF("Time to first audio (%s start): %u us", ctrl_blk.ttfa.warm ? "warm" : "cold",
+		ctrl_blk.ttfa.last_us);
+}
+
 /*
  * This handler function is called every time I2S needs new buffers for
  * TX and RX data.
@@ -604,9 +663,12 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 
 	alt_buffer_free(tx_buf_released);
 
+	AUDIO_TRACE_TS(frame_start_ts, AUDIO_TRACE_I2S_FRAME_START, 0, ctrl_blk.out.cons_blk_idx,
+		       ctrl_blk.out.prod_blk_idx);
+
 	/*** Presentation delay measurement ***/
-	ctrl_blk.current_pres_dly_us =
-		frame_start_ts - ctrl_blk.out.prod_blk_ts[ctrl_blk.out.cons_blk_idx];
+	ctrl_blk.current_pres_dly_us = audio_sync_timer_diff_us(
+		frame_start_ts, ctrl_blk.out.prod_blk_ts[ctrl_blk.out.cons_blk_idx]);
 
 	/********** I2S TX **********/
 	static uint8_t *tx_buf;
@@ -627,10 +689,16 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 			tx_buf = (uint8_t *)&ctrl_blk.out
 					 .fifo[next_out_blk_idx * BLK_MONO_SIZE_OCTETS];
 
+			if (ctrl_blk.ttfa.state == TTFA_STATE_WAIT_PLAY) {
+				ttfa_done();
+			}
+
 		} else {
 			if (stream_state_get() == STATE_STREAMING) {
 				underrun_condition = true;
 				ctrl_blk.out.total_blk_underruns++;
+				AUDIO_TRACE_TS(frame_start_ts, AUDIO_TRACE_I2S_UNDERRUN, 0, 0,
+					       ctrl_blk.out.total_blk_underruns);
 
 				if ((ctrl_blk.out.total_blk_underruns %
 				     UNDERRUN_LOG_INTERVAL_BLKS) == 0) {
@@ -648,9 +716,8 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 			memset(tx_buf, 0, BLK_STEREO_SIZE_OCTETS);
 		}
 
-		if (tone_active) {
-			tone_mix(tx_buf);
-		}
+		/*** Block processing (test tone, prompts, etc.) ***/
+		audio_proc_run(AUDIO_PROC_STAGE_BLOCK, tx_buf, BLK_STEREO_SIZE_OCTETS);
 	}
 
 	/********** I2S RX **********/
@@ -658,7 +725,11 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 	static int prev_ret;
 
 	/* Lock last filled buffer into message queue */
+#if (CONFIG_FIFO_RX_SPSC)
+	if (rx_buf_released != NULL && rx_buf_released != rx_scratch) {
+#else
 	if (rx_buf_released != NULL) {
+#endif /* (CONFIG_FIFO_RX_SPSC) */
 		ret = data_fifo_block_lock(ctrl_blk.in.fifo, (void **)&rx_buf_released,
 					   BLOCK_SIZE_BYTES);
 
@@ -674,14 +745,21 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 
 	/* If RX FIFO is filled up */
 	if (ret == -ENOMEM) {
-		void *data;
-		size_t size;
+		AUDIO_TRACE_TS(frame_start_ts, AUDIO_TRACE_I2S_OVERRUN, 0, 0, 0);
 
 		if (ret != prev_ret) {
 			LOG_WRN("I2S RX overrun. Single msg");
 			prev_ret = ret;
 		}
 
+#if (CONFIG_FIFO_RX_SPSC)
+		/* Only the consumer may free blocks, drop the newest block instead */
+		rx_buf = rx_scratch;
+		ret = 0;
+#else
+		void *data;
+		size_t size;
+
 		ret = data_fifo_pointer_last_filled_get(ctrl_blk.in.fifo, &data, &size, K_NO_WAIT);
 		ERR_CHK(ret);
 
@@ -690,6 +768,7 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 
 		ret = data_fifo_pointer_first_vacant_get(ctrl_blk.in.fifo, (void **)&rx_buf,
 							 K_NO_WAIT);
+#endif /* (CONFIG_FIFO_RX_SPSC) */
 	}
 
 	ERR_CHK_MSG(ret, "RX failed to get block");
@@ -698,9 +777,37 @@ static void audio_datapath_i2s_blk_complete(uint32_t frame_start_ts, uint32_t *r
 	audio_i2s_set_next_buf(tx_buf, rx_buf);
 
 	/*** Drift compensation ***/
+#if (CONFIG_AUDIO_WARM_PAUSE)
+	/* Hold the APLL frequency while there is no stream to follow */
+	if (ctrl_blk.stream_paused) {
+		return;
+	}
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
 	audio_datapath_drift_compensation(frame_start_ts);
 }
 
+#if (CONFIG_I2S_TDM_EMULATION)
+static i2s_tdm_rx_callback_t tdm_rx_consumer;
+
+static void audio_datapath_i2s_tdm_rx(uint32_t frame_start_ts, int16_t const *slots,
+				      uint8_t slot_num, uint32_t frames)
+{
+	i2s_tdm_rx_callback_t consumer = tdm_rx_consumer;
+
+	if (!ctrl_blk.stream_started || consumer == NULL) {
+		return;
+	}
+
+	consumer(frame_start_ts, slots, slot_num, frames);
+}
+
+void audio_datapath_tdm_rx_cb_register(i2s_tdm_rx_callback_t tdm_rx_callback)
+{
+	tdm_rx_consumer = tdm_rx_callback;
+}
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 static void audio_datapath_i2s_start(void)
 {
 	int ret;
@@ -766,12 +873,17 @@ void audio_datapath_pres_delay_us_get(uint32_t *delay_us)
 	*delay_us = ctrl_blk.pres_comp.pres_delay_us;
 }
 
+void audio_datapath_i2s_phase_offset_set(uint32_t offset_us)
+{
+	ctrl_blk.drift_comp.phase_offset_us = offset_us % BLK_PERIOD_US;
+}
+
 void audio_datapath_just_in_time_check_and_adjust(uint32_t sdu_ref_us)
 {
 	static int32_t count;
 
 	uint32_t curr_frame_ts = audio_sync_timer_curr_time_get();
-	int diff = curr_frame_ts - sdu_ref_us;
+	int32_t diff = audio_sync_timer_diff_us(curr_frame_ts, sdu_ref_us);
 
 	if (count++ % 100 == 0) {
 		LOG_DBG("Time from last anchor: %d", diff);
@@ -788,6 +900,7 @@ void audio_datapath_sdu_ref_update(uint32_t sdu_ref_us)
 {
 	if (ctrl_blk.stream_started) {
 		ctrl_blk.previous_sdu_ref_us = sdu_ref_us;
+		ctrl_blk.previous_sdu_ref_valid = true;
 	} else {
 		LOG_WRN("Stream not startet - Can not update sdu_ref_us");
 	}
@@ -803,11 +916,11 @@ void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref
 
 	/*** Check incoming data ***/
 
-	if (!buf) {
+	if (!buf && !bad_frame) {
 		LOG_ERR("buf is NULL");
 	}
 
-	if (sdu_ref_us == ctrl_blk.previous_sdu_ref_us) {
+	if (ctrl_blk.previous_sdu_ref_valid && sdu_ref_us == ctrl_blk.previous_sdu_ref_us) {
 		LOG_WRN("Duplicate sdu_ref_us (%d) - Dropping audio frame", sdu_ref_us);
 		return;
 	}
@@ -817,13 +930,16 @@ void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref
 		LOG_DBG("Bad audio frame");
 	}
 
+	AUDIO_TRACE_TS(recv_frame_ts_us, AUDIO_TRACE_SDU_RECV, bad_frame, 0, sdu_ref_us);
+
 	bool sdu_ref_not_consecutive = false;
 
-	if (ctrl_blk.previous_sdu_ref_us) {
-		uint32_t sdu_ref_delta_us = sdu_ref_us - ctrl_blk.previous_sdu_ref_us;
+	if (ctrl_blk.previous_sdu_ref_valid) {
+		int32_t sdu_ref_delta_us =
+			audio_sync_timer_diff_us(sdu_ref_us, ctrl_blk.previous_sdu_ref_us);
 
 		/* Check if the delta is from two consecutive frames */
-		if (sdu_ref_delta_us <
+		if (sdu_ref_delta_us > 0 && sdu_ref_delta_us <
 		    (CONFIG_AUDIO_FRAME_DURATION_US + (CONFIG_AUDIO_FRAME_DURATION_US / 2))) {
 			/* Check for invalid delta */
 			if ((sdu_ref_delta_us >
@@ -844,6 +960,7 @@ void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref
 	}
 
 	ctrl_blk.previous_sdu_ref_us = sdu_ref_us;
+	ctrl_blk.previous_sdu_ref_valid = true;
 
 	/*** Presentation compensation ***/
 
@@ -867,6 +984,9 @@ void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref
 		return;
 	}
 
+	/*** Frame processing ***/
+	audio_proc_run(AUDIO_PROC_STAGE_FRAME, ctrl_blk.decoded_data, pcm_size);
+
 	/*** Add audio data to FIFO buffer ***/
 
 	int32_t num_blks_in_fifo = ctrl_blk.out.prod_blk_idx - ctrl_blk.out.cons_blk_idx;
@@ -892,6 +1012,10 @@ void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref
 	}
 
 	ctrl_blk.out.prod_blk_idx = out_blk_idx;
+
+	if (ctrl_blk.ttfa.state == TTFA_STATE_WAIT_FRAME) {
+		ctrl_blk.ttfa.state = TTFA_STATE_WAIT_PLAY;
+	}
 }
 
 int audio_datapath_start(struct data_fifo *fifo_rx)
@@ -922,8 +1046,11 @@ int audio_datapath_stop(void)
 {
 	if (ctrl_blk.stream_started) {
 		ctrl_blk.stream_started = false;
+#if (CONFIG_AUDIO_WARM_PAUSE)
+		ctrl_blk.stream_paused = false;
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
 		audio_datapath_i2s_stop();
-		ctrl_blk.previous_sdu_ref_us = 0;
+		ctrl_blk.previous_sdu_ref_valid = false;
 
 		pres_comp_state_set(PRES_STATE_INIT);
 
@@ -933,10 +1060,82 @@ int audio_datapath_stop(void)
 	}
 }
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+int audio_datapath_pause(void)
+{
+	if (!ctrl_blk.stream_started) {
+		LOG_WRN("Stream not started");
+		return -ECANCELED;
+	}
+
+	if (ctrl_blk.stream_paused) {
+		return -EALREADY;
+	}
+
+	/* I2S keeps running and plays silence once out.fifo has been drained */
+	ctrl_blk.stream_paused = true;
+	ctrl_blk.previous_sdu_ref_valid = false;
+
+	pres_comp_state_set(PRES_STATE_INIT);
+
+	return 0;
+}
+
+int audio_datapath_resume(void)
+{
+	if (!ctrl_blk.stream_paused) {
+		return -EALREADY;
+	}
+
+	/* The APLL center frequency is still valid. Only the I2S offset to the
+	 * SDU reference of the new stream has to be found again
+	 */
+	switch (ctrl_blk.drift_comp.state) {
+	case DRIFT_STATE_LOCKED:
+		drift_comp_state_set(DRIFT_STATE_OFFSET);
+		break;
+	case DRIFT_STATE_OFFSET:
+		ctrl_blk.drift_comp.ctr = 0;
+		break;
+	case DRIFT_STATE_CALIB:
+		/* Calibration was measured against the previous stream */
+		drift_comp_state_set(DRIFT_STATE_INIT);
+		break;
+	default:
+		break;
+	}
+
+	ctrl_blk.stream_paused = false;
+
+	return 0;
+}
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
+void audio_datapath_ttfa_start(bool warm)
+{
+	ctrl_blk.ttfa.start_cyc = k_cycle_get_32();
+	ctrl_blk.ttfa.warm = warm;
+	ctrl_blk.ttfa.state = TTFA_STATE_WAIT_FRAME;
+}
+
 int audio_datapath_init(void)
 {
 	memset(&ctrl_blk, 0, sizeof(ctrl_blk));
 	audio_i2s_blk_comp_cb_register(audio_datapath_i2s_blk_complete);
+#if (CONFIG_I2S_TDM_EMULATION)
+	audio_i2s_tdm_rx_cb_register(audio_datapath_i2s_tdm_rx);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
+#if (CONFIG_PROMPT_MIXER)
+	int ret;
+
+	ret = prompt_mixer_init();
+	if (ret) {
+		LOG_ERR("Prompt mixer init failed: %d", ret);
+		return ret;
+	}
+#endif /* (CONFIG_PROMPT_MIXER) */
+
 	ctrl_blk.datapath_initialized = true;
 	ctrl_blk.drift_comp.hfclkaudio_comp_enabled = true;
 	ctrl_blk.pres_comp.pres_delay_us = DEFAULT_PRES_DLY_US;
@@ -51,6 +51,9 @@
 
 #include "data_fifo.h"
 #include "sw_codec_select.h"
+#if (CONFIG_I2S_TDM_EMULATION)
+#include "audio_i2s.h"
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
 
 /* Presentation delay defines in microseconds */
 /* Allow some buffer time to allow for HCI Transport etc */
@@ -103,6 +106,17 @@ void audio_datapath_pres_delay_us_get(uint32_t *delay_us);
  */
 void audio_datapath_just_in_time_check_and_adjust(uint32_t sdu_ref_us);
 
+/**
+ * @brief Set the I2S block phase that drift compensation locks to
+ *
+ * @note Drift compensation aligns the start of each I2S block with
+ *       sdu_ref_us + offset_us, modulo the block period. Change in small steps
+ *       to keep drift compensation locked
+ *
+ * @param offset_us Phase offset in microseconds
+ */
+void audio_datapath_i2s_phase_offset_set(uint32_t offset_us);
+
 /**
  * @brief Update sdu_ref_us so that drift compensation can work correctly
  *
@@ -129,6 +143,19 @@ void audio_datapath_sdu_ref_update(uint32_t sdu_ref_us);
 void audio_datapath_stream_out(const uint8_t *buf, size_t size, uint32_t sdu_ref_us, bool bad_frame,
 			       uint32_t recv_frame_ts_us);
 
+#if (CONFIG_I2S_TDM_EMULATION)
+/**
+ * @brief Register a consumer of every received TDM slot
+ *
+ * @note The stereo RX path only carries the two routed slots. The consumer is
+ *	 called from the I2S interrupt with each block of all slots, as long as
+ *	 the datapath is started. Register NULL to remove it
+ *
+ * @param tdm_rx_callback Callback function
+ */
+void audio_datapath_tdm_rx_cb_register(i2s_tdm_rx_callback_t tdm_rx_callback);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 /**
  * @brief Start the audio datapath module
  *
@@ -147,6 +174,36 @@ int audio_datapath_start(struct data_fifo *fifo_rx);
  */
 int audio_datapath_stop(void);
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+/**
+ * @brief Pause the audio datapath while keeping I2S and the APLL running
+ *
+ * @note Drift compensation holds the current APLL frequency until resumed
+ *
+ * @return 0 if successful, error otherwise
+ */
+int audio_datapath_pause(void);
+
+/**
+ * @brief Resume a paused audio datapath
+ *
+ * @note Drift compensation skips calibration if it was locked before the pause
+ *
+ * @return 0 if successful, -EALREADY if not paused
+ */
+int audio_datapath_resume(void);
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
+/**
+ * @brief Start measuring time to first audio
+ *
+ * @note The measurement ends when the first frame decoded after this call
+ *       is played out over I2S, and the result is logged
+ *
+ * @param warm True if the audio system is resumed from a warm pause
+ */
+void audio_datapath_ttfa_start(bool warm);
+
 /**
  * @brief Initialize the audio datapath module
  *
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "audio_proc.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+#include <zephyr/timing/timing.h>
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(audio_proc, CONFIG_LOG_AUDIO_PROC_LEVEL);
+
+static const char *const stage_names[] = {
+	"FRAME",
+	"BLOCK",
+};
+
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+static void node_stats_update(struct audio_proc_node_data *data, timing_t *start, timing_t *end)
+{
+	uint32_t cycles = (uint32_t)timing_cycles_get(start, end);
+
+	data->calls++;
+	data->cycles_total += cycles;
+	data->cycles_max = MAX(data->cycles_max, cycles);
+}
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+
+void audio_proc_run(enum audio_proc_stage stage, void *const pcm, size_t size)
+{
+	STRUCT_SECTION_FOREACH(audio_proc_node, node)
+	{
+		if (node->stage != stage || node->data->bypass) {
+			continue;
+		}
+
+		if (node->active != NULL && !node->active()) {
+			continue;
+		}
+
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+		timing_t start = timing_counter_get();
+
+		node->process(pcm, size);
+
+		timing_t end = timing_counter_get();
+
+		node_stats_update(node->data, &start, &end);
+#else
+		node->process(pcm, size);
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+	}
+}
+
+int audio_proc_bypass_set(const char *name, bool bypass)
+{
+	STRUCT_SECTION_FOREACH(audio_proc_node, node)
+	{
+		if (strcmp(node->name, name) == 0) {
+			node->data->bypass = bypass;
+			LOG_DBG("Node %s %s", node->name, bypass ? "bypassed" : "enabled");
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+static int audio_proc_init(const struct device *unused)
+{
+	ARG_UNUSED(unused);
+
+	timing_init();
+	timing_start();
+
+	return 0;
+}
+
+SYS_INIT(audio_proc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+
+static int cmd_audio_proc_list(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	STRUCT_SECTION_FOREACH(audio_proc_node, node)
+	{
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+		struct audio_proc_node_data *data = node->data;
+		uint32_t cycles_avg = data->calls ? (data->cycles_total / data->calls) : 0;
+
+		shell_print(shell, "%-16s %-5s %-6s calls: %u avg: %u ns max: %u ns", node->name,
+			    stage_names[node->stage], data->bypass ? "BYPASS" : "ON", data->calls,
+			    (uint32_t)timing_cycles_to_ns(cycles_avg),
+			    (uint32_t)timing_cycles_to_ns(data->cycles_max));
+#else
+		shell_print(shell, "%-16s %-5s %-6s", node->name, stage_names[node->stage],
+			    node->data->bypass ? "BYPASS" : "ON");
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+	}
+
+	return 0;
+}
+
+static int cmd_audio_proc_bypass(const struct shell *shell, size_t argc, const char **argv,
+				 bool bypass)
+{
+	int ret;
+
+	if (argc != 2) {
+		shell_error(shell, "Node name must be provided");
+		return -EINVAL;
+	}
+
+	ret = audio_proc_bypass_set(argv[1], bypass);
+	if (ret) {
+		shell_error(shell, "Node %s not found", argv[1]);
+		return ret;
+	}
+
+	shell_print(shell, "Node %s %s", argv[1], bypass ? "bypassed" : "enabled");
+
+	return 0;
+}
+
+static int cmd_audio_proc_bypass_on(const struct shell *shell, size_t argc, const char **argv)
+{
+	return cmd_audio_proc_bypass(shell, argc, argv, true);
+}
+
+static int cmd_audio_proc_bypass_off(const struct shell *shell, size_t argc, const char **argv)
+{
+	return cmd_audio_proc_bypass(shell, argc, argv, false);
+}
+
+static int cmd_audio_proc_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	STRUCT_SECTION_FOREACH(audio_proc_node, node)
+	{
+		bool bypass = node->data->bypass;
+
+		memset(node->data, 0, sizeof(*node->data));
+		node->data->bypass = bypass;
+	}
+
+	shell_print(shell, "Node statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(audio_proc_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, list, NULL,
+					      "List processing nodes and statistics",
+					      cmd_audio_proc_list),
+			       SHELL_COND_CMD(CONFIG_SHELL, bypass, NULL, "Bypass node: name",
+					      cmd_audio_proc_bypass_on),
+			       SHELL_COND_CMD(CONFIG_SHELL, enable, NULL, "Re-enable node: name",
+					      cmd_audio_proc_bypass_off),
+			       SHELL_COND_CMD(CONFIG_AUDIO_PROC_CYCLE_STATS, stats_reset, NULL,
+					      "Reset node statistics", cmd_audio_proc_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(audio_proc, &audio_proc_cmd, "Audio processing graph commands", NULL);
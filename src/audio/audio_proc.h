@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AUDIO_PROC_H_
+#define _AUDIO_PROC_H_
+
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Static audio processing graph
+ *
+ * Processing nodes are registered at compile-time in an iterable section and
+ * run in the order given by their priority. A node which is compiled out costs
+ * nothing, as it is simply not in the section. Each node is run on one of the
+ * stages below.
+ */
+enum audio_proc_stage {
+	/* Decoded frame (stereo), run in thread context before it is put in the output FIFO */
+	AUDIO_PROC_STAGE_FRAME,
+	/* 1 ms stereo block, run in the I2S ISR just before it is handed to I2S TX */
+	AUDIO_PROC_STAGE_BLOCK,
+};
+
+/* Run-time data for a node */
+struct audio_proc_node_data {
+	bool bypass;
+#if (CONFIG_AUDIO_PROC_CYCLE_STATS)
+	uint32_t calls;
+	uint64_t cycles_total;
+	uint32_t cycles_max;
+#endif /* (CONFIG_AUDIO_PROC_CYCLE_STATS) */
+};
+
+struct audio_proc_node {
+	const char *name;
+	enum audio_proc_stage stage;
+	/* Optional. Return false to skip the node for this frame/block */
+	bool (*active)(void);
+	/* Process interleaved stereo PCM in place */
+	void (*process)(void *const pcm, size_t size);
+	struct audio_proc_node_data *data;
+};
+
+/**
+ * @brief Register an audio processing node
+ *
+ * @note Nodes are sorted by section name, hence _prio must be a two digit
+ *       literal (e.g. 10). Lower value runs first
+ *
+ * @param _name		Node name, must be a valid C identifier
+ * @param _prio		Two digit run order
+ * @param _stage	enum audio_proc_stage
+ * @param _active	Function to check if the node has work to do, or NULL
+ * @param _process	Process function
+ */
+#define AUDIO_PROC_NODE_DEFINE(_name, _prio, _stage, _active, _process)                           \
+	static struct audio_proc_node_data _audio_proc_node_data_##_name;                          \
+	const STRUCT_SECTION_ITERABLE(audio_proc_node, _audio_proc_node_##_prio##_##_name) = {     \
+		.name = #_name,                                                                    \
+		.stage = _stage,                                                                   \
+		.active = _active,                                                                 \
+		.process = _process,                                                               \
+		.data = &_audio_proc_node_data_##_name,                                            \
+	}
+
+/**
+ * @brief Run all nodes of a processing stage
+ *
+ * @param stage	Processing stage
+ * @param pcm	[in/out] Interleaved stereo PCM
+ * @param size	Size of PCM in bytes
+ */
+void audio_proc_run(enum audio_proc_stage stage, void *const pcm, size_t size);
+
+/**
+ * @brief Bypass or re-enable a node
+ *
+ * @param name		Name of node
+ * @param bypass	true to bypass node
+ *
+ * @return 0 if successful, -ENOENT if node is not found
+ */
+int audio_proc_bypass_set(const char *name, bool bypass);
+
+#endif /* _AUDIO_PROC_H_ */
@@ -56,6 +56,9 @@
 LOG_MODULE_REGISTER(audio_sync_timer, CONFIG_LOG_AUDIO_SYNC_TIMER_LEVEL);
 
 #define AUDIO_SYNC_TIMER_INSTANCE 1
+/* Counts the IPC events which clear the sync timer */
+#define AUDIO_SYNC_TIMER_CLEAR_COUNTER_INSTANCE 2
+#define AUDIO_SYNC_TIMER_CLEAR_COUNTER_CAPTURE_CHANNEL 0
 
 #define AUDIO_SYNC_TIMER_I2S_FRAME_START_EVT_CAPTURE_CHANNEL 0
 #define AUDIO_SYNC_TIMER_CURR_TIME_CAPTURE_CHANNEL 1
@@ -65,6 +68,8 @@ LOG_MODULE_REGISTER(audio_sync_timer, CONFIG_LOG_AUDIO_SYNC_TIMER_LEVEL);
 #define AUDIO_SYNC_TIMER_NET_APP_IPC_EVT NRF_IPC_EVENT_RECEIVE_4
 
 static const nrfx_timer_t timer_instance = NRFX_TIMER_INSTANCE(AUDIO_SYNC_TIMER_INSTANCE);
+static const nrfx_timer_t clear_counter_instance =
+	NRFX_TIMER_INSTANCE(AUDIO_SYNC_TIMER_CLEAR_COUNTER_INSTANCE);
 
 static uint8_t dppi_channel_timer_clear;
 static uint8_t dppi_channel_i2s_frame_start;
@@ -75,10 +80,57 @@ static nrfx_timer_config_t cfg = { .frequency = NRF_TIMER_FREQ_1MHz,
 				   .interrupt_priority = NRFX_TIMER_DEFAULT_CONFIG_IRQ_PRIORITY,
 				   .p_context = NULL };
 
+static nrfx_timer_config_t clear_counter_cfg = {
+	.frequency = NRF_TIMER_FREQ_1MHz,
+	.mode = NRF_TIMER_MODE_LOW_POWER_COUNTER,
+	.bit_width = NRF_TIMER_BIT_WIDTH_32,
+	.interrupt_priority = NRFX_TIMER_DEFAULT_CONFIG_IRQ_PRIORITY,
+	.p_context = NULL
+};
+
+/* The 32 bit timer must be read at least this often to count its wraps */
+#define EXT_REFRESH_PERIOD K_MINUTES(10)
+
+static struct audio_sync_timer_ext ext;
+
+static struct k_spinlock ext_lock;
+
 static void event_handler(nrf_timer_event_t event_type, void *ctx)
 {
 }
 
+/* Read the timer and extend it to 64 bit. The 32 bit value is returned in now */
+static uint64_t ext_read(uint32_t *now)
+{
+	uint32_t clears;
+	k_spinlock_key_t key = k_spin_lock(&ext_lock);
+
+	/* The clear count must belong to the timer value, retry if a clear came in between */
+	do {
+		clears = nrfx_timer_capture(&clear_counter_instance,
+					    AUDIO_SYNC_TIMER_CLEAR_COUNTER_CAPTURE_CHANNEL);
+		*now = nrfx_timer_capture(&timer_instance,
+					  AUDIO_SYNC_TIMER_CURR_TIME_CAPTURE_CHANNEL);
+	} while (clears != nrfx_timer_capture(&clear_counter_instance,
+					      AUDIO_SYNC_TIMER_CLEAR_COUNTER_CAPTURE_CHANNEL));
+
+	uint64_t now64 = audio_sync_timer_ext_update(&ext, *now, clears,
+						     k_ticks_to_us_floor64(k_uptime_ticks()));
+
+	k_spin_unlock(&ext_lock, key);
+
+	return now64;
+}
+
+static void ext_refresh(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+
+	(void)audio_sync_timer_curr_time_get();
+}
+
+K_TIMER_DEFINE(ext_refresh_timer, ext_refresh, NULL);
+
 /**
  * @brief Initialize audio sync timer
  *
@@ -130,12 +182,25 @@ static int audio_sync_timer_init(const struct device *unused)
 	nrf_ipc_publish_set(NRF_IPC, AUDIO_SYNC_TIMER_NET_APP_IPC_EVT, dppi_channel_timer_clear);
 	nrf_timer_subscribe_set(timer_instance.p_reg, NRF_TIMER_TASK_CLEAR,
 				dppi_channel_timer_clear);
+
+	/* Count the clears, so that the 64 bit timebase does not have to guess them */
+	ret = nrfx_timer_init(&clear_counter_instance, &clear_counter_cfg, event_handler);
+	if (ret - NRFX_ERROR_BASE_NUM) {
+		LOG_ERR("nrfx timer init error (clear counter) - Return value: %d", ret);
+		return ret;
+	}
+	nrfx_timer_enable(&clear_counter_instance);
+	nrf_timer_subscribe_set(clear_counter_instance.p_reg, NRF_TIMER_TASK_COUNT,
+				dppi_channel_timer_clear);
+
 	ret = nrfx_dppi_channel_enable(dppi_channel_timer_clear);
 	if (ret - NRFX_ERROR_BASE_NUM) {
 		LOG_ERR("nrfx DPPI channel enable error (timer clear) - Return value: %d", ret);
 		return ret;
 	}
 
+	k_timer_start(&ext_refresh_timer, EXT_REFRESH_PERIOD, EXT_REFRESH_PERIOD);
+
 	LOG_INF("Audio sync timer initialized");
 
 	return 0;
@@ -149,7 +214,26 @@ uint32_t audio_sync_timer_i2s_frame_start_ts_get(void)
 
 uint32_t audio_sync_timer_curr_time_get(void)
 {
-	return nrfx_timer_capture(&timer_instance, AUDIO_SYNC_TIMER_CURR_TIME_CAPTURE_CHANNEL);
+	uint32_t now;
+
+	(void)ext_read(&now);
+
+	return now;
+}
+
+uint64_t audio_sync_timer_curr_time_get64(void)
+{
+	uint32_t now;
+
+	return ext_read(&now);
+}
+
+uint64_t audio_sync_timer_ts_extend(uint32_t ts_us)
+{
+	uint32_t now;
+	uint64_t now64 = ext_read(&now);
+
+	return now64 + audio_sync_timer_diff_us(ts_us, now);
 }
 
 SYS_INIT(audio_sync_timer_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -46,6 +46,108 @@
 #define _AUDIO_SYNC_TIMER_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The sync timer is a 32 bit 1 MHz counter, which wraps about every 71
+ * minutes. 32 bit timestamps must only be compared through the helpers
+ * below, which are correct across the wrap as long as the timestamps are
+ * less than 2^31 us (about 35 minutes) apart.
+ */
+
+/**
+ * @brief Get the signed difference between two 32 bit timestamps
+ *
+ * @param a	Timestamp
+ * @param b	Timestamp to subtract
+ *
+ * @return a - b in us, negative if a is before b
+ */
+static inline int32_t audio_sync_timer_diff_us(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b);
+}
+
+/**
+ * @brief Check if a 32 bit timestamp is after another one
+ *
+ * @param a	Timestamp
+ * @param b	Timestamp to compare to
+ *
+ * @return true if a is after b
+ */
+static inline bool audio_sync_timer_is_after(uint32_t a, uint32_t b)
+{
+	return audio_sync_timer_diff_us(a, b) > 0;
+}
+
+/**
+ * @brief Get the phase of the difference between two timestamps
+ *
+ * @param a		Timestamp
+ * @param b		Timestamp to subtract
+ * @param period_us	Period to take the phase in
+ *
+ * @return (a - b) modulo period_us, in the range [-period_us / 2, period_us / 2)
+ */
+static inline int32_t audio_sync_timer_phase_us(uint32_t a, uint32_t b, uint32_t period_us)
+{
+	int32_t phase_us = audio_sync_timer_diff_us(a, b) % (int32_t)period_us;
+
+	if (phase_us >= (int32_t)(period_us / 2)) {
+		phase_us -= period_us;
+	} else if (phase_us < -(int32_t)(period_us / 2)) {
+		phase_us += period_us;
+	}
+
+	return phase_us;
+}
+
+/* State of the 64 bit extension of the sync timer */
+struct audio_sync_timer_ext {
+	/* 64 bit time of the 32 bit timer being zero */
+	uint64_t base;
+	uint32_t last;
+	/* Clears of the timer by the NET core, as counted at the last read */
+	uint32_t clears;
+	/* Reference clock at the last read, in us */
+	uint64_t last_ref_us;
+};
+
+/**
+ * @brief Extend a read of the 32 bit timer to the 64 bit timebase
+ *
+ * @note Without a clear since the last read, a lower value is a wrap. The
+ *	 timer must be read more often than it wraps. After a clear, the time
+ *	 elapsed since the last read is taken from the reference clock, so the
+ *	 timebase keeps running through the clear
+ *
+ * @param ext		Extension state
+ * @param now		Timer value
+ * @param clears	Number of clears by the NET core, read together with now
+ * @param ref_us	Reference clock which is not cleared, e.g. the kernel uptime
+ *
+ * @return Time on the 64 bit timebase in us
+ */
+static inline uint64_t audio_sync_timer_ext_update(struct audio_sync_timer_ext *ext,
+						   uint32_t now, uint32_t clears, uint64_t ref_us)
+{
+	if (clears != ext->clears) {
+		/* The clear was at least now us ago, at most since the last read */
+		uint64_t elapsed_us = ref_us - ext->last_ref_us;
+		uint64_t now64 = ext->base + ext->last + (elapsed_us > now ? elapsed_us : now);
+
+		ext->base = now64 - now;
+		ext->clears = clears;
+	} else if (now < ext->last) {
+		ext->base += (1ULL << 32);
+	}
+
+	ext->last = now;
+	ext->last_ref_us = ref_us;
+
+	return ext->base + now;
+}
 
 /**
  * @brief Get the I2S TX timestamp
@@ -61,4 +163,27 @@ uint32_t audio_sync_timer_i2s_frame_start_ts_get(void);
  */
 uint32_t audio_sync_timer_curr_time_get(void);
 
+/**
+ * @brief Get the current time on the 64 bit extended timebase
+ *
+ * @note The timebase is monotonic. Wraps of the 32 bit timer are counted.
+ *	 Clears by the NET core are counted in hardware from the IPC event,
+ *	 and the timebase runs on through them, see audio_sync_timer_ext_update
+ *
+ * @return Time in us
+ */
+uint64_t audio_sync_timer_curr_time_get64(void);
+
+/**
+ * @brief Extend a 32 bit timestamp to the 64 bit timebase
+ *
+ * @note The timestamp must be less than 2^31 us from now. This also
+ *	 extends timestamps from the NET core, e.g. sdu_ref
+ *
+ * @param ts_us 32 bit timestamp
+ *
+ * @return Timestamp on the 64 bit timebase
+ */
+uint64_t audio_sync_timer_ts_extend(uint32_t ts_us);
+
 #endif /* _AUDIO_SYNC_TIMER_H_ */
@@ -19,7 +19,13 @@
 #include "contin_array.h"
 #include "pcm_stream_channel_modifier.h"
 #include "audio_usb.h"
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+#include "audio_usb_out.h"
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
 #include "streamctrl.h"
+#if (CONFIG_BCAST_PROGRAMS)
+#include "bcast_programs.h"
+#endif /* (CONFIG_BCAST_PROGRAMS) */
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(audio_system, CONFIG_LOG_AUDIO_SYSTEM_LEVEL);
@@ -32,7 +38,15 @@ LOG_MODULE_REGISTER(audio_system, CONFIG_LOG_AUDIO_SYSTEM_LEVEL);
 K_THREAD_STACK_DEFINE(encoder_thread_stack, CONFIG_ENCODER_STACK_SIZE);
 
 DATA_FIFO_DEFINE(fifo_tx, FIFO_TX_BLOCK_COUNT, WB_UP(BLOCK_SIZE_BYTES));
+#if (CONFIG_FIFO_RX_SPSC)
+/* The encoder reads one frame in place. Two frames needed since I2S holds two blocks */
+BUILD_ASSERT(FIFO_RX_BLOCK_COUNT >= (2 * CONFIG_FIFO_FRAME_SPLIT_NUM),
+	     "FIFO_RX must hold at least two frames in SPSC mode");
+DATA_FIFO_SPSC_SPAN_DEFINE(fifo_rx, FIFO_RX_BLOCK_COUNT, WB_UP(BLOCK_SIZE_BYTES),
+			   CONFIG_FIFO_FRAME_SPLIT_NUM);
+#else
 DATA_FIFO_DEFINE(fifo_rx, FIFO_RX_BLOCK_COUNT, WB_UP(BLOCK_SIZE_BYTES));
+#endif /* (CONFIG_FIFO_RX_SPSC) */
 
 static struct k_thread encoder_thread_data;
 static k_tid_t encoder_thread_id;
@@ -88,6 +102,76 @@ static void audio_headset_configure(void)
 	sw_codec_cfg.decoder.enabled = true;
 }
 
+#if (CONFIG_ENCODE_TO_TX_BUF)
+/* Encoder output of channels without a reserved TX buffer. The output is
+ * discarded, so all channels share one buffer
+ */
+static uint8_t encoded_data_discard[ENC_MAX_FRAME_SIZE];
+
+/* Reserve TX buffers for all channels. Returns true if buffers are reserved */
+static bool tx_bufs_reserve(uint8_t *encoded_data[AUDIO_CH_NUM])
+{
+	int ret;
+	bool reserved;
+
+	ret = streamctrl_tx_bufs_alloc(encoded_data, AUDIO_CH_NUM);
+	reserved = (ret == 0);
+
+	/* The encoder runs for all channels to keep its state continuous */
+	for (int i = 0; i < AUDIO_CH_NUM; i++) {
+		if (!reserved || encoded_data[i] == NULL) {
+			encoded_data[i] = encoded_data_discard;
+		}
+	}
+
+	return reserved;
+}
+
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+/* Encode a frame already split per channel directly into the TX buffers */
+static bool encode_mono_to_tx_bufs(void *pcm_data_mono[AUDIO_CH_NUM], size_t pcm_size_mono,
+				   size_t *encoded_size)
+{
+	int ret;
+	uint8_t *encoded_data[AUDIO_CH_NUM];
+	bool reserved = tx_bufs_reserve(encoded_data);
+
+	ret = sw_codec_encode_mono_to(pcm_data_mono, pcm_size_mono, encoded_data,
+				      sizeof(encoded_data_discard), encoded_size);
+	if (ret && reserved) {
+		streamctrl_tx_bufs_free();
+	}
+
+	ERR_CHK_MSG(ret, "Encode failed");
+
+	return reserved;
+}
+#else
+/* Encode directly into the TX buffers. Returns true if buffers are reserved */
+static bool encode_to_tx_bufs(void *pcm_data, size_t *encoded_size)
+{
+	int ret;
+	uint8_t *encoded_data[AUDIO_CH_NUM];
+	bool reserved = tx_bufs_reserve(encoded_data);
+
+#if (CONFIG_BCAST_PROGRAMS)
+	ret = bcast_programs_encode(pcm_data, FRAME_SIZE_BYTES, encoded_data,
+				    sizeof(encoded_data_discard), encoded_size);
+#else
+	ret = sw_codec_encode_to(pcm_data, FRAME_SIZE_BYTES, encoded_data,
+				 sizeof(encoded_data_discard), encoded_size);
+#endif /* (CONFIG_BCAST_PROGRAMS) */
+	if (ret && reserved) {
+		streamctrl_tx_bufs_free();
+	}
+
+	ERR_CHK_MSG(ret, "Encode failed");
+
+	return reserved;
+}
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
+
 static void encoder_thread(void *arg1, void *arg2, void *arg3)
 {
 	int ret;
@@ -97,15 +181,53 @@ static void encoder_thread(void *arg1, void *arg2, void *arg3)
 	int debug_trans_count = 0;
 	size_t encoded_data_size = 0;
 
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+#elif (CONFIG_FIFO_RX_SPSC)
+	char *pcm_raw_data;
+	size_t pcm_size;
+#else
+	char *pcm_raw_data;
 	void *tmp_pcm_raw_data[CONFIG_FIFO_FRAME_SPLIT_NUM];
-	char pcm_raw_data[FRAME_SIZE_BYTES];
+	char pcm_raw_data_buf[FRAME_SIZE_BYTES];
+	static size_t pcm_block_size;
 
+	pcm_raw_data = pcm_raw_data_buf;
+#endif /* (CONFIG_FIFO_RX_SPSC) */
+
+#if (CONFIG_ENCODE_TO_TX_BUF)
+	bool tx_bufs_reserved = false;
+#else
 	static uint8_t *encoded_data;
-	static size_t pcm_block_size;
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
 	static uint32_t test_tone_finite_pos;
 
 	while (1) {
 		/* Get PCM data from I2S */
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+		/* USB has already split the frame per channel */
+		ret = audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_FOREVER);
+		if (ret == -EAGAIN) {
+			/* Stream stopped, frames dropped by audio_usb_stop */
+			continue;
+		}
+
+		ERR_CHK(ret);
+#elif (CONFIG_FIFO_RX_SPSC)
+		/* All blocks of one audio frame are fetched as one
+		 * contiguous span, so the encoder reads them in place
+		 */
+		ret = data_fifo_span_get(&fifo_rx, (void **)&pcm_raw_data, &pcm_size,
+					 CONFIG_FIFO_FRAME_SPLIT_NUM, K_FOREVER);
+		if (ret == -ECANCELED) {
+			/* Stream stopped, fifo_rx emptied by audio_system_stop */
+			continue;
+		}
+
+		ERR_CHK(ret);
+		__ASSERT_NO_MSG(pcm_size >= FRAME_SIZE_BYTES);
+#else
 		/* Since one audio frame is divided into a number of
 		 * blocks, we need to fetch the pointers to all of these
 		 * blocks before copying it to a continuous area of memory
@@ -121,10 +243,20 @@ static void encoder_thread(void *arg1, void *arg2, void *arg3)
 			ret = data_fifo_block_free(&fifo_rx, &tmp_pcm_raw_data[i]);
 			ERR_CHK(ret);
 		}
+#endif /* (CONFIG_FIFO_RX_SPSC) */
 
 		if (sw_codec_cfg.encoder.enabled) {
 			if (test_tone_size) {
 				/* Test tone takes over audio stream */
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+				ret = contin_array_create(pcm_data_mono[AUDIO_CH_L], pcm_size_mono,
+							  test_tone_buf, test_tone_size,
+							  &test_tone_finite_pos);
+				ERR_CHK(ret);
+
+				memcpy(pcm_data_mono[AUDIO_CH_R], pcm_data_mono[AUDIO_CH_L],
+				       pcm_size_mono);
+#else
 				uint32_t num_bytes;
 				char tmp[FRAME_SIZE_BYTES / 2];
 
@@ -136,14 +268,30 @@ static void encoder_thread(void *arg1, void *arg2, void *arg3)
 						    CONFIG_AUDIO_BIT_DEPTH_BITS, pcm_raw_data,
 						    &num_bytes);
 				ERR_CHK(ret);
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
 			}
 
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+			tx_bufs_reserved = encode_mono_to_tx_bufs(pcm_data_mono, pcm_size_mono,
+								  &encoded_data_size);
+#elif (CONFIG_ENCODE_TO_TX_BUF)
+			tx_bufs_reserved = encode_to_tx_bufs(pcm_raw_data, &encoded_data_size);
+#else
 			ret = sw_codec_encode(pcm_raw_data, FRAME_SIZE_BYTES, &encoded_data,
 					      &encoded_data_size);
 
 			ERR_CHK_MSG(ret, "Encode failed");
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
 		}
 
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+		audio_usb_out_frame_free();
+#elif (CONFIG_FIFO_RX_SPSC)
+		ret = data_fifo_span_free(&fifo_rx, (void **)&pcm_raw_data,
+					  CONFIG_FIFO_FRAME_SPLIT_NUM);
+		ERR_CHK(ret);
+#endif /* (CONFIG_FIFO_RX_SPSC) */
+
 		/* Print block usage */
 		if (debug_trans_count == DEBUG_INTERVAL_NUM) {
 			ret = data_fifo_num_used_get(&fifo_rx, &blocks_alloced_num,
@@ -156,10 +304,17 @@ static void encoder_thread(void *arg1, void *arg2, void *arg3)
 			debug_trans_count++;
 		}
 
+#if (CONFIG_ENCODE_TO_TX_BUF)
+		if (tx_bufs_reserved) {
+			streamctrl_tx_bufs_send(encoded_data_size);
+			tx_bufs_reserved = false;
+		}
+#else
 		if (sw_codec_cfg.encoder.enabled) {
 			/* Send encoded data over IPM */
 			streamctrl_encoded_data_send(encoded_data, encoded_data_size);
 		}
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
 		STACK_USAGE_PRINT("encoder_thread", &encoder_thread_data);
 	}
 }
@@ -186,13 +341,11 @@ int audio_encode_test_tone_set(uint32_t freq)
 /* This function is only used on gateway using USB as audio source and bidirectional stream */
 int audio_decode(void const *const encoded_data, size_t encoded_data_size, bool bad_frame)
 {
+#if ((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_STREAM_BIDIRECTIONAL))
 	int ret;
-	uint32_t blocks_alloced_num;
-	uint32_t blocks_locked_num;
-	static int debug_trans_count;
-	static void *tmp_pcm_raw_data[CONFIG_FIFO_FRAME_SPLIT_NUM];
-	static void *pcm_raw_data;
-	size_t pcm_block_size;
+	void *pcm_frame;
+	size_t pcm_frame_size_max;
+	size_t pcm_size;
 
 	if (!sw_codec_cfg.initialized) {
 		/* Throw away data */
@@ -203,71 +356,49 @@ int audio_decode(void const *const encoded_data, size_t encoded_data_size, bool
 		return -EPERM;
 	}
 
-	ret = data_fifo_num_used_get(&fifo_tx, &blocks_alloced_num, &blocks_locked_num);
+	ret = audio_usb_in_frame_get(&pcm_frame, &pcm_frame_size_max);
 	if (ret) {
 		return ret;
 	}
 
-	uint8_t free_blocks_num = FIFO_TX_BLOCK_COUNT - blocks_locked_num;
-
-	/* If not enough space for a full frame, remove oldest samples to make room */
-	if (free_blocks_num < CONFIG_FIFO_FRAME_SPLIT_NUM) {
-		void *old_data;
-		size_t size;
-
-		for (int i = 0; i < (CONFIG_FIFO_FRAME_SPLIT_NUM - free_blocks_num); i++) {
-			ret = data_fifo_pointer_last_filled_get(&fifo_tx, &old_data, &size,
-								K_NO_WAIT);
-			if (ret == -ENOMSG) {
-				/* If there are no more blocks in FIFO, break */
-				break;
-			}
-			ret = data_fifo_block_free(&fifo_tx, &old_data);
-			if (ret) {
-				return ret;
-			}
-		}
-	}
-
-	for (int i = 0; i < CONFIG_FIFO_FRAME_SPLIT_NUM; i++) {
-		ret = data_fifo_pointer_first_vacant_get(&fifo_tx, &tmp_pcm_raw_data[i], K_FOREVER);
-		if (ret) {
-			return ret;
-		}
-	}
-
-	ret = sw_codec_decode(encoded_data, encoded_data_size, bad_frame, &pcm_raw_data,
-			      &pcm_block_size);
+	/* Decode straight into the USB return path */
+	ret = sw_codec_decode_to(encoded_data, encoded_data_size, bad_frame, pcm_frame,
+				 pcm_frame_size_max, &pcm_size);
 	if (ret) {
 		LOG_ERR("Failed to decode");
 		return ret;
 	}
 
-	/* Split decoded frame into CONFIG_FIFO_FRAME_SPLIT_NUM blocks */
-	for (int i = 0; i < CONFIG_FIFO_FRAME_SPLIT_NUM; i++) {
-		memcpy(tmp_pcm_raw_data[i], (char *)pcm_raw_data + (i * (BLOCK_SIZE_BYTES)),
-		       BLOCK_SIZE_BYTES);
+	return audio_usb_in_frame_commit(pcm_frame, pcm_size);
+#else
+	ARG_UNUSED(encoded_data);
+	ARG_UNUSED(encoded_data_size);
+	ARG_UNUSED(bad_frame);
 
-		ret = data_fifo_block_lock(&fifo_tx, &tmp_pcm_raw_data[i], BLOCK_SIZE_BYTES);
-		if (ret) {
-			LOG_ERR("Failed to lock block");
-			return ret;
-		}
-	}
-	if (debug_trans_count == DEBUG_INTERVAL_NUM) {
-		ret = data_fifo_num_used_get(&fifo_tx, &blocks_alloced_num, &blocks_locked_num);
-		if (ret) {
-			return ret;
-		}
-		LOG_DBG(COLOR_MAGENTA "TX alloced: %d, locked: %d" COLOR_RESET, blocks_alloced_num,
-			blocks_locked_num);
-		debug_trans_count = 0;
-	} else {
-		debug_trans_count++;
-	}
+	return -ENOTSUP;
+#endif /* ((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_STREAM_BIDIRECTIONAL)) */
+}
 
-	return 0;
+#if (CONFIG_AUDIO_WARM_PAUSE)
+/* Codec, I2S and APLL are kept running while paused */
+static bool warm_paused;
+
+static void audio_system_resume(void)
+{
+	LOG_DBG("Resuming from warm pause");
+
+#if !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY))
+	int ret;
+
+	audio_datapath_ttfa_start(true);
+
+	ret = audio_datapath_resume();
+	ERR_CHK(ret);
+#endif /* !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY)) */
+
+	warm_paused = false;
 }
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
 
 /**@brief Initializes the FIFOs, the codec, and starts the I2S
  */
@@ -275,6 +406,17 @@ void audio_system_start(void)
 {
 	int ret;
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+	if (warm_paused) {
+		audio_system_resume();
+		return;
+	}
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
+#if !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY))
+	audio_datapath_ttfa_start(false);
+#endif /* !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY)) */
+
 	if (CONFIG_AUDIO_DEV == HEADSET) {
 		audio_headset_configure();
 	} else if (CONFIG_AUDIO_DEV == GATEWAY) {
@@ -310,7 +452,7 @@ void audio_system_start(void)
 	}
 
 #if ((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY))
-	ret = audio_usb_start(&fifo_tx, &fifo_rx);
+	ret = audio_usb_start(&fifo_rx);
 	ERR_CHK(ret);
 #else
 	ret = hw_codec_default_conf_enable();
@@ -330,6 +472,10 @@ void audio_system_stop(void)
 		return;
 	}
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+	warm_paused = false;
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
 	LOG_DBG("Stopping codec");
 
 #if ((CONFIG_AUDIO_DEV == GATEWAY) && CONFIG_AUDIO_SOURCE_USB)
@@ -350,6 +496,34 @@ void audio_system_stop(void)
 	data_fifo_empty(&fifo_tx);
 }
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+void audio_system_pause(void)
+{
+	if (!sw_codec_cfg.initialized) {
+		LOG_WRN("Codec not initialized");
+		return;
+	}
+
+	if (warm_paused) {
+		return;
+	}
+
+	LOG_DBG("Warm pause");
+
+	/* With USB as source, USB keeps streaming and encoded frames are
+	 * dropped by streamctrl until resumed
+	 */
+#if !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY))
+	int ret;
+
+	ret = audio_datapath_pause();
+	ERR_CHK(ret);
+#endif /* !((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY)) */
+
+	warm_paused = true;
+}
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
 void audio_system_fifo_rx_block_drop(void)
 {
 	int ret;
@@ -23,7 +23,7 @@
 int audio_encode_test_tone_set(uint32_t freq);
 
 /**
- * @brief Decode data and then add it to TX FIFO buffer
+ * @brief Decode data into the USB IN return path
  *
  * @param[in]	encoded_data		Pointer to encoded data
  * @param[in]	encoded_data_size	Size of encoded data
@@ -35,6 +35,8 @@ int audio_decode(void const *const encoded_data, size_t encoded_data_size, bool
 
 /**
  * @brief Initialize and start both HW and SW audio codec
+ *
+ * @note If the audio system is in warm pause, it is resumed instead
  */
 void audio_system_start(void);
 
@@ -43,6 +45,15 @@ void audio_system_start(void);
  */
 void audio_system_stop(void);
 
+#if (CONFIG_AUDIO_WARM_PAUSE)
+/**
+ * @brief Pause audio without stopping the codecs, I2S or the audio clock
+ *
+ * @note Resume with audio_system_start
+ */
+void audio_system_pause(void);
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
 /**
  * @brief Drop oldest block from fifo_rx buffer
  *
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "bcast_programs.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/timing/timing.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sw_codec_select.h"
+#include "channel_assignment.h"
+#include "pcm_stream_channel_modifier.h"
+#include "tone.h"
+#include "contin_array.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(bcast_programs, CONFIG_LOG_BCAST_PROGRAMS_LEVEL);
+
+#define PROGRAM_NUM CONFIG_BT_AUDIO_BROADCAST_SRC_STREAM_COUNT
+
+BUILD_ASSERT(PROGRAM_NUM <= AUDIO_CH_NUM, "Each program needs its own encoder channel");
+
+/* tone_gen supports frequencies down to 100 Hz */
+#define TONE_FREQ_MIN_HZ 100
+#define TONE_FREQ_MAX_HZ 10000
+#define TONE_BUF_SAMPLES (CONFIG_AUDIO_SAMPLE_RATE_HZ / TONE_FREQ_MIN_HZ)
+
+/* The encoder output for silence is stable after this number of frames */
+#define SILENCE_FRAMES_ENCODE 2
+
+/* Encode time estimate for a program which has not been measured yet */
+#define ENC_TIME_EST_NS (ENC_TIME_US * NSEC_PER_USEC / AUDIO_CH_NUM)
+#define CPU_BUDGET_NS                                                                              \
+	(CONFIG_AUDIO_FRAME_DURATION_US * NSEC_PER_USEC / 100 *                                    \
+	 CONFIG_BCAST_PROGRAMS_CPU_BUDGET_PCT)
+
+static const char *const src_names[BCAST_PROGRAM_SRC_NUM] = {
+	"off", "left", "right", "mix", "tone",
+};
+
+struct program_cfg {
+	enum bcast_program_src src;
+	uint16_t tone_hz;
+};
+
+struct program {
+	struct program_cfg cfg;
+	int16_t tone[TONE_BUF_SAMPLES];
+	size_t tone_size;
+	uint32_t tone_pos;
+	/* Encoded silence, reused while the program is off */
+	uint8_t silence[ENC_MAX_FRAME_SIZE];
+	size_t silence_size;
+	uint8_t silence_frames;
+	/* Encode time statistics */
+	uint32_t frames;
+	uint32_t enc_avg_ns;
+	uint32_t enc_max_ns;
+};
+
+static struct program programs[PROGRAM_NUM];
+
+/* Configuration changes are applied by the encoder thread */
+static struct program_cfg pending_cfg[PROGRAM_NUM];
+static atomic_t pending;
+static struct k_spinlock pending_lock;
+
+static char pcm_data_mono[AUDIO_CH_NUM][PCM_NUM_BYTES_MONO];
+static char pcm_program[PCM_NUM_BYTES_MONO];
+
+static void pcm_mono_downmix(void *output, void const *const input_left,
+			     void const *const input_right, size_t size)
+{
+#if (CONFIG_AUDIO_BIT_DEPTH_OCTETS == 2)
+	int16_t *out = output;
+	int16_t const *left = input_left;
+	int16_t const *right = input_right;
+
+	for (size_t i = 0; i < size / sizeof(int16_t); i++) {
+		out[i] = ((int32_t)left[i] + right[i]) / 2;
+	}
+#else
+	int32_t *out = output;
+	int32_t const *left = input_left;
+	int32_t const *right = input_right;
+
+	for (size_t i = 0; i < size / sizeof(int32_t); i++) {
+		out[i] = (left[i] / 2) + (right[i] / 2);
+	}
+#endif /* (CONFIG_AUDIO_BIT_DEPTH_OCTETS == 2) */
+}
+
+static void pending_cfg_apply(uint8_t idx)
+{
+	int ret;
+	struct program *prog = &programs[idx];
+	k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+	prog->cfg = pending_cfg[idx];
+
+	k_spin_unlock(&pending_lock, key);
+
+	prog->silence_frames = 0;
+
+	if (prog->cfg.src == BCAST_PROGRAM_SRC_TONE) {
+		ret = tone_gen(prog->tone, &prog->tone_size, prog->cfg.tone_hz,
+			       CONFIG_AUDIO_SAMPLE_RATE_HZ, 1);
+		if (ret || prog->tone_size > sizeof(prog->tone)) {
+			LOG_ERR("Failed to generate %d Hz tone for program %d", prog->cfg.tone_hz,
+				idx);
+			prog->cfg.src = BCAST_PROGRAM_SRC_OFF;
+		}
+
+		prog->tone_pos = 0;
+	}
+
+	LOG_INF("Program %d source: %s", idx, src_names[prog->cfg.src]);
+}
+
+static void enc_time_update(struct program *prog, timing_t *start, timing_t *end)
+{
+	uint32_t ns = (uint32_t)timing_cycles_to_ns(timing_cycles_get(start, end));
+
+	if (prog->frames == 0) {
+		prog->enc_avg_ns = ns;
+	} else {
+		prog->enc_avg_ns += ((int32_t)ns - (int32_t)prog->enc_avg_ns) / 16;
+	}
+
+	prog->enc_max_ns = MAX(prog->enc_max_ns, ns);
+	prog->frames++;
+}
+
+int bcast_programs_encode(void *pcm_data, size_t pcm_size, uint8_t *const encoded_data[],
+			  size_t encoded_size_max, size_t *encoded_size)
+{
+	int ret;
+	size_t pcm_block_size_mono;
+
+	ret = pscm_two_channel_split(pcm_data, pcm_size, CONFIG_AUDIO_BIT_DEPTH_BITS,
+				     pcm_data_mono[AUDIO_CH_L], pcm_data_mono[AUDIO_CH_R],
+				     &pcm_block_size_mono);
+	if (ret) {
+		return ret;
+	}
+
+	for (uint8_t i = 0; i < PROGRAM_NUM; i++) {
+		struct program *prog = &programs[i];
+		void *pcm_src;
+
+		if (atomic_test_and_clear_bit(&pending, i)) {
+			pending_cfg_apply(i);
+		}
+
+		switch (prog->cfg.src) {
+		case BCAST_PROGRAM_SRC_OFF:
+			if (prog->silence_frames >= SILENCE_FRAMES_ENCODE) {
+				memcpy(encoded_data[i], prog->silence,
+				       MIN(prog->silence_size, encoded_size_max));
+				*encoded_size = prog->silence_size;
+				continue;
+			}
+
+			memset(pcm_program, 0, pcm_block_size_mono);
+			pcm_src = pcm_program;
+			break;
+		case BCAST_PROGRAM_SRC_LEFT:
+			pcm_src = pcm_data_mono[AUDIO_CH_L];
+			break;
+		case BCAST_PROGRAM_SRC_RIGHT:
+			pcm_src = pcm_data_mono[AUDIO_CH_R];
+			break;
+		case BCAST_PROGRAM_SRC_MIX:
+			pcm_mono_downmix(pcm_program, pcm_data_mono[AUDIO_CH_L],
+					 pcm_data_mono[AUDIO_CH_R], pcm_block_size_mono);
+			pcm_src = pcm_program;
+			break;
+		case BCAST_PROGRAM_SRC_TONE:
+			ret = contin_array_create(pcm_program, pcm_block_size_mono, prog->tone,
+						  prog->tone_size, &prog->tone_pos);
+			if (ret) {
+				return ret;
+			}
+
+			pcm_src = pcm_program;
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		timing_t start = timing_counter_get();
+
+		ret = sw_codec_encode_ch(pcm_src, pcm_block_size_mono, i, encoded_data[i],
+					 encoded_size_max, encoded_size);
+		if (ret) {
+			return ret;
+		}
+
+		timing_t end = timing_counter_get();
+
+		if (prog->cfg.src == BCAST_PROGRAM_SRC_OFF) {
+			prog->silence_size = MIN(*encoded_size, sizeof(prog->silence));
+			memcpy(prog->silence, encoded_data[i], prog->silence_size);
+			prog->silence_frames++;
+		} else {
+			enc_time_update(prog, &start, &end);
+		}
+	}
+
+	return 0;
+}
+
+static uint32_t enc_time_est_ns(uint8_t idx)
+{
+	return programs[idx].frames ? programs[idx].enc_avg_ns : ENC_TIME_EST_NS;
+}
+
+/* Estimated encode time of all active programs, with idx counted as active */
+static uint32_t enc_time_total_ns(uint8_t idx)
+{
+	uint32_t total_ns = 0;
+
+	for (uint8_t i = 0; i < PROGRAM_NUM; i++) {
+		if (i == idx || programs[i].cfg.src != BCAST_PROGRAM_SRC_OFF) {
+			total_ns += enc_time_est_ns(i);
+		}
+	}
+
+	return total_ns;
+}
+
+int bcast_programs_src_set(uint8_t idx, enum bcast_program_src src, uint16_t tone_hz)
+{
+	if (idx >= PROGRAM_NUM || src >= BCAST_PROGRAM_SRC_NUM) {
+		return -EINVAL;
+	}
+
+	if (src == BCAST_PROGRAM_SRC_TONE) {
+		if (CONFIG_AUDIO_BIT_DEPTH_OCTETS != 2) {
+			return -ENOTSUP;
+		}
+
+		if (tone_hz < TONE_FREQ_MIN_HZ || tone_hz > TONE_FREQ_MAX_HZ) {
+			return -EINVAL;
+		}
+	}
+
+	if (src != BCAST_PROGRAM_SRC_OFF && programs[idx].cfg.src == BCAST_PROGRAM_SRC_OFF) {
+		uint32_t total_ns = enc_time_total_ns(idx);
+
+		if (total_ns > CPU_BUDGET_NS) {
+			LOG_WRN("Program %d not added: encode time %u us exceeds budget of %u us",
+				idx, total_ns / NSEC_PER_USEC, CPU_BUDGET_NS / NSEC_PER_USEC);
+			return -EBUSY;
+		}
+
+		LOG_INF("Program %d added: +%u us, encode time %u us of %u us budget", idx,
+			enc_time_est_ns(idx) / NSEC_PER_USEC, total_ns / NSEC_PER_USEC,
+			CPU_BUDGET_NS / NSEC_PER_USEC);
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+	pending_cfg[idx].src = src;
+	pending_cfg[idx].tone_hz = tone_hz;
+
+	k_spin_unlock(&pending_lock, key);
+
+	atomic_set_bit(&pending, idx);
+
+	return 0;
+}
+
+static int bcast_programs_init(const struct device *unused)
+{
+	ARG_UNUSED(unused);
+
+	timing_init();
+	timing_start();
+
+	/* Same content as a single stereo program until reconfigured */
+	for (uint8_t i = 0; i < PROGRAM_NUM; i++) {
+		programs[i].cfg.src = (i == AUDIO_CH_L) ? BCAST_PROGRAM_SRC_LEFT :
+							  BCAST_PROGRAM_SRC_RIGHT;
+	}
+
+	return 0;
+}
+
+SYS_INIT(bcast_programs_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+static int cmd_bcast_programs_list(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (uint8_t i = 0; i < PROGRAM_NUM; i++) {
+		struct program *prog = &programs[i];
+
+		if (prog->cfg.src == BCAST_PROGRAM_SRC_TONE) {
+			shell_print(shell, "Program %d: tone %d Hz", i, prog->cfg.tone_hz);
+		} else {
+			shell_print(shell, "Program %d: %s", i, src_names[prog->cfg.src]);
+		}
+
+		shell_print(shell, "\tEncode time avg: %u us, max: %u us",
+			    prog->enc_avg_ns / NSEC_PER_USEC, prog->enc_max_ns / NSEC_PER_USEC);
+	}
+
+	uint32_t total_ns = enc_time_total_ns(PROGRAM_NUM);
+
+	shell_print(shell, "Encode time of active programs: %u us of %u us budget (%u%%)",
+		    total_ns / NSEC_PER_USEC, CPU_BUDGET_NS / NSEC_PER_USEC,
+		    total_ns / (CPU_BUDGET_NS / 100));
+
+	return 0;
+}
+
+static int cmd_bcast_programs_src(const struct shell *shell, size_t argc, const char **argv)
+{
+	int ret;
+	uint8_t idx;
+	uint16_t tone_hz = 0;
+	enum bcast_program_src src;
+
+	if (argc < 3) {
+		shell_error(shell, "Usage: src <program> <off|left|right|mix|tone> [tone Hz]");
+		return -EINVAL;
+	}
+
+	idx = strtoul(argv[1], NULL, 10);
+
+	for (src = 0; src < BCAST_PROGRAM_SRC_NUM; src++) {
+		if (strcmp(argv[2], src_names[src]) == 0) {
+			break;
+		}
+	}
+
+	if (src == BCAST_PROGRAM_SRC_TONE) {
+		if (argc != 4) {
+			shell_error(shell, "Tone frequency must be provided");
+			return -EINVAL;
+		}
+
+		tone_hz = strtoul(argv[3], NULL, 10);
+	}
+
+	ret = bcast_programs_src_set(idx, src, tone_hz);
+	if (ret == -EBUSY) {
+		shell_error(shell, "Not enough CPU budget for program %d", idx);
+		return ret;
+	} else if (ret) {
+		shell_error(shell, "Failed to set source: %d", ret);
+		return ret;
+	}
+
+	shell_print(shell, "Program %d source set to %s", idx, argv[2]);
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(bcast_programs_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, list, NULL,
+					      "List programs and encode time",
+					      cmd_bcast_programs_list),
+			       SHELL_COND_CMD(CONFIG_SHELL, src, NULL,
+					      "Set program source: <program> <source> [tone Hz]",
+					      cmd_bcast_programs_src),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(bcast_prog, &bcast_programs_cmd, "Broadcast program commands", NULL);
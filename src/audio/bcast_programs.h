@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BCAST_PROGRAMS_H_
+#define _BCAST_PROGRAMS_H_
+
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Independent programs on the broadcast source
+ *
+ * Each broadcast stream carries its own program, e.g. one language per
+ * stream. A program takes its audio from a selectable source and is encoded
+ * by its own encoder channel, so the content of the streams is independent.
+ * All streams belong to the same BIG and share its ISO interval, so the
+ * programs are encoded back-to-back once per frame by the encoder thread.
+ *
+ * Encode time is measured per program. A program is only switched on if the
+ * estimated encode time of all active programs fits within
+ * CONFIG_BCAST_PROGRAMS_CPU_BUDGET_PCT of the frame duration.
+ */
+
+enum bcast_program_src {
+	/* Silence, without running the encoder */
+	BCAST_PROGRAM_SRC_OFF,
+	BCAST_PROGRAM_SRC_LEFT,
+	BCAST_PROGRAM_SRC_RIGHT,
+	/* Average of left and right input channel */
+	BCAST_PROGRAM_SRC_MIX,
+	BCAST_PROGRAM_SRC_TONE,
+	BCAST_PROGRAM_SRC_NUM,
+};
+
+/**
+ * @brief Encode one frame of every program
+ *
+ * @param pcm_data		Stereo PCM frame from the audio input
+ * @param pcm_size		Size of pcm_data
+ * @param encoded_data		Buffer per program, indexed by stream
+ * @param encoded_size_max	Size of each buffer
+ * @param encoded_size		[out] Size of encoded data per program
+ *
+ * @return 0 if successful, error otherwise
+ */
+int bcast_programs_encode(void *pcm_data, size_t pcm_size, uint8_t *const encoded_data[],
+			  size_t encoded_size_max, size_t *encoded_size);
+
+/**
+ * @brief Set the audio source of a program
+ *
+ * @note The change takes effect from the next encoded frame
+ *
+ * @param idx		Index of the program, same as the broadcast stream index
+ * @param src		Audio source
+ * @param tone_hz	Tone frequency, only used for BCAST_PROGRAM_SRC_TONE
+ *
+ * @return 0 if successful,
+ *	   -EINVAL if idx or src is out of range,
+ *	   -ENOTSUP if a tone is requested with a bit depth other than 16 bits,
+ *	   -EBUSY if switching the program on would exceed the CPU budget
+ */
+int bcast_programs_src_set(uint8_t idx, enum bcast_program_src src, uint16_t tone_hz);
+
+#endif /* _BCAST_PROGRAMS_H_ */
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "encode_sched.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_datapath.h"
+#include "audio_sync_timer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(encode_sched, CONFIG_LOG_ENCODE_SCHED_LEVEL);
+
+#define ISO_INTERVAL_US CONFIG_AUDIO_FRAME_DURATION_US
+#define BLK_PERIOD_US 1000
+
+#define TARGET_MARGIN_US CONFIG_ENCODE_SCHED_MARGIN_US
+/* Frames to average the margin over before each correction */
+#define SETTLE_FRAMES 10
+/* Phase error ignored while tracking */
+#define TRACK_DEADBAND_US 20
+/* Max phase step per correction. Must stay well below DRIFT_ERR_THRESH_UNLOCK */
+#define PHASE_STEP_US 8
+/* Phase step per correction while acquiring. Locked drift compensation moves the
+ * I2S phase by half its error per measurement, and unlocks above 32 us. Following
+ * a ramp of this many us per measurement keeps it locked
+ */
+#define ACQUIRE_STEP_US 24
+/* Error left after acquisition, removed by tracking */
+#define ACQUIRE_DONE_US 100
+/* Missing anchor updates for this long restarts acquisition */
+#define RESTART_GAP_US (ISO_INTERVAL_US * 4)
+
+#define HIST_BIN_US 500
+#define HIST_BINS (ISO_INTERVAL_US / HIST_BIN_US)
+
+enum sched_state {
+	SCHED_STATE_ACQUIRE,
+	SCHED_STATE_TRACK,
+};
+
+static const char *const sched_state_names[] = {
+	"ACQUIRE",
+	"TRACK",
+};
+
+static struct {
+	enum sched_state state;
+	uint32_t last_update_us;
+	uint32_t phase_offset_us;
+	/* Filtered margin error in us, positive when the frame is ready too early */
+	int32_t err_filt_us;
+	uint32_t frames;
+	/* Phase shift still to be applied in the current acquisition round */
+	int32_t acquire_left_us;
+
+	/* Statistics */
+	uint32_t margin_min_us;
+	uint32_t margin_max_us;
+	uint32_t acquisitions;
+	uint32_t hist[HIST_BINS];
+} sched = {
+	.margin_min_us = UINT32_MAX,
+};
+
+/* The anchor updates run on the encoder thread, the reset on the streamctrl thread */
+static struct k_spinlock sched_lock;
+
+static void sched_state_set(enum sched_state new_state)
+{
+	sched.state = new_state;
+	sched.frames = 0;
+	sched.err_filt_us = 0;
+	sched.acquire_left_us = 0;
+
+	if (new_state == SCHED_STATE_ACQUIRE) {
+		sched.acquisitions++;
+	}
+}
+
+/* A positive step moves the I2S phase later, which makes the frame ready later */
+static void phase_step(int32_t step_us)
+{
+	sched.phase_offset_us = (sched.phase_offset_us + BLK_PERIOD_US + step_us) % BLK_PERIOD_US;
+	audio_datapath_i2s_phase_offset_set(sched.phase_offset_us);
+}
+
+static void margin_stats_update(uint32_t margin_us)
+{
+	sched.margin_min_us = MIN(sched.margin_min_us, margin_us);
+	sched.margin_max_us = MAX(sched.margin_max_us, margin_us);
+	sched.hist[MIN(margin_us / HIST_BIN_US, HIST_BINS - 1)]++;
+}
+
+static void acquire(void)
+{
+	if (sched.acquire_left_us == 0) {
+		if (abs(sched.err_filt_us) <= ACQUIRE_DONE_US) {
+			sched_state_set(SCHED_STATE_TRACK);
+			return;
+		}
+
+		/* The I2S phase wraps at the block period, the time the frame is
+		 * ready keeps moving. The margin is reached without crossing an
+		 * anchor, so no frame is dropped or sent twice
+		 */
+		sched.acquire_left_us = sched.err_filt_us;
+	}
+
+	int32_t step_us = CLAMP(sched.acquire_left_us, -ACQUIRE_STEP_US, ACQUIRE_STEP_US);
+
+	phase_step(step_us);
+	sched.acquire_left_us -= step_us;
+	sched.frames = 0;
+
+	if (sched.acquire_left_us == 0) {
+		/* Measure again once I2S has followed */
+		sched.err_filt_us = 0;
+	}
+}
+
+static void track(void)
+{
+	if (abs(sched.err_filt_us) > BLK_PERIOD_US) {
+		sched_state_set(SCHED_STATE_ACQUIRE);
+		return;
+	}
+
+	if (abs(sched.err_filt_us) <= TRACK_DEADBAND_US) {
+		sched.frames = 0;
+		return;
+	}
+
+	/* A later I2S phase makes the frame ready later, reducing the margin */
+	phase_step((sched.err_filt_us > 0) ? PHASE_STEP_US : -PHASE_STEP_US);
+	sched.frames = 0;
+}
+
+void encode_sched_anchor_update(uint32_t anchor_ts_us)
+{
+	uint32_t now_us = audio_sync_timer_curr_time_get();
+	int32_t since_anchor_us = audio_sync_timer_phase_us(now_us, anchor_ts_us, ISO_INTERVAL_US);
+
+	if (since_anchor_us < 0) {
+		since_anchor_us += ISO_INTERVAL_US;
+	}
+
+	uint32_t margin_us = ISO_INTERVAL_US - since_anchor_us;
+	int32_t err_us = (int32_t)margin_us - TARGET_MARGIN_US;
+
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+	enum sched_state prev_state = sched.state;
+	int32_t gap_us = audio_sync_timer_diff_us(now_us, sched.last_update_us);
+
+	/* A negative gap means last_update_us is from before a wrap or reset */
+	if ((gap_us > RESTART_GAP_US || gap_us < 0) && sched.state != SCHED_STATE_ACQUIRE) {
+		sched_state_set(SCHED_STATE_ACQUIRE);
+	}
+
+	sched.last_update_us = now_us;
+
+	margin_stats_update(margin_us);
+
+	sched.err_filt_us += (err_us - sched.err_filt_us) / 4;
+
+	if (++sched.frames >= SETTLE_FRAMES) {
+		switch (sched.state) {
+		case SCHED_STATE_ACQUIRE:
+			acquire();
+			break;
+		case SCHED_STATE_TRACK:
+			track();
+			break;
+		default:
+			break;
+		}
+	}
+
+	enum sched_state state = sched.state;
+
+	k_spin_unlock(&sched_lock, key);
+
+	if (state != prev_state) {
+		if (state == SCHED_STATE_ACQUIRE) {
+			LOG_WRN("Encode margin lost (%d us) - Reacquiring", err_us);
+		} else {
+			LOG_INF("Encode sched state: %s", sched_state_names[state]);
+		}
+	}
+}
+
+void encode_sched_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+	sched.phase_offset_us = 0;
+	audio_datapath_i2s_phase_offset_set(0);
+	sched_state_set(SCHED_STATE_ACQUIRE);
+
+	k_spin_unlock(&sched_lock, key);
+}
+
+static int cmd_encode_sched_stats(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+	typeof(sched) snap = sched;
+
+	k_spin_unlock(&sched_lock, key);
+
+	shell_print(shell, "State: %s, target margin: %d us, filtered error: %d us",
+		    sched_state_names[snap.state], TARGET_MARGIN_US, snap.err_filt_us);
+	shell_print(shell, "I2S phase offset: %u us, acquisitions: %u", snap.phase_offset_us,
+		    snap.acquisitions);
+
+	if (snap.margin_min_us == UINT32_MAX) {
+		return 0;
+	}
+
+	shell_print(shell, "Margin min: %u us, max: %u us", snap.margin_min_us,
+		    snap.margin_max_us);
+
+	for (int i = 0; i < HIST_BINS; i++) {
+		if (snap.hist[i]) {
+			shell_print(shell, "%5d-%5d us: %u", i * HIST_BIN_US,
+				    (i + 1) * HIST_BIN_US - 1, snap.hist[i]);
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_encode_sched_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+	memset(sched.hist, 0, sizeof(sched.hist));
+	sched.margin_min_us = UINT32_MAX;
+	sched.margin_max_us = 0;
+	sched.acquisitions = 0;
+
+	k_spin_unlock(&sched_lock, key);
+
+	shell_print(shell, "Encode scheduler statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(encode_sched_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, stats, NULL,
+					      "Show encode margin statistics",
+					      cmd_encode_sched_stats),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset encode margin statistics",
+					      cmd_encode_sched_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(encode_sched, &encode_sched_cmd, "Encode scheduler commands", NULL);
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _ENCODE_SCHED_H_
+#define _ENCODE_SCHED_H_
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/*
+ * Just-in-time encode scheduling for the gateway with I2S as audio source
+ *
+ * An encoded frame is ready when I2S has delivered its last block. The time
+ * left until the next ISO TX anchor (the margin) therefore depends on the I2S
+ * block phase relative to the anchors. Drift compensation locks the I2S
+ * phase to the anchors, so the margin only has to be set once:
+ *  - Acquire: the I2S phase offset used by drift compensation is ramped as
+ *    fast as drift compensation can follow while locked, until the margin is
+ *    close to the target. The phase wraps at the block period, while the time
+ *    the frame is ready keeps moving, so any margin can be reached. It takes
+ *    up to about 30 s, and no audio is dropped.
+ *  - Track: the remaining error is removed by slowly moving the same offset.
+ */
+
+/**
+ * @brief Register the ISO TX anchor of the SDU about to be sent
+ *
+ * @note Called from le_audio_send for every encoded frame
+ *
+ * @param anchor_ts_us	Timestamp of last ISO TX anchor point
+ */
+void encode_sched_anchor_update(uint32_t anchor_ts_us);
+
+/**
+ * @brief Clear the scheduler state and the I2S phase offset
+ *
+ * @note Call when the stream stops. Statistics are kept
+ */
+void encode_sched_reset(void);
+
+#endif /* _ENCODE_SCHED_H_ */
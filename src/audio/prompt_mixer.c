@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "prompt_mixer.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "macros_common.h"
+#include "data_fifo.h"
+#include "tone.h"
+#include "contin_array.h"
+#include "audio_proc.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(prompt_mixer, CONFIG_LOG_PROMPT_MIXER_LEVEL);
+
+#if (CONFIG_AUDIO_BIT_DEPTH_OCTETS != 2)
+#error "Prompt mixer is hard coded for 16-bit PCM"
+#endif /* (CONFIG_AUDIO_BIT_DEPTH_OCTETS != 2) */
+
+/* Prompts are streamed in 1 ms mono blocks, same cadence as I2S */
+#define PROMPT_BLK_NUM_SAMPS (CONFIG_AUDIO_SAMPLE_RATE_HZ / 1000)
+#define PROMPT_BLK_SIZE_OCTETS (PROMPT_BLK_NUM_SAMPS * sizeof(int16_t))
+
+#define DUCK_GAIN ((CONFIG_PROMPT_MIXER_DUCK_GAIN_PERCENT * PROMPT_MIXER_GAIN_UNITY) / 100)
+/* Gain step per sample for a full scale ramp lasting the given time */
+#define GAIN_STEP(ms) (((ms) == 0) ? PROMPT_MIXER_GAIN_UNITY :                                    \
+			MAX(1, PROMPT_MIXER_GAIN_UNITY / ((ms) * PROMPT_BLK_NUM_SAMPS)))
+
+enum prompt_src_state {
+	SRC_STATE_IDLE, /* Free to be claimed */
+	SRC_STATE_SETUP, /* Claimed, prefetching data */
+	SRC_STATE_ACTIVE, /* Mixed by the I2S ISR */
+	SRC_STATE_DONE, /* Finished, waiting for clean-up */
+};
+
+enum prompt_src_flag {
+	SRC_FLAG_EOF, /* Reader has no more data */
+	SRC_FLAG_STOP, /* Fade out requested */
+};
+
+struct prompt_src {
+	atomic_t state;
+	atomic_t flags;
+	struct prompt_mixer_src_cfg cfg;
+	struct data_fifo *fifo;
+	int32_t gain_cur;
+	int32_t gain_step_in;
+	int32_t gain_step_out;
+	/* Statistics */
+	uint32_t underruns;
+};
+
+#define PROMPT_FIFO_DEFINE(i, _)                                                                   \
+	DATA_FIFO_DEFINE(prompt_fifo_##i, CONFIG_PROMPT_MIXER_PREFETCH_BLKS,                       \
+			 WB_UP(PROMPT_BLK_SIZE_OCTETS));
+LISTIFY(CONFIG_PROMPT_MIXER_SRC_NUM, PROMPT_FIFO_DEFINE, ())
+
+#define PROMPT_FIFO_PTR(i, _) &prompt_fifo_##i,
+static struct data_fifo *const prompt_fifos[] = { LISTIFY(CONFIG_PROMPT_MIXER_SRC_NUM,
+							   PROMPT_FIFO_PTR, ()) };
+
+static struct prompt_src srcs[CONFIG_PROMPT_MIXER_SRC_NUM];
+
+static struct {
+	int32_t gain_cur;
+	int32_t step_attack;
+	int32_t step_release;
+} duck;
+
+static bool initialized;
+
+/* Serializes source setup, eviction and refill between threads. The I2S ISR
+ * only touches sources in SRC_STATE_ACTIVE and does not take the lock
+ */
+static K_MUTEX_DEFINE(src_lock);
+
+static void prompt_refill_worker(struct k_work *work);
+
+K_WORK_DEFINE(prompt_refill_work, prompt_refill_worker);
+
+static inline int32_t gain_ramp(int32_t cur, int32_t target, int32_t step)
+{
+	if (cur < target) {
+		cur += step;
+		return MIN(cur, target);
+	} else if (cur > target) {
+		cur -= step;
+		return MAX(cur, target);
+	}
+
+	return cur;
+}
+
+int prompt_mixer_mem_read(void *ctx, int16_t *pcm, size_t num_samples)
+{
+	struct prompt_mixer_mem_reader *reader = ctx;
+
+	if (reader == NULL || pcm == NULL) {
+		return -ENXIO;
+	}
+
+	size_t num = MIN(num_samples, reader->num_samples - reader->pos);
+
+	memcpy(pcm, &reader->pcm[reader->pos], num * sizeof(int16_t));
+	reader->pos += num;
+
+	return num;
+}
+
+/**
+ * @brief Fill the FIFO of a source with as many blocks as available
+ */
+static void src_prefetch(struct prompt_src *src)
+{
+	int ret;
+	int16_t *blk;
+
+	while (!atomic_test_bit(&src->flags, SRC_FLAG_EOF)) {
+		ret = data_fifo_pointer_first_vacant_get(src->fifo, (void **)&blk, K_NO_WAIT);
+		if (ret) {
+			/* FIFO full */
+			return;
+		}
+
+		ret = src->cfg.read(src->cfg.ctx, blk, PROMPT_BLK_NUM_SAMPS);
+		if (ret <= 0) {
+			if (ret < 0) {
+				LOG_WRN("Prompt read failed: %d", ret);
+			}
+
+			ret = data_fifo_block_free(src->fifo, (void **)&blk);
+			ERR_CHK(ret);
+
+			atomic_set_bit(&src->flags, SRC_FLAG_EOF);
+			return;
+		}
+
+		if (ret < PROMPT_BLK_NUM_SAMPS) {
+			memset(&blk[ret], 0, (PROMPT_BLK_NUM_SAMPS - ret) * sizeof(int16_t));
+		}
+
+		ret = data_fifo_block_lock(src->fifo, (void **)&blk, PROMPT_BLK_SIZE_OCTETS);
+		ERR_CHK(ret);
+	}
+}
+
+static void prompt_refill_worker(struct k_work *work)
+{
+	int ret;
+
+	k_mutex_lock(&src_lock, K_FOREVER);
+
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		struct prompt_src *src = &srcs[i];
+
+		switch (atomic_get(&src->state)) {
+		case SRC_STATE_ACTIVE:
+			src_prefetch(src);
+			break;
+		case SRC_STATE_DONE:
+			if (src->underruns) {
+				LOG_WRN("Prompt %d finished with %d underruns", i, src->underruns);
+			}
+
+			ret = data_fifo_empty(src->fifo);
+			ERR_CHK(ret);
+
+			atomic_set(&src->state, SRC_STATE_IDLE);
+			LOG_DBG("Prompt %d done", i);
+			break;
+		default:
+			break;
+		}
+	}
+
+	k_mutex_unlock(&src_lock);
+}
+
+/**
+ * @brief Claim an idle source, or evict a lower priority source
+ *
+ * @note Must be called with src_lock held, so the refill worker does not
+ *	 touch the claimed source
+ *
+ * @return Source index, negative error code otherwise
+ */
+static int src_claim(uint8_t priority)
+{
+	int ret;
+	int victim = -1;
+
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		if (atomic_cas(&srcs[i].state, SRC_STATE_IDLE, SRC_STATE_SETUP)) {
+			return i;
+		}
+
+		if (atomic_get(&srcs[i].state) == SRC_STATE_ACTIVE &&
+		    srcs[i].cfg.priority < priority &&
+		    (victim < 0 || srcs[i].cfg.priority < srcs[victim].cfg.priority)) {
+			victim = i;
+		}
+	}
+
+	if (victim < 0) {
+		return -EBUSY;
+	}
+
+	/* The ISR stops mixing the victim as soon as it leaves SRC_STATE_ACTIVE.
+	 * It may have finished in the meantime, and is then waiting for clean-up
+	 */
+	if (!atomic_cas(&srcs[victim].state, SRC_STATE_ACTIVE, SRC_STATE_SETUP) &&
+	    !atomic_cas(&srcs[victim].state, SRC_STATE_DONE, SRC_STATE_SETUP)) {
+		return -EBUSY;
+	}
+
+	ret = data_fifo_empty(srcs[victim].fifo);
+	if (ret) {
+		atomic_set(&srcs[victim].state, SRC_STATE_IDLE);
+		return ret;
+	}
+
+	LOG_DBG("Evicted prompt %d", victim);
+
+	return victim;
+}
+
+int prompt_mixer_play(const struct prompt_mixer_src_cfg *cfg, uint8_t *src_id)
+{
+	int idx;
+
+	if (!initialized) {
+		return -ECANCELED;
+	}
+
+	if (cfg == NULL || cfg->read == NULL) {
+		return -EINVAL;
+	}
+
+	if (cfg->mix_mode != B_MONO_INTO_A_STEREO_LR && cfg->mix_mode != B_MONO_INTO_A_STEREO_L &&
+	    cfg->mix_mode != B_MONO_INTO_A_STEREO_R) {
+		return -ESRCH;
+	}
+
+	k_mutex_lock(&src_lock, K_FOREVER);
+
+	idx = src_claim(cfg->priority);
+	if (idx < 0) {
+		k_mutex_unlock(&src_lock);
+		return idx;
+	}
+
+	struct prompt_src *src = &srcs[idx];
+
+	src->cfg = *cfg;
+	src->cfg.gain = MIN(cfg->gain, PROMPT_MIXER_GAIN_UNITY);
+	src->gain_cur = 0;
+	src->gain_step_in = GAIN_STEP(cfg->fade_in_ms);
+	src->gain_step_out = GAIN_STEP(cfg->fade_out_ms);
+	src->underruns = 0;
+	atomic_clear(&src->flags);
+
+	/* Prefetch before handing the source over to the ISR */
+	src_prefetch(src);
+	atomic_set(&src->state, SRC_STATE_ACTIVE);
+
+	k_mutex_unlock(&src_lock);
+
+	if (src_id != NULL) {
+		*src_id = idx;
+	}
+
+	LOG_DBG("Prompt %d started, prio %d", idx, cfg->priority);
+
+	return 0;
+}
+
+int prompt_mixer_stop(uint8_t src_id)
+{
+	if (src_id >= ARRAY_SIZE(srcs)) {
+		return -EINVAL;
+	}
+
+	if (atomic_get(&srcs[src_id].state) != SRC_STATE_ACTIVE) {
+		return -EALREADY;
+	}
+
+	atomic_set_bit(&srcs[src_id].flags, SRC_FLAG_STOP);
+
+	return 0;
+}
+
+bool prompt_mixer_active(void)
+{
+	if (!initialized) {
+		return false;
+	}
+
+	if (duck.gain_cur != PROMPT_MIXER_GAIN_UNITY) {
+		return true;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		if (atomic_get(&srcs[i].state) == SRC_STATE_ACTIVE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void prompt_mixer_process(void *const pcm_stereo, size_t size)
+{
+	int ret;
+	int16_t *pcm = (int16_t *)pcm_stereo;
+	size_t num_frames = size / (2 * sizeof(int16_t));
+	int32_t acc[PROMPT_BLK_NUM_SAMPS * 2];
+	bool refill = false;
+	int duck_prio = -1;
+
+	if (num_frames != PROMPT_BLK_NUM_SAMPS) {
+		LOG_ERR("Unsupported block size: %zu", size);
+		return;
+	}
+
+	/* Highest priority among ducking sources */
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		if (atomic_get(&srcs[i].state) == SRC_STATE_ACTIVE && srcs[i].cfg.duck &&
+		    srcs[i].cfg.priority > duck_prio) {
+			duck_prio = srcs[i].cfg.priority;
+		}
+	}
+
+	/* Duck program audio */
+	int32_t duck_target = (duck_prio >= 0) ? DUCK_GAIN : PROMPT_MIXER_GAIN_UNITY;
+	int32_t duck_step = (duck_target < duck.gain_cur) ? duck.step_attack : duck.step_release;
+
+	for (int i = 0; i < num_frames; i++) {
+		duck.gain_cur = gain_ramp(duck.gain_cur, duck_target, duck_step);
+		acc[2 * i] = (pcm[2 * i] * duck.gain_cur) >> 15;
+		acc[2 * i + 1] = (pcm[2 * i + 1] * duck.gain_cur) >> 15;
+	}
+
+	/* Mix prompts */
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		struct prompt_src *src = &srcs[i];
+		int16_t *blk;
+		size_t blk_size;
+
+		if (atomic_get(&src->state) != SRC_STATE_ACTIVE) {
+			continue;
+		}
+
+		ret = data_fifo_pointer_last_filled_get(src->fifo, (void **)&blk, &blk_size,
+							K_NO_WAIT);
+		if (ret) {
+			if (atomic_test_bit(&src->flags, SRC_FLAG_EOF)) {
+				atomic_set(&src->state, SRC_STATE_DONE);
+			} else {
+				/* Reader did not keep up, skip this block */
+				src->underruns++;
+			}
+
+			refill = true;
+			continue;
+		}
+
+		bool stop = atomic_test_bit(&src->flags, SRC_FLAG_STOP);
+		int32_t target = src->cfg.gain;
+		int32_t step = src->gain_step_in;
+
+		if (stop) {
+			target = 0;
+			step = src->gain_step_out;
+		} else if (src->cfg.priority < duck_prio) {
+			/* Lower priority prompts are ducked as well */
+			target = (target * DUCK_GAIN) >> 15;
+		}
+
+		for (int j = 0; j < num_frames; j++) {
+			src->gain_cur = gain_ramp(src->gain_cur, target, step);
+
+			int32_t smpl = (blk[j] * src->gain_cur) >> 15;
+
+			if (src->cfg.mix_mode != B_MONO_INTO_A_STEREO_R) {
+				acc[2 * j] += smpl;
+			}
+
+			if (src->cfg.mix_mode != B_MONO_INTO_A_STEREO_L) {
+				acc[2 * j + 1] += smpl;
+			}
+		}
+
+		ret = data_fifo_block_free(src->fifo, (void **)&blk);
+		ERR_CHK(ret);
+
+		if (stop && src->gain_cur == 0) {
+			atomic_set(&src->state, SRC_STATE_DONE);
+		}
+
+		refill = true;
+	}
+
+	/* Hard clip */
+	for (int i = 0; i < num_frames * 2; i++) {
+		pcm[i] = CLAMP(acc[i], INT16_MIN, INT16_MAX);
+	}
+
+	if (refill) {
+		k_work_submit(&prompt_refill_work);
+	}
+}
+
+AUDIO_PROC_NODE_DEFINE(prompt_mixer, 20, AUDIO_PROC_STAGE_BLOCK, prompt_mixer_active,
+		       prompt_mixer_process);
+
+int prompt_mixer_init(void)
+{
+	int ret;
+
+	if (initialized) {
+		return -EALREADY;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		ret = data_fifo_init(prompt_fifos[i]);
+		if (ret) {
+			return ret;
+		}
+
+		srcs[i].fifo = prompt_fifos[i];
+		atomic_set(&srcs[i].state, SRC_STATE_IDLE);
+	}
+
+	duck.gain_cur = PROMPT_MIXER_GAIN_UNITY;
+	duck.step_attack = GAIN_STEP(CONFIG_PROMPT_MIXER_DUCK_ATTACK_MS);
+	duck.step_release = GAIN_STEP(CONFIG_PROMPT_MIXER_DUCK_RELEASE_MS);
+
+	initialized = true;
+
+	return 0;
+}
+
+/* Shell test source: a generated tone streamed through the reader interface */
+static struct {
+	int16_t period[CONFIG_AUDIO_SAMPLE_RATE_HZ / 100];
+	size_t period_size;
+	uint32_t finite_pos;
+	uint32_t samples_left;
+} test_tone[CONFIG_PROMPT_MIXER_SRC_NUM];
+
+static int test_tone_read(void *ctx, int16_t *pcm, size_t num_samples)
+{
+	int ret;
+	typeof(test_tone[0]) *tone = ctx;
+	size_t num = MIN(num_samples, tone->samples_left);
+
+	if (num == 0) {
+		return 0;
+	}
+
+	ret = contin_array_create(pcm, num * sizeof(int16_t), tone->period, tone->period_size,
+				  &tone->finite_pos);
+	if (ret) {
+		return ret;
+	}
+
+	tone->samples_left -= num;
+
+	return num;
+}
+
+static int cmd_prompt_tone(const struct shell *shell, size_t argc, const char **argv)
+{
+	int ret;
+	uint8_t src_id;
+	typeof(test_tone[0]) *tone = NULL;
+
+	if (argc != 4) {
+		shell_error(shell, "3 arguments (freq [Hz], dur [ms] and priority) must be provided");
+		return -EINVAL;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		if (!isdigit((int)argv[i][0])) {
+			shell_error(shell, "Argument %d is not numeric", i);
+			return -EINVAL;
+		}
+	}
+
+	/* Find a test tone buffer which is not used by any source */
+	for (int i = 0; i < ARRAY_SIZE(test_tone) && tone == NULL; i++) {
+		tone = &test_tone[i];
+
+		for (int j = 0; j < ARRAY_SIZE(srcs); j++) {
+			if (atomic_get(&srcs[j].state) != SRC_STATE_IDLE && srcs[j].cfg.ctx == tone) {
+				tone = NULL;
+				break;
+			}
+		}
+	}
+
+	if (tone == NULL) {
+		shell_error(shell, "All test tones busy");
+		return -EBUSY;
+	}
+
+	ret = tone_gen(tone->period, &tone->period_size, strtoul(argv[1], NULL, 10),
+		       CONFIG_AUDIO_SAMPLE_RATE_HZ, 0.5f);
+	if (ret) {
+		shell_error(shell, "Tone generation failed: %d", ret);
+		return ret;
+	}
+
+	tone->finite_pos = 0;
+	tone->samples_left = strtoul(argv[2], NULL, 10) * PROMPT_BLK_NUM_SAMPS;
+
+	struct prompt_mixer_src_cfg cfg = {
+		.read = test_tone_read,
+		.ctx = tone,
+		.priority = strtoul(argv[3], NULL, 10),
+		.gain = PROMPT_MIXER_GAIN_UNITY,
+		.fade_in_ms = 10,
+		.fade_out_ms = 10,
+		.duck = true,
+		.mix_mode = B_MONO_INTO_A_STEREO_LR,
+	};
+
+	ret = prompt_mixer_play(&cfg, &src_id);
+	if (ret) {
+		shell_error(shell, "Prompt play failed: %d", ret);
+		return ret;
+	}
+
+	shell_print(shell, "Prompt %d playing", src_id);
+
+	return 0;
+}
+
+static int cmd_prompt_stop(const struct shell *shell, size_t argc, const char **argv)
+{
+	int ret;
+
+	if (argc != 2 || !isdigit((int)argv[1][0])) {
+		shell_error(shell, "Source ID must be provided");
+		return -EINVAL;
+	}
+
+	ret = prompt_mixer_stop(strtoul(argv[1], NULL, 10));
+	if (ret) {
+		shell_error(shell, "Prompt stop failed: %d", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int cmd_prompt_status(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	static const char *const state_names[] = { "IDLE", "SETUP", "ACTIVE", "DONE" };
+
+	shell_print(shell, "Duck gain: %d/%d", duck.gain_cur, PROMPT_MIXER_GAIN_UNITY);
+
+	for (int i = 0; i < ARRAY_SIZE(srcs); i++) {
+		shell_print(shell, "Prompt %d: %s prio %d gain %d underruns %d", i,
+			    state_names[atomic_get(&srcs[i].state)], srcs[i].cfg.priority,
+			    srcs[i].gain_cur, srcs[i].underruns);
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(prompt_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, tone, NULL,
+					      "Play test tone prompt: freq [Hz] dur [ms] prio",
+					      cmd_prompt_tone),
+			       SHELL_COND_CMD(CONFIG_SHELL, stop, NULL, "Fade out prompt: id",
+					      cmd_prompt_stop),
+			       SHELL_COND_CMD(CONFIG_SHELL, status, NULL, "Show prompt sources",
+					      cmd_prompt_status),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(prompt, &prompt_cmd, "Prompt mixer commands", NULL);
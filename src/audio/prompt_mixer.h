@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _PROMPT_MIXER_H_
+#define _PROMPT_MIXER_H_
+
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pcm_mix.h"
+
+/* Unity gain in Q15 format */
+#define PROMPT_MIXER_GAIN_UNITY (1 << 15)
+
+/**
+ * @brief Read callback used to stream prompt audio into the mixer
+ *
+ * @note Called from thread context (system work queue). Prompts are never
+ *       required to be fully resident in RAM; the reader is asked for one
+ *       1 ms block at a time and may e.g. read directly from (memory mapped)
+ *       flash or decode a compressed prompt.
+ *
+ * @param ctx		Reader context given in prompt_mixer_src_cfg
+ * @param pcm		Buffer to fill with signed 16-bit mono PCM
+ * @param num_samples	Number of samples requested
+ *
+ * @return Number of samples written, 0 at end of prompt, negative error code otherwise
+ */
+typedef int (*prompt_mixer_read_t)(void *ctx, int16_t *pcm, size_t num_samples);
+
+struct prompt_mixer_src_cfg {
+	prompt_mixer_read_t read;
+	void *ctx;
+	/* Higher value means higher priority */
+	uint8_t priority;
+	/* Source gain in Q15, PROMPT_MIXER_GAIN_UNITY is 0 dB */
+	uint16_t gain;
+	uint16_t fade_in_ms;
+	uint16_t fade_out_ms;
+	/* Duck program audio and lower priority prompts while playing */
+	bool duck;
+	/* Only mono source modes are supported */
+	enum pcm_mix_mode mix_mode;
+};
+
+/* Reader context for signed 16-bit mono PCM in memory (e.g. const data in flash) */
+struct prompt_mixer_mem_reader {
+	const int16_t *pcm;
+	size_t num_samples;
+	size_t pos;
+};
+
+/**
+ * @brief Read callback for prompts stored as raw PCM in memory
+ *
+ * @note Use with a struct prompt_mixer_mem_reader as context. The
+ *       reader must stay valid until the prompt has finished playing
+ */
+int prompt_mixer_mem_read(void *ctx, int16_t *pcm, size_t num_samples);
+
+/**
+ * @brief Start playing a prompt
+ *
+ * @note If all sources are busy, the lowest priority source is stopped at once
+ *       and replaced if it has a lower priority than the new prompt
+ *
+ * @param cfg		Source configuration
+ * @param src_id	Pointer to store source ID, can be NULL
+ *
+ * @return 0 if successful, -EBUSY if no source could be allocated,
+ *	   error otherwise
+ */
+int prompt_mixer_play(const struct prompt_mixer_src_cfg *cfg, uint8_t *src_id);
+
+/**
+ * @brief Fade out and stop a prompt
+ *
+ * @param src_id Source ID given by prompt_mixer_play
+ *
+ * @return 0 if successful, -EALREADY if source is not playing
+ */
+int prompt_mixer_stop(uint8_t src_id);
+
+/**
+ * @brief Check if any prompt is playing or the ducking envelope is active
+ *
+ * @return true if prompt_mixer_process needs to be called
+ */
+bool prompt_mixer_active(void);
+
+/**
+ * @brief Mix active prompts into a block of stereo PCM and duck the program audio
+ *
+ * @note Called from the I2S block complete ISR. Hard coded for signed 16-bit PCM
+ *
+ * @param pcm_stereo	[in/out] Interleaved stereo block of program audio
+ * @param size		Size of block in bytes
+ */
+void prompt_mixer_process(void *const pcm_stereo, size_t size);
+
+/**
+ * @brief Initialize the prompt mixer
+ *
+ * @return 0 if successful, error otherwise
+ */
+int prompt_mixer_init(void);
+
+#endif /* _PROMPT_MIXER_H_ */
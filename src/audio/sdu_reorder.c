@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "sdu_reorder.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(sdu_reorder, CONFIG_LOG_SDU_REORDER_LEVEL);
+
+#define WINDOW_DEPTH CONFIG_SDU_REORDER_DEPTH
+#define ISO_INTERVAL_US CONFIG_AUDIO_FRAME_DURATION_US
+
+/* Jumps outside [-WINDOW_DEPTH, RESYNC_OFFSET) intervals restart the window */
+#define RESYNC_OFFSET (2 * WINDOW_DEPTH)
+
+struct reorder_slot {
+	void *frame;
+	uint32_t sdu_ref_us;
+};
+
+static struct {
+	sdu_reorder_out_t out;
+	sdu_reorder_drop_t drop;
+	bool synced;
+	/* sdu_ref_us of the frame to be handed out next */
+	uint32_t next_sdu_ref_us;
+	/* sdu_ref_us of the last frame handed out, not counting gaps */
+	bool last_valid;
+	uint32_t last_sdu_ref_us;
+	uint8_t head;
+	uint8_t held;
+	struct reorder_slot slots[WINDOW_DEPTH];
+	struct sdu_reorder_stats stats;
+} ctx;
+
+static struct reorder_slot *slot_get(uint32_t offset)
+{
+	return &ctx.slots[(ctx.head + offset) % WINDOW_DEPTH];
+}
+
+/* Distance from the next frame to be handed out, rounded to whole ISO intervals */
+static int32_t interval_offset_get(uint32_t sdu_ref_us)
+{
+	int32_t delta_us = (int32_t)(sdu_ref_us - ctx.next_sdu_ref_us);
+
+	if (delta_us >= 0) {
+		return (delta_us + (ISO_INTERVAL_US / 2)) / ISO_INTERVAL_US;
+	}
+
+	return (delta_us - (ISO_INTERVAL_US / 2)) / ISO_INTERVAL_US;
+}
+
+/* Hand out the frame at the head of the window, or a gap if it is missing */
+static void head_out(void)
+{
+	struct reorder_slot *head = slot_get(0);
+	void *frame = head->frame;
+	uint32_t sdu_ref_us;
+
+	if (frame != NULL) {
+		sdu_ref_us = head->sdu_ref_us;
+		head->frame = NULL;
+		ctx.held--;
+		ctx.last_valid = true;
+		ctx.last_sdu_ref_us = sdu_ref_us;
+	} else {
+		sdu_ref_us = ctx.next_sdu_ref_us;
+		ctx.stats.gaps_filled++;
+		LOG_DBG("Missing frame, sdu_ref_us: %u", sdu_ref_us);
+	}
+
+	/* Follow the received sdu_ref_us instead of accumulating the estimate */
+	ctx.next_sdu_ref_us = sdu_ref_us + ISO_INTERVAL_US;
+	ctx.head = (ctx.head + 1) % WINDOW_DEPTH;
+	ctx.stats.out++;
+
+	ctx.out(frame, sdu_ref_us);
+}
+
+/* Empty the window, dropping all held frames */
+static void window_flush(void)
+{
+	for (uint32_t i = 0; i < WINDOW_DEPTH; i++) {
+		struct reorder_slot *slot = slot_get(i);
+
+		if (slot->frame != NULL) {
+			ctx.drop(slot->frame);
+			slot->frame = NULL;
+		}
+	}
+
+	ctx.head = 0;
+	ctx.held = 0;
+	ctx.synced = false;
+	ctx.last_valid = false;
+}
+
+static bool is_duplicate_of_last(uint32_t sdu_ref_us)
+{
+	int32_t delta_us = (int32_t)(sdu_ref_us - ctx.last_sdu_ref_us);
+
+	return ctx.last_valid && (abs(delta_us) < (ISO_INTERVAL_US / 2));
+}
+
+void sdu_reorder_put(void *frame, uint32_t sdu_ref_us)
+{
+	int32_t offset;
+	struct reorder_slot *slot;
+
+	__ASSERT_NO_MSG(frame != NULL);
+
+	if (!ctx.synced) {
+		ctx.next_sdu_ref_us = sdu_ref_us;
+		ctx.synced = true;
+	}
+
+	offset = interval_offset_get(sdu_ref_us);
+
+	if (offset >= RESYNC_OFFSET || offset < -WINDOW_DEPTH) {
+		LOG_INF("sdu_ref_us jumped %d intervals - Resynchronizing", offset);
+		ctx.stats.resyncs++;
+
+		/* Held frames belong to the stream before the jump, e.g. a
+		 * restart, and must not be played ahead of the new stream
+		 */
+		window_flush();
+
+		ctx.next_sdu_ref_us = sdu_ref_us;
+		ctx.synced = true;
+		offset = 0;
+	} else if (offset < 0) {
+		if (is_duplicate_of_last(sdu_ref_us)) {
+			ctx.stats.duplicates++;
+			LOG_DBG("Duplicate sdu_ref_us: %u", sdu_ref_us);
+		} else {
+			ctx.stats.late++;
+			LOG_DBG("Late sdu_ref_us: %u", sdu_ref_us);
+		}
+
+		ctx.drop(frame);
+		return;
+	}
+
+	/* Give up the oldest missing frames to make room */
+	while (offset >= WINDOW_DEPTH) {
+		head_out();
+		offset = interval_offset_get(sdu_ref_us);
+	}
+
+	slot = slot_get(offset);
+
+	if (slot->frame != NULL) {
+		ctx.stats.duplicates++;
+		LOG_DBG("Duplicate sdu_ref_us: %u", sdu_ref_us);
+		ctx.drop(frame);
+		return;
+	}
+
+	for (uint32_t i = offset + 1; i < WINDOW_DEPTH; i++) {
+		if (slot_get(i)->frame != NULL) {
+			ctx.stats.reordered++;
+			break;
+		}
+	}
+
+	slot->frame = frame;
+	slot->sdu_ref_us = sdu_ref_us;
+	ctx.held++;
+
+	while (slot_get(0)->frame != NULL) {
+		head_out();
+	}
+}
+
+void sdu_reorder_reset(void)
+{
+	window_flush();
+}
+
+void sdu_reorder_stats_get(struct sdu_reorder_stats *stats)
+{
+	*stats = ctx.stats;
+}
+
+int sdu_reorder_init(sdu_reorder_out_t out, sdu_reorder_drop_t drop)
+{
+	if (out == NULL || drop == NULL) {
+		return -EINVAL;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.out = out;
+	ctx.drop = drop;
+
+	return 0;
+}
+
+static int cmd_sdu_reorder_stats(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct sdu_reorder_stats stats;
+
+	sdu_reorder_stats_get(&stats);
+
+	shell_print(shell, "Window depth: %d, held: %d", WINDOW_DEPTH, ctx.held);
+	shell_print(shell, "Out: %u", stats.out);
+	shell_print(shell, "Reordered: %u", stats.reordered);
+	shell_print(shell, "Duplicates: %u", stats.duplicates);
+	shell_print(shell, "Late: %u", stats.late);
+	shell_print(shell, "Gaps filled: %u", stats.gaps_filled);
+	shell_print(shell, "Resyncs: %u", stats.resyncs);
+
+	return 0;
+}
+
+static int cmd_sdu_reorder_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	memset(&ctx.stats, 0, sizeof(ctx.stats));
+
+	shell_print(shell, "Reorder statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sdu_reorder_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, stats, NULL,
+					      "Show reorder window statistics",
+					      cmd_sdu_reorder_stats),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset reorder window statistics",
+					      cmd_sdu_reorder_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(sdu_reorder, &sdu_reorder_cmd, "ISO RX reorder window commands", NULL);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _SDU_REORDER_H_
+#define _SDU_REORDER_H_
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/*
+ * Reorder window for received ISO SDUs
+ *
+ * Frames are keyed by sdu_ref_us, rounded to whole ISO intervals. Frames are
+ * handed out in sdu_ref order, one per ISO interval. Duplicates and frames that
+ * arrive after their slot has been handed out are dropped. A missing frame is
+ * handed out as a gap (NULL) once a frame CONFIG_SDU_REORDER_DEPTH intervals
+ * later has been received, so that the decoder can conceal it.
+ *
+ * All functions must be called from the same thread, or be serialized by
+ * the caller.
+ */
+
+/**
+ * @brief Callback for handing out the next frame
+ *
+ * @param frame		Frame given to sdu_reorder_put, or NULL if the frame is missing
+ * @param sdu_ref_us	sdu_ref_us of the frame, estimated if the frame is missing
+ */
+typedef void (*sdu_reorder_out_t)(void *frame, uint32_t sdu_ref_us);
+
+/**
+ * @brief Callback for releasing a frame which is not handed out
+ *
+ * @param frame Frame given to sdu_reorder_put
+ */
+typedef void (*sdu_reorder_drop_t)(void *frame);
+
+struct sdu_reorder_stats {
+	/* Frames handed out, including gaps */
+	uint32_t out;
+	/* Frames received ahead of a missing frame */
+	uint32_t reordered;
+	uint32_t duplicates;
+	/* Frames received after their slot was handed out */
+	uint32_t late;
+	/* Missing frames handed out as gaps */
+	uint32_t gaps_filled;
+	/* Jumps in sdu_ref_us too large for the window, e.g. stream restart.
+	 * Held frames are dropped
+	 */
+	uint32_t resyncs;
+};
+
+/**
+ * @brief Put a received frame into the reorder window
+ *
+ * @note Frames are handed out or dropped through the callbacks given in
+ *       sdu_reorder_init, possibly before this function returns. At most
+ *       CONFIG_SDU_REORDER_DEPTH - 1 frames are held by the window
+ *
+ * @param frame		Frame, must not be NULL
+ * @param sdu_ref_us	ISO timestamp reference from BLE controller
+ */
+void sdu_reorder_put(void *frame, uint32_t sdu_ref_us);
+
+/**
+ * @brief Drop all held frames and resynchronize on the next frame
+ *
+ * @note Call when the stream stops, so that frames held from the old stream
+ *       are not handed out when it restarts
+ */
+void sdu_reorder_reset(void);
+
+/**
+ * @brief Get reorder statistics
+ *
+ * @param stats [out] Statistics
+ */
+void sdu_reorder_stats_get(struct sdu_reorder_stats *stats);
+
+/**
+ * @brief Initialize the reorder window
+ *
+ * @param out	Callback for frames handed out
+ * @param drop	Callback for frames dropped
+ *
+ * @return 0 if successful, -EINVAL if a callback is missing
+ */
+int sdu_reorder_init(sdu_reorder_out_t out, sdu_reorder_drop_t drop);
+
+#endif /* _SDU_REORDER_H_ */
@@ -8,6 +8,7 @@
 
 #include <zephyr/kernel.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <zephyr/drivers/gpio.h>
@@ -25,10 +26,30 @@
 #include "le_audio.h"
 #include "audio_datapath.h"
 #include "audio_sync_timer.h"
+#include "iso_rx_stats.h"
+#if (CONFIG_SDU_REORDER)
+#include "sdu_reorder.h"
+#endif /* (CONFIG_SDU_REORDER) */
+#if (CONFIG_ENCODE_SCHED)
+#include "encode_sched.h"
+#endif /* (CONFIG_ENCODE_SCHED) */
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(streamctrl, CONFIG_LOG_STREAMCTRL_LEVEL);
 
+#if (CONFIG_BLE_RX_ZERO_COPY)
+/* Descriptor for a received SDU. The payload stays in the ISO RX net_buf */
+struct ble_iso_data {
+	struct net_buf *buf;
+	bool bad_frame;
+	uint32_t sdu_ref;
+	uint32_t recv_frame_ts;
+};
+
+/* One ISO RX buffer must remain available to the host for reception */
+BUILD_ASSERT(CONFIG_BT_ISO_RX_BUF_COUNT > CONFIG_BUF_BLE_RX_PACKET_NUM,
+	     "BT_ISO_RX_BUF_COUNT must be larger than BUF_BLE_RX_PACKET_NUM");
+#else
 struct ble_iso_data {
 	uint8_t data[CONFIG_BT_ISO_RX_MTU];
 	size_t data_size;
@@ -36,6 +57,20 @@ struct ble_iso_data {
 	uint32_t sdu_ref;
 	uint32_t recv_frame_ts;
 } __packed;
+#endif /* (CONFIG_BLE_RX_ZERO_COPY) */
+
+#if (CONFIG_SDU_REORDER)
+/* Frames held by the reorder window stay allocated in ble_fifo_rx. The window holds
+ * up to SDU_REORDER_DEPTH - 1 blocks and the datapath thread one more while putting
+ * it in. At least one block must be left queued for the overrun handling in
+ * le_audio_rx_data_handler, which frees the oldest queued block
+ */
+BUILD_ASSERT(CONFIG_SDU_REORDER_DEPTH < CONFIG_BUF_BLE_RX_PACKET_NUM,
+	     "SDU_REORDER_DEPTH must be smaller than BUF_BLE_RX_PACKET_NUM");
+
+/* The window is fed by the datapath thread and reset when the stream stops */
+static K_MUTEX_DEFINE(sdu_reorder_mtx);
+#endif /* (CONFIG_SDU_REORDER) */
 
 DATA_FIFO_DEFINE(ble_fifo_rx, CONFIG_BUF_BLE_RX_PACKET_NUM, WB_UP(sizeof(struct ble_iso_data)));
 
@@ -106,7 +141,7 @@ static void ble_test_pattern_receive(uint8_t const *const p_data, size_t data_si
 
 /* Callback for handling BLE RX */
 static void le_audio_rx_data_handler(uint8_t const *const p_data, size_t data_size, bool bad_frame,
-				     uint32_t sdu_ref)
+				     uint32_t sdu_ref, struct net_buf *buf)
 {
 	/* Capture timestamp of when audio frame is received */
 	uint32_t recv_frame_ts = audio_sync_timer_curr_time_get();
@@ -141,11 +176,16 @@ static void le_audio_rx_data_handler(uint8_t const *const p_data, size_t data_si
 		size_t stale_size;
 
 		LOG_WRN("BLE ISO RX overrun");
+		iso_rx_stats_overrun();
 
 		ret = data_fifo_pointer_last_filled_get(&ble_fifo_rx, &stale_data, &stale_size,
 							K_NO_WAIT);
 		ERR_CHK(ret);
 
+#if (CONFIG_BLE_RX_ZERO_COPY)
+		net_buf_unref(((struct ble_iso_data *)stale_data)->buf);
+#endif /* (CONFIG_BLE_RX_ZERO_COPY) */
+
 		ret = data_fifo_block_free(&ble_fifo_rx, &stale_data);
 		ERR_CHK(ret);
 	}
@@ -153,14 +193,25 @@ static void le_audio_rx_data_handler(uint8_t const *const p_data, size_t data_si
 	ret = data_fifo_pointer_first_vacant_get(&ble_fifo_rx, (void *)&iso_received, K_NO_WAIT);
 	ERR_CHK_MSG(ret, "Unable to get FIFO pointer");
 
+#if (CONFIG_BLE_RX_ZERO_COPY)
+	ARG_UNUSED(p_data);
+	ARG_UNUSED(data_size);
+
+	/* Released by the audio datapath thread after decoding */
+	iso_received->buf = net_buf_ref(buf);
+#else
+	ARG_UNUSED(buf);
+
 	if (data_size > ARRAY_SIZE(iso_received->data)) {
 		ERR_CHK_MSG(-ENOMEM, "Data size too large for buffer");
 	}
 
 	memcpy(iso_received->data, p_data, data_size);
 
-	iso_received->bad_frame = bad_frame;
 	iso_received->data_size = data_size;
+#endif /* (CONFIG_BLE_RX_ZERO_COPY) */
+
+	iso_received->bad_frame = bad_frame;
 	iso_received->sdu_ref = sdu_ref;
 	iso_received->recv_frame_ts = recv_frame_ts;
 
@@ -169,6 +220,75 @@ static void le_audio_rx_data_handler(uint8_t const *const p_data, size_t data_si
 	ERR_CHK_MSG(ret, "Failed to lock block");
 }
 
+/* Hand a received frame to the audio datapath */
+static void ble_iso_frame_out(uint8_t const *const data, size_t data_size, bool bad_frame,
+			      uint32_t sdu_ref, uint32_t recv_frame_ts)
+{
+#if ((CONFIG_AUDIO_DEV == GATEWAY) && (CONFIG_AUDIO_SOURCE_USB))
+	int ret;
+
+	ARG_UNUSED(sdu_ref);
+	ARG_UNUSED(recv_frame_ts);
+
+	ret = audio_decode(data, data_size, bad_frame);
+	ERR_CHK(ret);
+#else
+	audio_datapath_stream_out(data, data_size, sdu_ref, bad_frame, recv_frame_ts);
+#endif
+}
+
+static void ble_iso_data_decode(struct ble_iso_data const *const iso_received)
+{
+#if (CONFIG_BLE_RX_ZERO_COPY)
+	uint8_t const *data = iso_received->buf->data;
+	size_t data_size = iso_received->buf->len;
+#else
+	uint8_t const *data = iso_received->data;
+	size_t data_size = iso_received->data_size;
+#endif /* (CONFIG_BLE_RX_ZERO_COPY) */
+
+	ble_iso_frame_out(data, data_size, iso_received->bad_frame, iso_received->sdu_ref,
+			  iso_received->recv_frame_ts);
+}
+
+static void ble_iso_data_release(struct ble_iso_data *iso_received)
+{
+	int ret;
+
+#if (CONFIG_BLE_RX_ZERO_COPY)
+	net_buf_unref(iso_received->buf);
+#endif /* (CONFIG_BLE_RX_ZERO_COPY) */
+
+	ret = data_fifo_block_free(&ble_fifo_rx, (void *)&iso_received);
+	ERR_CHK(ret);
+}
+
+#if (CONFIG_SDU_REORDER)
+/* Called by the reorder window, in order, once per ISO interval */
+static void sdu_reorder_out(void *frame, uint32_t sdu_ref_us)
+{
+	/* Offset between sdu_ref and time of reception for the last received frame */
+	static uint32_t recv_offset_us;
+	struct ble_iso_data *iso_received = frame;
+
+	if (iso_received == NULL) {
+		/* Frame never received, let the decoder conceal it */
+		ble_iso_frame_out(NULL, 0, true, sdu_ref_us, sdu_ref_us + recv_offset_us);
+		return;
+	}
+
+	recv_offset_us = iso_received->recv_frame_ts - iso_received->sdu_ref;
+
+	ble_iso_data_decode(iso_received);
+	ble_iso_data_release(iso_received);
+}
+
+static void sdu_reorder_drop(void *frame)
+{
+	ble_iso_data_release((struct ble_iso_data *)frame);
+}
+#endif /* (CONFIG_SDU_REORDER) */
+
 /* Thread to receive data from BLE through a k_fifo and send to audio datapath */
 static void audio_datapath_thread(void *dummy1, void *dummy2, void *dummy3)
 {
@@ -181,17 +301,15 @@ static void audio_datapath_thread(void *dummy1, void *dummy2, void *dummy3)
 							&iso_received_size, K_FOREVER);
 		ERR_CHK(ret);
 
-#if ((CONFIG_AUDIO_DEV == GATEWAY) && (CONFIG_AUDIO_SOURCE_USB))
-		ret = audio_decode(iso_received->data, iso_received->data_size,
-				   iso_received->bad_frame);
-		ERR_CHK(ret);
+#if (CONFIG_SDU_REORDER)
+		/* Block is released by the reorder window callbacks */
+		k_mutex_lock(&sdu_reorder_mtx, K_FOREVER);
+		sdu_reorder_put(iso_received, iso_received->sdu_ref);
+		k_mutex_unlock(&sdu_reorder_mtx);
 #else
-		audio_datapath_stream_out(iso_received->data, iso_received->data_size,
-					  iso_received->sdu_ref, iso_received->bad_frame,
-					  iso_received->recv_frame_ts);
-#endif
-		ret = data_fifo_block_free(&ble_fifo_rx, (void *)&iso_received);
-		ERR_CHK(ret);
+		ble_iso_data_decode(iso_received);
+		ble_iso_data_release(iso_received);
+#endif /* (CONFIG_SDU_REORDER) */
 
 		STACK_USAGE_PRINT("audio_datapath_thread", &audio_datapath_thread_data);
 	}
@@ -223,6 +341,35 @@ void streamctrl_encoded_data_send(void const *const data, size_t len)
 	}
 }
 
+#if (CONFIG_ENCODE_TO_TX_BUF)
+int streamctrl_tx_bufs_alloc(uint8_t *data[], size_t num)
+{
+	if (strm_state != STATE_STREAMING) {
+		return -ECANCELED;
+	}
+
+	return le_audio_tx_bufs_alloc(data, num, LE_AUDIO_SDU_SIZE_OCTETS(CONFIG_LC3_BITRATE));
+}
+
+void streamctrl_tx_bufs_send(size_t len)
+{
+	int ret;
+	static int prev_ret;
+
+	ret = le_audio_tx_bufs_send(len);
+
+	if (ret != 0 && ret != prev_ret) {
+		LOG_WRN("Problem with sending LE audio data, ret: %d", ret);
+	}
+	prev_ret = ret;
+}
+
+void streamctrl_tx_bufs_free(void)
+{
+	le_audio_tx_bufs_free();
+}
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
+
 /* Handle button activity events */
 static void button_evt_handler(struct button_evt event)
 {
@@ -270,24 +417,6 @@ static void button_evt_handler(struct button_evt event)
 		}
 		break;
 
-	case BUTTON_VOLUME_UP:
-		ret = le_audio_volume_up();
-		if (ret) {
-			LOG_WRN("Failed to increase volume");
-			break;
-		}
-
-		break;
-
-	case BUTTON_VOLUME_DOWN:
-		ret = le_audio_volume_down();
-		if (ret) {
-			LOG_WRN("Failed to decrease volume");
-			break;
-		}
-
-		break;
-
 	case BUTTON_MUTE:
 		ret = le_audio_volume_mute();
 		if (ret) {
@@ -334,6 +463,27 @@ static void button_evt_handler(struct button_evt event)
 	}
 }
 
+/* Handle coalesced volume up/down button presses */
+static void volume_evt_handler(int32_t volume_delta)
+{
+	int ret;
+
+	LOG_DBG("Volume delta: %d", volume_delta);
+
+	for (int32_t i = 0; i < abs(volume_delta); i++) {
+		if (volume_delta > 0) {
+			ret = le_audio_volume_up();
+		} else {
+			ret = le_audio_volume_down();
+		}
+
+		if (ret) {
+			LOG_WRN("Failed to %s volume", volume_delta > 0 ? "increase" : "decrease");
+			break;
+		}
+	}
+}
+
 /* Handle Bluetooth LE audio events */
 static void le_audio_evt_handler(enum le_audio_evt_type event)
 {
@@ -365,7 +515,25 @@ static void le_audio_evt_handler(enum le_audio_evt_type event)
 		}
 
 		stream_state_set(STATE_PAUSED);
+
+#if (CONFIG_SDU_REORDER)
+		/* Frames held from this stream must not be played after a restart */
+		k_mutex_lock(&sdu_reorder_mtx, K_FOREVER);
+		sdu_reorder_reset();
+		k_mutex_unlock(&sdu_reorder_mtx);
+#endif /* (CONFIG_SDU_REORDER) */
+
+#if (CONFIG_AUDIO_WARM_PAUSE)
+		audio_system_pause();
+#else
 		audio_system_stop();
+#endif /* (CONFIG_AUDIO_WARM_PAUSE) */
+
+#if (CONFIG_ENCODE_SCHED)
+		/* The next stream has new anchors, acquire the margin from scratch */
+		encode_sched_reset();
+#endif /* (CONFIG_ENCODE_SCHED) */
+
 		ret = led_on(LED_APP_1_BLUE);
 		ERR_CHK(ret);
 
@@ -412,6 +580,10 @@ void streamctrl_event_handler(void)
 		le_audio_evt_handler(my_event.le_audio_activity.le_audio_evt_type);
 		break;
 
+	case EVT_SRC_VOLUME:
+		volume_evt_handler(my_event.volume_delta);
+		break;
+
 	default:
 		LOG_WRN("Unhandled event from queue - source = %d", my_event.event_source);
 	}
@@ -427,6 +599,11 @@ int streamctrl_start(void)
 	ret = data_fifo_init(&ble_fifo_rx);
 	ERR_CHK_MSG(ret, "Failed to set up ble_rx FIFO");
 
+#if (CONFIG_SDU_REORDER)
+	ret = sdu_reorder_init(sdu_reorder_out, sdu_reorder_drop);
+	ERR_CHK_MSG(ret, "Failed to set up SDU reorder window");
+#endif /* (CONFIG_SDU_REORDER) */
+
 	audio_datapath_thread_id =
 		k_thread_create(&audio_datapath_thread_data, audio_datapath_thread_stack,
 				CONFIG_AUDIO_DATAPATH_STACK_SIZE,
@@ -29,6 +29,28 @@ uint8_t stream_state_get(void);
  */
 void streamctrl_encoded_data_send(void const *const data, size_t len);
 
+/** @brief Reserve TX buffers for the encoder to write directly into
+ *
+ * @note Buffers must be handed back with streamctrl_tx_bufs_send or
+ *       streamctrl_tx_bufs_free
+ *
+ * @param data  [out] Buffer per channel, NULL if the channel has no buffer
+ * @param num   Number of entries in data
+ *
+ * @return 0 if at least one buffer was reserved, error otherwise
+ */
+int streamctrl_tx_bufs_alloc(uint8_t *data[], size_t num);
+
+/** @brief Send the TX buffers reserved by streamctrl_tx_bufs_alloc
+ *
+ * @param len   Length of encoded data in each buffer
+ */
+void streamctrl_tx_bufs_send(size_t len);
+
+/** @brief Release the TX buffers reserved by streamctrl_tx_bufs_alloc
+ */
+void streamctrl_tx_bufs_free(void);
+
 /** @brief Drives streamctrl state machine
  *
  * This function drives the streamctrl state machine.
@@ -100,17 +100,146 @@ int sw_codec_encode(void *pcm_data, size_t pcm_size, uint8_t **encoded_data, siz
 	return 0;
 }
 
-int sw_codec_decode(uint8_t const *const encoded_data, size_t encoded_size, bool bad_frame,
-		    void **decoded_data, size_t *decoded_size)
+#if (CONFIG_ENCODE_TO_TX_BUF)
+int sw_codec_encode_mono_to(void *const pcm_data_mono[], size_t pcm_size_mono,
+			    uint8_t *const encoded_data[], size_t encoded_size_max,
+			    size_t *encoded_size)
+{
+	int ret;
+
+	if (!m_config.encoder.enabled) {
+		LOG_ERR("Encoder has not been initialized");
+		return -ENXIO;
+	}
+
+	switch (m_config.sw_codec) {
+	case SW_CODEC_LC3: {
+#if (CONFIG_SW_CODEC_LC3)
+		uint16_t encoded_bytes_written;
+
+		switch (m_config.encoder.channel_mode) {
+		case SW_CODEC_MONO: {
+			ret = sw_codec_lc3_enc_run(pcm_data_mono[m_config.encoder.audio_ch],
+						   pcm_size_mono, LC3_USE_BITRATE_FROM_INIT, 0,
+						   encoded_size_max, encoded_data[0],
+						   &encoded_bytes_written);
+			if (ret) {
+				return ret;
+			}
+			break;
+		}
+		case SW_CODEC_STEREO: {
+			/* Each channel is written to its own buffer, so the
+			 * encoded size is given per channel
+			 */
+			for (int ch = AUDIO_CH_L; ch <= AUDIO_CH_R; ch++) {
+				ret = sw_codec_lc3_enc_run(pcm_data_mono[ch], pcm_size_mono,
+							   LC3_USE_BITRATE_FROM_INIT, ch,
+							   encoded_size_max, encoded_data[ch],
+							   &encoded_bytes_written);
+				if (ret) {
+					return ret;
+				}
+			}
+			break;
+		}
+		default:
+			LOG_ERR("Unsupported channel mode: %d", m_config.encoder.channel_mode);
+			return -ENODEV;
+		}
+
+		*encoded_size = encoded_bytes_written;
+
+#endif /* (CONFIG_SW_CODEC_LC3) */
+		break;
+	}
+	default:
+		LOG_ERR("Unsupported codec: %d", m_config.sw_codec);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+int sw_codec_encode_to(void *pcm_data, size_t pcm_size, uint8_t *const encoded_data[],
+		       size_t encoded_size_max, size_t *encoded_size)
+{
+	/* Temp storage for split stereo PCM signal */
+	char pcm_data_mono[AUDIO_CH_NUM][PCM_NUM_BYTES_MONO] = { 0 };
+	void *const pcm_data_mono_p[AUDIO_CH_NUM] = { pcm_data_mono[AUDIO_CH_L],
+						      pcm_data_mono[AUDIO_CH_R] };
+
+	size_t pcm_block_size_mono;
+	int ret;
+
+	ret = pscm_two_channel_split(pcm_data, pcm_size, CONFIG_AUDIO_BIT_DEPTH_BITS,
+				     pcm_data_mono[AUDIO_CH_L], pcm_data_mono[AUDIO_CH_R],
+				     &pcm_block_size_mono);
+	if (ret) {
+		return ret;
+	}
+
+	return sw_codec_encode_mono_to(pcm_data_mono_p, pcm_block_size_mono, encoded_data,
+				       encoded_size_max, encoded_size);
+}
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
+
+#if (CONFIG_BCAST_PROGRAMS)
+int sw_codec_encode_ch(void *pcm_data_mono, size_t pcm_size, uint8_t ch, uint8_t *encoded_data,
+		       size_t encoded_size_max, size_t *encoded_size)
+{
+	int ret;
+
+	if (!m_config.encoder.enabled) {
+		LOG_ERR("Encoder has not been initialized");
+		return -ENXIO;
+	}
+
+	if (ch >= m_config.encoder.channel_mode) {
+		LOG_ERR("Encoder channel %d not initialized", ch);
+		return -EINVAL;
+	}
+
+	switch (m_config.sw_codec) {
+	case SW_CODEC_LC3: {
+#if (CONFIG_SW_CODEC_LC3)
+		uint16_t encoded_bytes_written;
+
+		ret = sw_codec_lc3_enc_run(pcm_data_mono, pcm_size, LC3_USE_BITRATE_FROM_INIT, ch,
+					   encoded_size_max, encoded_data, &encoded_bytes_written);
+		if (ret) {
+			return ret;
+		}
+
+		*encoded_size = encoded_bytes_written;
+
+#endif /* (CONFIG_SW_CODEC_LC3) */
+		break;
+	}
+	default:
+		LOG_ERR("Unsupported codec: %d", m_config.sw_codec);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+#endif /* (CONFIG_BCAST_PROGRAMS) */
+
+int sw_codec_decode_to(uint8_t const *const encoded_data, size_t encoded_size, bool bad_frame,
+		       void *pcm_data_stereo, size_t pcm_size_max, size_t *decoded_size)
 {
 	if (!m_config.decoder.enabled) {
 		LOG_ERR("Decoder has not been initialized");
 		return -ENXIO;
 	}
 
+	if (pcm_size_max < PCM_NUM_BYTES_STEREO) {
+		LOG_ERR("PCM buffer too small");
+		return -ENOMEM;
+	}
+
 	int ret;
 	char pcm_data_mono[PCM_NUM_BYTES_MONO] = { 0 };
-	static char pcm_data_stereo[PCM_NUM_BYTES_STEREO];
 
 	size_t pcm_size_stereo = 0;
 	size_t pcm_size_session = 0;
@@ -187,7 +316,6 @@ int sw_codec_decode(uint8_t const *const encoded_data, size_t encoded_size, bool
 		}
 
 		*decoded_size = pcm_size_stereo;
-		*decoded_data = pcm_data_stereo;
 #endif /* (CONFIG_SW_CODEC_LC3) */
 		break;
 	}
@@ -198,6 +326,23 @@ int sw_codec_decode(uint8_t const *const encoded_data, size_t encoded_size, bool
 	return 0;
 }
 
+int sw_codec_decode(uint8_t const *const encoded_data, size_t encoded_size, bool bad_frame,
+		    void **decoded_data, size_t *decoded_size)
+{
+	int ret;
+	static char pcm_data_stereo[PCM_NUM_BYTES_STEREO];
+
+	ret = sw_codec_decode_to(encoded_data, encoded_size, bad_frame, pcm_data_stereo,
+				 sizeof(pcm_data_stereo), decoded_size);
+	if (ret) {
+		return ret;
+	}
+
+	*decoded_data = pcm_data_stereo;
+
+	return 0;
+}
+
 int sw_codec_uninit(struct sw_codec_config sw_codec_cfg)
 {
 	int ret;
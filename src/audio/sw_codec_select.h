@@ -79,6 +79,58 @@ struct sw_codec_config {
  */
 int sw_codec_encode(void *pcm_data, size_t pcm_size, uint8_t **encoded_data, size_t *encoded_size);
 
+/**@brief	Encode PCM data that is already split per channel into
+ *		separate buffers per channel
+ *
+ * @param[in]	pcm_data_mono		Mono PCM data per channel, indexed by
+ *					audio channel
+ * @param[in]	pcm_size_mono		Size of PCM data of each channel
+ * @param[in]	encoded_data		Buffer per channel, indexed by audio channel.
+ *					Only index 0 is used in mono mode
+ * @param[in]	encoded_size_max	Size of each buffer
+ * @param[out]	encoded_size		Size of encoded data per channel
+ *
+ * @return	0 if success, error codes depends on sw_codec selected
+ */
+int sw_codec_encode_mono_to(void *const pcm_data_mono[], size_t pcm_size_mono,
+			    uint8_t *const encoded_data[], size_t encoded_size_max,
+			    size_t *encoded_size);
+
+/**@brief	Encode PCM data into separate buffers per channel
+ *
+ * @note	Lets the encoder write directly into the buffers to be sent,
+ *		without going through a staging buffer
+ *
+ * @param[in]	pcm_data		Pointer to PCM data
+ * @param[in]	pcm_size		Size of PCM data
+ * @param[in]	encoded_data		Buffer per channel, indexed by audio channel.
+ *					Only index 0 is used in mono mode
+ * @param[in]	encoded_size_max	Size of each buffer
+ * @param[out]	encoded_size		Size of encoded data per channel
+ *
+ * @return	0 if success, error codes depends on sw_codec selected
+ */
+int sw_codec_encode_to(void *pcm_data, size_t pcm_size, uint8_t *const encoded_data[],
+		       size_t encoded_size_max, size_t *encoded_size);
+
+/**@brief	Encode one channel of mono PCM data
+ *
+ * @note	The channel selects the encoder instance, so every channel
+ *		must be fed continuously to keep its encoder state
+ *
+ * @param[in]	pcm_data_mono		Pointer to mono PCM data
+ * @param[in]	pcm_size		Size of PCM data
+ * @param[in]	ch			Encoder channel, less than the number of
+ *					channels set by channel_mode
+ * @param[out]	encoded_data		Buffer to store encoded data
+ * @param[in]	encoded_size_max	Size of encoded_data
+ * @param[out]	encoded_size		Size of encoded data
+ *
+ * @return	0 if success, error codes depends on sw_codec selected
+ */
+int sw_codec_encode_ch(void *pcm_data_mono, size_t pcm_size, uint8_t ch, uint8_t *encoded_data,
+		       size_t encoded_size_max, size_t *encoded_size);
+
 /**@brief	Decode encoded data and output PCM data
  *
  * @param[in]	encoded_data	Pointer to encoded data
@@ -92,6 +144,20 @@ int sw_codec_encode(void *pcm_data, size_t pcm_size, uint8_t **encoded_data, siz
 int sw_codec_decode(uint8_t const *const encoded_data, size_t encoded_size, bool bad_frame,
 		    void **pcm_data, size_t *pcm_size);
 
+/**@brief	Decode encoded data into a caller provided buffer
+ *
+ * @param[in]	encoded_data	Pointer to encoded data
+ * @param[in]	encoded_size	Size of encoded data
+ * @param[in]	bad_frame	Flag to indicate a missing/bad frame (only LC3)
+ * @param[out]	pcm_data	Buffer to store decoded stereo PCM data
+ * @param[in]	pcm_size_max	Size of pcm_data, at least PCM_NUM_BYTES_STEREO
+ * @param[out]	pcm_size	Size of decoded data
+ *
+ * @return	0 if success, error codes depends on sw_codec selected
+ */
+int sw_codec_decode_to(uint8_t const *const encoded_data, size_t encoded_size, bool bad_frame,
+		       void *pcm_data, size_t pcm_size_max, size_t *pcm_size);
+
 /**@brief	Uninitialize sw_codec and free allocated space
  *
  * @note	Must be called before calling init for another sw_codec
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "ble_bond_cache.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/settings/settings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(ble_bond_cache, CONFIG_LOG_BLE_LEVEL);
+
+#define SETTINGS_SUBTREE "bond_cache"
+#define SETTINGS_KEY_LEN (sizeof(SETTINGS_SUBTREE) + 4)
+#define ENTRY_NUM CONFIG_BT_MAX_PAIRED
+
+struct cache_slot {
+	bool used;
+	struct ble_bond_cache_entry entry;
+};
+
+static struct cache_slot slots[ENTRY_NUM];
+static K_MUTEX_DEFINE(cache_mtx);
+
+struct bond_find {
+	const bt_addr_le_t *addr;
+	bool found;
+};
+
+static void bond_find_cb(const struct bt_bond_info *info, void *user_data)
+{
+	struct bond_find *find = user_data;
+
+	if (!bt_addr_le_cmp(&info->addr, find->addr)) {
+		find->found = true;
+	}
+}
+
+static bool is_bonded(const bt_addr_le_t *addr)
+{
+	struct bond_find find = { .addr = addr, .found = false };
+
+	bt_foreach_bond(BT_ID_DEFAULT, bond_find_cb, &find);
+
+	return find.found;
+}
+
+static int slot_find(const bt_addr_le_t *addr)
+{
+	for (int i = 0; i < ENTRY_NUM; i++) {
+		if (slots[i].used && !bt_addr_le_cmp(&slots[i].entry.addr, addr)) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static int slot_save(int idx)
+{
+	char key[SETTINGS_KEY_LEN];
+
+	(void)snprintf(key, sizeof(key), SETTINGS_SUBTREE "/%d", idx);
+
+	if (!slots[idx].used) {
+		return settings_delete(key);
+	}
+
+	return settings_save_one(key, &slots[idx].entry, sizeof(slots[idx].entry));
+}
+
+int ble_bond_cache_get(const bt_addr_le_t *addr, struct ble_bond_cache_entry *entry)
+{
+	int idx;
+
+	if (!is_bonded(addr)) {
+		return -ENOENT;
+	}
+
+	k_mutex_lock(&cache_mtx, K_FOREVER);
+
+	idx = slot_find(addr);
+	if (idx >= 0) {
+		*entry = slots[idx].entry;
+	}
+
+	k_mutex_unlock(&cache_mtx);
+
+	return (idx >= 0) ? 0 : -ENOENT;
+}
+
+int ble_bond_cache_store(const struct ble_bond_cache_entry *entry)
+{
+	int ret;
+	int idx;
+
+	k_mutex_lock(&cache_mtx, K_FOREVER);
+
+	idx = slot_find(&entry->addr);
+	if (idx >= 0 && !memcmp(&slots[idx].entry, entry, sizeof(*entry))) {
+		k_mutex_unlock(&cache_mtx);
+		return 0;
+	}
+
+	/* Reuse a free slot, or one belonging to a removed bond */
+	for (int i = 0; i < ENTRY_NUM && idx < 0; i++) {
+		if (!slots[i].used || !is_bonded(&slots[i].entry.addr)) {
+			idx = i;
+		}
+	}
+
+	if (idx < 0) {
+		k_mutex_unlock(&cache_mtx);
+		LOG_WRN("Bond cache full");
+		return -ENOMEM;
+	}
+
+	slots[idx].used = true;
+	slots[idx].entry = *entry;
+
+	ret = slot_save(idx);
+
+	k_mutex_unlock(&cache_mtx);
+
+	if (ret) {
+		LOG_ERR("Failed to save bond cache entry: %d", ret);
+	}
+
+	return ret;
+}
+
+int ble_bond_cache_delete(const bt_addr_le_t *addr)
+{
+	int ret;
+	int idx;
+
+	k_mutex_lock(&cache_mtx, K_FOREVER);
+
+	idx = slot_find(addr);
+	if (idx < 0) {
+		k_mutex_unlock(&cache_mtx);
+		return -ENOENT;
+	}
+
+	slots[idx].used = false;
+
+	ret = slot_save(idx);
+
+	k_mutex_unlock(&cache_mtx);
+
+	return ret;
+}
+
+static int bond_cache_settings_set(const char *key, size_t len, settings_read_cb read_cb,
+				   void *cb_arg)
+{
+	ssize_t ret;
+	char *end;
+	unsigned long idx = strtoul(key, &end, 10);
+
+	if (end == key || *end != '\0' || idx >= ENTRY_NUM) {
+		return -ENOENT;
+	}
+
+	if (len != sizeof(slots[idx].entry)) {
+		LOG_WRN("Bond cache entry %lu has wrong size, ignored", idx);
+		return 0;
+	}
+
+	ret = read_cb(cb_arg, &slots[idx].entry, sizeof(slots[idx].entry));
+	if (ret < 0) {
+		return ret;
+	}
+
+	slots[idx].used = true;
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(bond_cache, SETTINGS_SUBTREE, NULL, bond_cache_settings_set, NULL,
+			       NULL);
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BLE_BOND_CACHE_H_
+#define _BLE_BOND_CACHE_H_
+
+#include <zephyr/bluetooth/addr.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Discovery results of bonded headsets, kept in settings storage
+ *
+ * Entries are only returned while the bond they belong to exists, so clearing
+ * the bonds also invalidates the cache.
+ */
+struct ble_bond_cache_entry {
+	bt_addr_le_t addr;
+	/* Audio channel of the headset, from its PACS sink location */
+	uint8_t channel;
+	/* Number of sink PAC records found */
+	uint8_t snk_codec_num;
+	/* Sink ASE found */
+	bool snk_ep_found;
+};
+
+/**
+ * @brief Get the cached discovery results of a bonded device
+ *
+ * @param addr		Address of the device
+ * @param entry		[out] Cached entry
+ *
+ * @return 0 if successful, -ENOENT if the device is not cached or not bonded
+ */
+int ble_bond_cache_get(const bt_addr_le_t *addr, struct ble_bond_cache_entry *entry);
+
+/**
+ * @brief Store discovery results of a bonded device
+ *
+ * @note Settings storage is only written if the entry has changed
+ *
+ * @param entry	Entry to store
+ *
+ * @return 0 if successful, error otherwise
+ */
+int ble_bond_cache_store(const struct ble_bond_cache_entry *entry);
+
+/**
+ * @brief Delete the cached discovery results of a device
+ *
+ * @param addr	Address of the device
+ *
+ * @return 0 if successful, -ENOENT if the device is not cached
+ */
+int ble_bond_cache_delete(const bt_addr_le_t *addr);
+
+#endif /* _BLE_BOND_CACHE_H_ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HEADSET_SLOT_H_
+#define _HEADSET_SLOT_H_
+
+#include <stddef.h>
+#include <errno.h>
+
+#include "channel_assignment.h"
+
+/*
+ * Headset slots of the CIS gateway
+ *
+ * Headsets are grouped in stereo pairs. The headset in slot i receives audio channel
+ * i % AUDIO_CH_NUM, so all headsets of one channel share the same encoded frame.
+ * A headset has one location, and is only ever held by one slot.
+ */
+
+struct bt_conn;
+
+#define HEADSET_SLOT_CH(slot) ((slot) % AUDIO_CH_NUM)
+
+/**
+ * @brief Release all slots held by a connection
+ *
+ * @param slots	Connection of each slot, NULL for free slots
+ * @param num	Number of slots
+ * @param conn	Connection to release
+ *
+ * @return Number of slots released
+ */
+static inline int headset_slot_release(struct bt_conn **slots, size_t num, struct bt_conn *conn)
+{
+	int released = 0;
+
+	for (size_t i = 0; i < num; i++) {
+		if (slots[i] == conn) {
+			slots[i] = NULL;
+			released++;
+		}
+	}
+
+	return released;
+}
+
+/**
+ * @brief Assign a connection to a slot of the given channel
+ *
+ * @note A slot held by the connection for the other channel, e.g. from an
+ *	 outdated cached location, is released. A connection which already
+ *	 holds a slot of the channel keeps it
+ *
+ * @param slots		Connection of each slot, NULL for free slots
+ * @param num		Number of slots
+ * @param conn		Connection to assign
+ * @param channel	Audio channel of the headset
+ *
+ * @return Slot index, or -ENOMEM if all slots of the channel are taken
+ */
+static inline int headset_slot_take(struct bt_conn **slots, size_t num, struct bt_conn *conn,
+				    enum audio_channel channel)
+{
+	int free_slot = -ENOMEM;
+
+	for (size_t i = 0; i < num; i++) {
+		if (slots[i] == conn && HEADSET_SLOT_CH(i) != channel) {
+			slots[i] = NULL;
+		}
+	}
+
+	for (size_t i = channel; i < num; i += AUDIO_CH_NUM) {
+		if (slots[i] == conn) {
+			return i;
+		}
+
+		if (slots[i] == NULL && free_slot < 0) {
+			free_slot = i;
+		}
+	}
+
+	if (free_slot >= 0) {
+		slots[free_slot] = conn;
+	}
+
+	return free_slot;
+}
+
+#endif /* _HEADSET_SLOT_H_ */
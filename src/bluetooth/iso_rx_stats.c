@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "iso_rx_stats.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "audio_sync_timer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(iso_rx_stats, CONFIG_LOG_BLE_LEVEL);
+
+#define STREAM_NUM CONFIG_BT_ISO_MAX_CHAN
+#define WINDOW_S CONFIG_BLE_ISO_RX_STATS_WINDOW_S
+#define ISO_INTERVAL_US CONFIG_AUDIO_FRAME_DURATION_US
+
+static const char *const burst_bin_names[ISO_RX_STATS_BURST_BINS] = {
+	"1", "2", "3-4", "5-8", "9-16", "17-32", "33+",
+};
+
+/* Counters for one second of the rolling window */
+struct window_bucket {
+	uint32_t received;
+	uint32_t bad_frames;
+	uint32_t missing;
+};
+
+struct stream_stats {
+	bool sdu_ref_valid;
+	uint32_t last_sdu_ref_us;
+	/* Length of the loss burst in progress */
+	uint32_t burst_len;
+	uint32_t received;
+	uint32_t bad_frames;
+	uint32_t missing;
+	uint32_t late;
+	uint32_t duplicates;
+	uint32_t burst_hist[ISO_RX_STATS_BURST_BINS];
+	/* Uptime of the newest bucket in seconds */
+	uint32_t bucket_s;
+	struct window_bucket buckets[WINDOW_S];
+};
+
+static struct stream_stats streams[STREAM_NUM];
+static uint32_t overruns;
+static struct k_spinlock lock;
+
+static uint32_t uptime_s_get(void)
+{
+	return (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+}
+
+/* Clear buckets which have fallen out of the window and return the current bucket */
+static struct window_bucket *bucket_advance(struct stream_stats *stats, uint32_t now_s)
+{
+	uint32_t elapsed_s = now_s - stats->bucket_s;
+
+	if (elapsed_s >= WINDOW_S) {
+		memset(stats->buckets, 0, sizeof(stats->buckets));
+	} else {
+		for (uint32_t i = 1; i <= elapsed_s; i++) {
+			memset(&stats->buckets[(stats->bucket_s + i) % WINDOW_S], 0,
+			       sizeof(struct window_bucket));
+		}
+	}
+
+	stats->bucket_s = now_s;
+
+	return &stats->buckets[now_s % WINDOW_S];
+}
+
+static void burst_end(struct stream_stats *stats)
+{
+	uint32_t bin;
+
+	if (stats->burst_len == 0) {
+		return;
+	}
+
+	/* Bin n holds bursts of length 2^(n-1) + 1 to 2^n */
+	if (stats->burst_len == 1) {
+		bin = 0;
+	} else {
+		bin = 32 - __builtin_clz(stats->burst_len - 1);
+	}
+
+	stats->burst_hist[MIN(bin, ISO_RX_STATS_BURST_BINS - 1)]++;
+	stats->burst_len = 0;
+}
+
+/* Distance from the previous sdu_ref, rounded to whole ISO intervals */
+static int32_t interval_delta_get(struct stream_stats *stats, uint32_t sdu_ref_us)
+{
+	int32_t delta_us = audio_sync_timer_diff_us(sdu_ref_us, stats->last_sdu_ref_us);
+
+	if (delta_us >= 0) {
+		return (delta_us + (ISO_INTERVAL_US / 2)) / ISO_INTERVAL_US;
+	}
+
+	return (delta_us - (ISO_INTERVAL_US / 2)) / ISO_INTERVAL_US;
+}
+
+void iso_rx_stats_recv(uint8_t stream_idx, uint32_t sdu_ref_us, bool bad_frame)
+{
+	if (stream_idx >= STREAM_NUM) {
+		return;
+	}
+
+	struct stream_stats *stats = &streams[stream_idx];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct window_bucket *bucket = bucket_advance(stats, uptime_s_get());
+
+	stats->received++;
+	bucket->received++;
+
+	if (stats->sdu_ref_valid) {
+		int32_t delta = interval_delta_get(stats, sdu_ref_us);
+
+		if (delta == 0) {
+			stats->duplicates++;
+			k_spin_unlock(&lock, key);
+			return;
+		} else if (delta < 0) {
+			stats->late++;
+			k_spin_unlock(&lock, key);
+			return;
+		} else if (delta > 1) {
+			stats->missing += delta - 1;
+			bucket->missing += delta - 1;
+			stats->burst_len += delta - 1;
+		}
+	}
+
+	stats->sdu_ref_valid = true;
+	stats->last_sdu_ref_us = sdu_ref_us;
+
+	if (bad_frame) {
+		stats->bad_frames++;
+		bucket->bad_frames++;
+		stats->burst_len++;
+	} else {
+		burst_end(stats);
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_rx_stats_stream_stopped(uint8_t stream_idx)
+{
+	if (stream_idx >= STREAM_NUM) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	streams[stream_idx].sdu_ref_valid = false;
+	burst_end(&streams[stream_idx]);
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_rx_stats_overrun(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	overruns++;
+
+	k_spin_unlock(&lock, key);
+}
+
+int iso_rx_stats_record_get(uint8_t stream_idx, struct iso_rx_stats_record *record)
+{
+	if (stream_idx >= STREAM_NUM) {
+		return -EINVAL;
+	}
+
+	struct stream_stats *stats = &streams[stream_idx];
+	uint32_t now_s = uptime_s_get();
+	uint32_t win_received = 0;
+	uint32_t win_bad_frames = 0;
+	uint32_t win_missing = 0;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	(void)bucket_advance(stats, now_s);
+
+	for (uint32_t i = 0; i < WINDOW_S; i++) {
+		win_received += stats->buckets[i].received;
+		win_bad_frames += stats->buckets[i].bad_frames;
+		win_missing += stats->buckets[i].missing;
+	}
+
+	record->version = ISO_RX_STATS_RECORD_VERSION;
+	record->stream_idx = stream_idx;
+	record->window_s = sys_cpu_to_le16(WINDOW_S);
+	record->uptime_s = sys_cpu_to_le32(now_s);
+	record->received = sys_cpu_to_le32(stats->received);
+	record->bad_frames = sys_cpu_to_le32(stats->bad_frames);
+	record->missing = sys_cpu_to_le32(stats->missing);
+	record->late = sys_cpu_to_le32(stats->late);
+	record->duplicates = sys_cpu_to_le32(stats->duplicates);
+	record->overruns = sys_cpu_to_le32(overruns);
+	record->win_received = sys_cpu_to_le32(win_received);
+	record->win_bad_frames = sys_cpu_to_le32(win_bad_frames);
+	record->win_missing = sys_cpu_to_le32(win_missing);
+
+	for (uint32_t i = 0; i < ISO_RX_STATS_BURST_BINS; i++) {
+		record->burst_hist[i] = sys_cpu_to_le32(stats->burst_hist[i]);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+void iso_rx_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	for (uint32_t i = 0; i < STREAM_NUM; i++) {
+		bool sdu_ref_valid = streams[i].sdu_ref_valid;
+		uint32_t last_sdu_ref_us = streams[i].last_sdu_ref_us;
+
+		memset(&streams[i], 0, sizeof(streams[i]));
+		streams[i].sdu_ref_valid = sdu_ref_valid;
+		streams[i].last_sdu_ref_us = last_sdu_ref_us;
+	}
+
+	overruns = 0;
+
+	k_spin_unlock(&lock, key);
+}
+
+#if (CONFIG_BLE_ISO_RX_STATS_S > 0)
+static void stats_print_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(stats_print_work, stats_print_work_handler);
+
+static void stats_print_work_handler(struct k_work *work)
+{
+	struct iso_rx_stats_record record;
+
+	for (uint8_t i = 0; i < STREAM_NUM; i++) {
+		(void)iso_rx_stats_record_get(i, &record);
+
+		if (record.received == 0) {
+			continue;
+		}
+
+		LOG_INF("Stream %d: Received %u - Bad %u - Missing %u - Late %u - Dup %u - Overrun %u",
+			i, record.received, record.bad_frames, record.missing, record.late,
+			record.duplicates, record.overruns);
+		LOG_INF("Stream %d: Last %d s: Received %u - Bad %u - Missing %u", i, WINDOW_S,
+			record.win_received, record.win_bad_frames, record.win_missing);
+	}
+
+	k_work_reschedule(&stats_print_work, K_SECONDS(CONFIG_BLE_ISO_RX_STATS_S));
+}
+
+static int iso_rx_stats_init(const struct device *unused)
+{
+	ARG_UNUSED(unused);
+
+	k_work_reschedule(&stats_print_work, K_SECONDS(CONFIG_BLE_ISO_RX_STATS_S));
+
+	return 0;
+}
+
+SYS_INIT(iso_rx_stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* (CONFIG_BLE_ISO_RX_STATS_S > 0) */
+
+static int cmd_iso_rx_stats_show(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct iso_rx_stats_record record;
+
+	for (uint8_t i = 0; i < STREAM_NUM; i++) {
+		(void)iso_rx_stats_record_get(i, &record);
+
+		shell_print(shell, "Stream %d:", i);
+		shell_print(shell, "\tReceived: %u", record.received);
+		shell_print(shell, "\tBad frames: %u", record.bad_frames);
+		shell_print(shell, "\tMissing: %u", record.missing);
+		shell_print(shell, "\tLate: %u", record.late);
+		shell_print(shell, "\tDuplicates: %u", record.duplicates);
+		shell_print(shell, "\tRX overruns (all streams): %u", record.overruns);
+		shell_print(shell, "\tLast %d s: received %u, bad %u, missing %u", WINDOW_S,
+			    record.win_received, record.win_bad_frames, record.win_missing);
+		shell_print(shell, "\tLoss bursts:");
+
+		for (uint32_t bin = 0; bin < ISO_RX_STATS_BURST_BINS; bin++) {
+			shell_print(shell, "\t\t%-5s: %u", burst_bin_names[bin],
+				    record.burst_hist[bin]);
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_iso_rx_stats_record(const struct shell *shell, size_t argc, const char **argv)
+{
+	int ret;
+	struct iso_rx_stats_record record;
+	uint8_t stream_idx = 0;
+
+	if (argc == 2) {
+		stream_idx = strtoul(argv[1], NULL, 10);
+	}
+
+	ret = iso_rx_stats_record_get(stream_idx, &record);
+	if (ret) {
+		shell_error(shell, "Invalid stream index: %d", stream_idx);
+		return ret;
+	}
+
+	shell_hexdump(shell, (uint8_t *)&record, sizeof(record));
+
+	return 0;
+}
+
+static int cmd_iso_rx_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	iso_rx_stats_reset();
+
+	shell_print(shell, "ISO RX statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(iso_rx_stats_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, show, NULL,
+					      "Show ISO RX link statistics", cmd_iso_rx_stats_show),
+			       SHELL_COND_CMD(CONFIG_SHELL, record, NULL,
+					      "Dump binary record: [stream index]",
+					      cmd_iso_rx_stats_record),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset ISO RX link statistics", cmd_iso_rx_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(iso_rx_stats, &iso_rx_stats_cmd, "ISO RX link statistics", NULL);
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _ISO_RX_STATS_H_
+#define _ISO_RX_STATS_H_
+
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Loss bursts are binned by length: 1, 2, 3-4, 5-8, 9-16, 17-32, 33+ frames */
+#define ISO_RX_STATS_BURST_BINS 7
+
+#define ISO_RX_STATS_RECORD_VERSION 1
+
+/*
+ * Binary telemetry record for one stream. All fields are little-endian.
+ * The version field is incremented whenever the layout changes.
+ */
+struct iso_rx_stats_record {
+	uint8_t version;
+	uint8_t stream_idx;
+	uint16_t window_s;
+	uint32_t uptime_s;
+	/* Totals since boot or last reset */
+	uint32_t received;
+	uint32_t bad_frames;
+	uint32_t missing;
+	uint32_t late;
+	uint32_t duplicates;
+	/* RX FIFO overrun evictions, shared by all streams */
+	uint32_t overruns;
+	/* Totals over the last window_s seconds */
+	uint32_t win_received;
+	uint32_t win_bad_frames;
+	uint32_t win_missing;
+	uint32_t burst_hist[ISO_RX_STATS_BURST_BINS];
+} __packed;
+
+/**
+ * @brief Register a received SDU
+ *
+ * @note Called from the ISO receive callback. Frames are classified as
+ *	 missing, late or duplicate from the gap to the previous sdu_ref
+ *
+ * @param stream_idx	Index of the stream
+ * @param sdu_ref_us	ISO timestamp reference from BLE controller
+ * @param bad_frame	True if the controller flagged the SDU as lost or erroneous
+ */
+void iso_rx_stats_recv(uint8_t stream_idx, uint32_t sdu_ref_us, bool bad_frame);
+
+/**
+ * @brief Register that a stream has stopped
+ *
+ * @note The gap to the first SDU after a restart is not counted as missing
+ *
+ * @param stream_idx Index of the stream
+ */
+void iso_rx_stats_stream_stopped(uint8_t stream_idx);
+
+/**
+ * @brief Register that a received SDU was evicted from the RX FIFO
+ */
+void iso_rx_stats_overrun(void);
+
+/**
+ * @brief Get the binary telemetry record of a stream
+ *
+ * @param stream_idx	Index of the stream
+ * @param record	[out] Record
+ *
+ * @return 0 if successful, -EINVAL if stream_idx is out of range
+ */
+int iso_rx_stats_record_get(uint8_t stream_idx, struct iso_rx_stats_record *record);
+
+/**
+ * @brief Reset statistics of all streams
+ */
+void iso_rx_stats_reset(void);
+
+#endif /* _ISO_RX_STATS_H_ */
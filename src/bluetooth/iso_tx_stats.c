@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "iso_tx_stats.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(iso_tx_stats, CONFIG_LOG_BLE_LEVEL);
+
+#define CHAN_NUM CONFIG_BT_ISO_MAX_CHAN
+
+/* Send timestamps of SDUs in flight. Must be a power of two */
+#define PENDING_NUM 8
+BUILD_ASSERT((PENDING_NUM & (PENDING_NUM - 1)) == 0, "PENDING_NUM must be a power of two");
+
+struct chan_stats {
+	/* Ring of send timestamps in cycles, oldest at tail */
+	uint32_t pending_cyc[PENDING_NUM];
+	uint32_t head;
+	uint32_t tail;
+
+	/* in_flight is only filled in by iso_tx_stats_get */
+	struct iso_tx_stats stats;
+};
+
+static struct chan_stats chans[CHAN_NUM];
+static struct k_spinlock lock;
+
+void iso_tx_stats_send(uint8_t chan_idx, uint32_t in_flight)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return;
+	}
+
+	struct chan_stats *chan = &chans[chan_idx];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if ((chan->head - chan->tail) < PENDING_NUM) {
+		chan->pending_cyc[chan->head % PENDING_NUM] = k_cycle_get_32();
+		chan->head++;
+	}
+
+	if (in_flight > 0) {
+		chan->stats.depth_hist[MIN(in_flight, ISO_TX_STATS_DEPTH_BINS) - 1]++;
+	}
+
+	chan->stats.depth_max = MAX(chan->stats.depth_max, in_flight);
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_tx_stats_send_cancel(uint8_t chan_idx)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return;
+	}
+
+	struct chan_stats *chan = &chans[chan_idx];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (chan->head != chan->tail) {
+		chan->head--;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_tx_stats_sent(uint8_t chan_idx)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return;
+	}
+
+	struct chan_stats *chan = &chans[chan_idx];
+	uint32_t now_cyc = k_cycle_get_32();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (chan->head == chan->tail) {
+		chan->stats.unmatched++;
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	uint32_t send_cyc = chan->pending_cyc[chan->tail % PENDING_NUM];
+	uint32_t latency_us = k_cyc_to_us_floor32(now_cyc - send_cyc);
+
+	chan->tail++;
+	chan->stats.sent++;
+	chan->stats.latency_total_us += latency_us;
+	chan->stats.latency_min_us = MIN(chan->stats.latency_min_us, latency_us);
+	chan->stats.latency_max_us = MAX(chan->stats.latency_max_us, latency_us);
+	chan->stats.latency_hist[MIN(latency_us / ISO_TX_STATS_LATENCY_BIN_US,
+				     ISO_TX_STATS_LATENCY_BINS - 1)]++;
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_tx_stats_overrun(uint8_t chan_idx)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	chans[chan_idx].stats.overruns++;
+
+	k_spin_unlock(&lock, key);
+}
+
+void iso_tx_stats_stream_stopped(uint8_t chan_idx)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	chans[chan_idx].tail = chans[chan_idx].head;
+
+	k_spin_unlock(&lock, key);
+}
+
+int iso_tx_stats_get(uint8_t chan_idx, struct iso_tx_stats *stats)
+{
+	if (chan_idx >= CHAN_NUM) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*stats = chans[chan_idx].stats;
+	stats->in_flight = chans[chan_idx].head - chans[chan_idx].tail;
+
+	k_spin_unlock(&lock, key);
+
+	return 0;
+}
+
+void iso_tx_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	/* SDUs in flight are kept, so their sent callbacks are still matched */
+	for (uint32_t i = 0; i < CHAN_NUM; i++) {
+		memset(&chans[i].stats, 0, sizeof(chans[i].stats));
+		chans[i].stats.latency_min_us = UINT32_MAX;
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+static int iso_tx_stats_init(const struct device *unused)
+{
+	ARG_UNUSED(unused);
+
+	iso_tx_stats_reset();
+
+	return 0;
+}
+
+SYS_INIT(iso_tx_stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+static int cmd_iso_tx_stats_show(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct iso_tx_stats stats;
+
+	for (uint8_t i = 0; i < CHAN_NUM; i++) {
+		(void)iso_tx_stats_get(i, &stats);
+
+		shell_print(shell, "Channel %d:", i);
+		shell_print(shell, "\tSent: %u", stats.sent);
+		shell_print(shell, "\tIn flight now: %u, max: %u", stats.in_flight,
+			    stats.depth_max);
+		shell_print(shell, "\tOverrun drops: %u", stats.overruns);
+
+		if (stats.unmatched) {
+			shell_print(shell, "\tUnmatched sent callbacks: %u", stats.unmatched);
+		}
+
+		if (stats.sent == 0) {
+			continue;
+		}
+
+		shell_print(shell, "\tLatency min: %u us, avg: %u us, max: %u us",
+			    stats.latency_min_us, (uint32_t)(stats.latency_total_us / stats.sent),
+			    stats.latency_max_us);
+		shell_print(shell, "\tIn-flight depth at send:");
+
+		for (uint32_t bin = 0; bin < ISO_TX_STATS_DEPTH_BINS; bin++) {
+			if (stats.depth_hist[bin]) {
+				shell_print(shell, "\t\t%2d%s: %u", bin + 1,
+					    (bin == ISO_TX_STATS_DEPTH_BINS - 1) ? "+" : " ",
+					    stats.depth_hist[bin]);
+			}
+		}
+
+		shell_print(shell, "\tSend to sent latency:");
+
+		for (uint32_t bin = 0; bin < ISO_TX_STATS_LATENCY_BINS; bin++) {
+			if (stats.latency_hist[bin]) {
+				shell_print(shell, "\t\t%5d-%5d us: %u",
+					    bin * ISO_TX_STATS_LATENCY_BIN_US,
+					    (bin + 1) * ISO_TX_STATS_LATENCY_BIN_US - 1,
+					    stats.latency_hist[bin]);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_iso_tx_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	iso_tx_stats_reset();
+
+	shell_print(shell, "ISO TX statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(iso_tx_stats_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, show, NULL,
+					      "Show ISO TX in-flight and latency statistics",
+					      cmd_iso_tx_stats_show),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset ISO TX statistics", cmd_iso_tx_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(iso_tx_stats, &iso_tx_stats_cmd, "ISO TX statistics", NULL);
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _ISO_TX_STATS_H_
+#define _ISO_TX_STATS_H_
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/* In-flight depth is binned as 1, 2, ... ISO_TX_STATS_DEPTH_BINS or more SDUs */
+#define ISO_TX_STATS_DEPTH_BINS 8
+
+/* Send to sent latency is binned in steps of ISO_TX_STATS_LATENCY_BIN_US */
+#define ISO_TX_STATS_LATENCY_BIN_US 500
+#define ISO_TX_STATS_LATENCY_BINS 16
+
+/* Statistics of one ISO channel since the last reset */
+struct iso_tx_stats {
+	uint32_t sent;
+	/* SDUs sent but not yet reported as sent, at the time of the read */
+	uint32_t in_flight;
+	uint32_t overruns;
+	/* Sent callbacks without a matching send */
+	uint32_t unmatched;
+	uint32_t depth_max;
+	/* UINT32_MAX until the first SDU is sent */
+	uint32_t latency_min_us;
+	uint32_t latency_max_us;
+	uint64_t latency_total_us;
+	uint32_t depth_hist[ISO_TX_STATS_DEPTH_BINS];
+	uint32_t latency_hist[ISO_TX_STATS_LATENCY_BINS];
+};
+
+/**
+ * @brief Register an SDU handed to the host for sending
+ *
+ * @param chan_idx	Index of the ISO channel
+ * @param in_flight	Number of SDUs on the channel not yet reported as sent,
+ *			including this one
+ */
+void iso_tx_stats_send(uint8_t chan_idx, uint32_t in_flight);
+
+/**
+ * @brief Withdraw the SDU last registered by iso_tx_stats_send
+ *
+ * @note Used when the host rejects the SDU. iso_tx_stats_send is called
+ *	 before sending, since the sent callback may run before the send
+ *	 call returns
+ *
+ * @param chan_idx Index of the ISO channel
+ */
+void iso_tx_stats_send_cancel(uint8_t chan_idx);
+
+/**
+ * @brief Register that the controller has sent the oldest SDU in flight
+ *
+ * @note Called from the stream sent callback
+ *
+ * @param chan_idx Index of the ISO channel
+ */
+void iso_tx_stats_sent(uint8_t chan_idx);
+
+/**
+ * @brief Register an SDU dropped because too many SDUs were in flight
+ *
+ * @param chan_idx Index of the ISO channel
+ */
+void iso_tx_stats_overrun(uint8_t chan_idx);
+
+/**
+ * @brief Register that a channel has stopped
+ *
+ * @note SDUs still in flight are forgotten, without latency samples
+ *
+ * @param chan_idx Index of the ISO channel
+ */
+void iso_tx_stats_stream_stopped(uint8_t chan_idx);
+
+/**
+ * @brief Get a snapshot of the statistics of a channel
+ *
+ * @param chan_idx	Index of the ISO channel
+ * @param stats		Pointer to the statistics to fill
+ *
+ * @return 0 if successful, -EINVAL for an invalid channel index
+ */
+int iso_tx_stats_get(uint8_t chan_idx, struct iso_tx_stats *stats);
+
+/**
+ * @brief Reset statistics of all channels
+ */
+void iso_tx_stats_reset(void);
+
+#endif /* _ISO_TX_STATS_H_ */
@@ -8,6 +8,7 @@
 #define _LE_AUDIO_H_
 
 #include <zephyr.h>
+#include <zephyr/net/buf.h>
 
 #define DEVICE_NAME_PEER CONFIG_BT_DEVICE_NAME
 #define DEVICE_NAME_PEER_LEN (sizeof(DEVICE_NAME_PEER) - 1)
@@ -33,9 +34,12 @@ struct le_audio_evt {
  * @param size		Size of received data
  * @param bad_frame	Indicating if the frame is a bad frame or not
  * @param sdu_ref	ISO timestamp
+ * @param buf		Buffer holding the received data. The receiver may keep
+ *			the data beyond the callback by taking a reference with
+ *			net_buf_ref, which holds an ISO RX buffer from the host pool
  */
 typedef void (*le_audio_receive_cb)(const uint8_t *const data, size_t size, bool bad_frame,
-				    uint32_t sdu_ref);
+				    uint32_t sdu_ref, struct net_buf *buf);
 
 /**
  * @brief Get configuration for audio stream
@@ -102,6 +106,37 @@ int le_audio_pause(void);
  */
 int le_audio_send(uint8_t const *const data, size_t size);
 
+/**
+ * @brief Reserve one ISO TX buffer per stream, to encode directly into
+ *
+ * @note Only implemented for the gateway. Reserved buffers must be handed
+ *       back with either le_audio_tx_bufs_send or le_audio_tx_bufs_free
+ *
+ * @param data	[out] Payload area per stream, NULL if the stream is not
+ *		streaming or has no free TX buffer
+ * @param num	Number of entries in data
+ * @param size	Payload size per stream
+ *
+ * @return	0 if at least one buffer was reserved,
+ *		-ECANCELED if no buffer was reserved,
+ *		error otherwise
+ */
+int le_audio_tx_bufs_alloc(uint8_t *data[], size_t num, size_t size);
+
+/**
+ * @brief Send the buffers reserved by le_audio_tx_bufs_alloc
+ *
+ * @param size	Payload size written to each buffer
+ *
+ * @return	0 for success, error otherwise
+ */
+int le_audio_tx_bufs_send(size_t size);
+
+/**
+ * @brief Release the buffers reserved by le_audio_tx_bufs_alloc without sending
+ */
+void le_audio_tx_bufs_free(void);
+
 /**
  * @brief Enable Bluetooth LE Audio
  *
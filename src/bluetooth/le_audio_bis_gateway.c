@@ -14,6 +14,7 @@
 #include "macros_common.h"
 #include "ctrl_events.h"
 #include "audio_datapath.h"
+#include "iso_tx_stats.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bis_gateway, CONFIG_LOG_BLE_LEVEL);
@@ -96,6 +97,7 @@ static void stream_sent_cb(struct bt_audio_stream *stream)
 
 	if (atomic_get(&iso_tx_pool_alloc[index])) {
 		atomic_dec(&iso_tx_pool_alloc[index]);
+		iso_tx_stats_sent(index);
 	} else {
 		LOG_WRN("Decreasing atomic variable for stream %u failed", index);
 	}
@@ -124,6 +126,11 @@ static void stream_started_cb(struct bt_audio_stream *stream)
 static void stream_stopped_cb(struct bt_audio_stream *stream)
 {
 	int ret;
+	uint8_t index;
+
+	if (get_stream_index(stream, &index) == 0) {
+		iso_tx_stats_stream_stopped(index);
+	}
 
 	ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_NOT_STREAMING);
 	ERR_CHK(ret);
@@ -212,53 +219,66 @@ int le_audio_pause(void)
 	return ret;
 }
 
-int le_audio_send(uint8_t const *const data, size_t size)
+static int iso_tx_buf_alloc(uint8_t idx, struct net_buf **buf)
 {
-	int ret;
 	static bool wrn_printed[CONFIG_BT_ISO_MAX_CHAN];
-	struct net_buf *buf;
-	size_t num_streams = ARRAY_SIZE(streams);
-	size_t data_size = size / num_streams;
 
-	for (size_t i = 0U; i < num_streams; i++) {
-		if (streams[i].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
-			LOG_DBG("Stream %d not in streaming state", i);
-			continue;
-		}
+	*buf = NULL;
 
-		if (is_iso_buffer_full(i)) {
-			if (!wrn_printed[i]) {
-				LOG_WRN("HCI ISO TX overrun on ch %d - Single print", i);
-				wrn_printed[i] = true;
-			}
+	if (streams[idx].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
+		LOG_DBG("Stream %d not in streaming state", idx);
+		return 0;
+	}
 
-			return -ENOMEM;
+	if (is_iso_buffer_full(idx)) {
+		if (!wrn_printed[idx]) {
+			LOG_WRN("HCI ISO TX overrun on ch %d - Single print", idx);
+			wrn_printed[idx] = true;
 		}
 
-		wrn_printed[i] = false;
+		iso_tx_stats_overrun(idx);
 
-		buf = net_buf_alloc(iso_tx_pools[i], K_NO_WAIT);
-		if (buf == NULL) {
-			/* This should never occur because of the is_iso_buffer_full() check */
-			LOG_WRN("Out of TX buffers");
-			return -ENOMEM;
-		}
+		return -ENOMEM;
+	}
 
-		net_buf_reserve(buf, BT_ISO_CHAN_SEND_RESERVE);
-		net_buf_add_mem(buf, &data[i * data_size], data_size);
+	wrn_printed[idx] = false;
 
-		atomic_inc(&iso_tx_pool_alloc[i]);
+	*buf = net_buf_alloc(iso_tx_pools[idx], K_NO_WAIT);
+	if (*buf == NULL) {
+		/* This should never occur because of the is_iso_buffer_full() check */
+		LOG_WRN("Out of TX buffers");
+		return -ENOMEM;
+	}
 
-		ret = bt_audio_stream_send(&streams[i], buf, seq_num[i]++, BT_ISO_TIMESTAMP_NONE);
-		if (ret < 0) {
-			LOG_WRN("Failed to send audio data: %d", ret);
-			net_buf_unref(buf);
-			atomic_dec(&iso_tx_pool_alloc[i]);
-			return ret;
-		}
+	net_buf_reserve(*buf, BT_ISO_CHAN_SEND_RESERVE);
+
+	atomic_inc(&iso_tx_pool_alloc[idx]);
+
+	return 0;
+}
+
+static int iso_tx_buf_send(uint8_t idx, struct net_buf *buf)
+{
+	int ret;
+
+	iso_tx_stats_send(idx, atomic_get(&iso_tx_pool_alloc[idx]));
+
+	ret = bt_audio_stream_send(&streams[idx], buf, seq_num[idx]++, BT_ISO_TIMESTAMP_NONE);
+	if (ret < 0) {
+		LOG_WRN("Failed to send audio data: %d", ret);
+		net_buf_unref(buf);
+		atomic_dec(&iso_tx_pool_alloc[idx]);
+		iso_tx_stats_send_cancel(idx);
+		return ret;
 	}
 
+	return 0;
+}
+
+static void tx_anchor_update(void)
+{
 #if (CONFIG_AUDIO_SOURCE_I2S)
+	int ret;
 	struct bt_iso_tx_info tx_info = { 0 };
 
 	ret = bt_iso_chan_get_tx_sync(streams[0].iso, &tx_info);
@@ -269,10 +289,115 @@ int le_audio_send(uint8_t const *const data, size_t size)
 		audio_datapath_sdu_ref_update(tx_info.ts);
 	}
 #endif
+}
+
+int le_audio_send(uint8_t const *const data, size_t size)
+{
+	int ret;
+	struct net_buf *buf;
+	size_t num_streams = ARRAY_SIZE(streams);
+	size_t data_size = size / num_streams;
+
+	for (size_t i = 0U; i < num_streams; i++) {
+		ret = iso_tx_buf_alloc(i, &buf);
+		if (ret) {
+			return ret;
+		}
+
+		if (buf == NULL) {
+			continue;
+		}
+
+		net_buf_add_mem(buf, &data[i * data_size], data_size);
+
+		ret = iso_tx_buf_send(i, buf);
+		if (ret) {
+			return ret;
+		}
+	}
+
+	tx_anchor_update();
 
 	return 0;
 }
 
+#if (CONFIG_ENCODE_TO_TX_BUF)
+static struct net_buf *tx_bufs[ARRAY_SIZE(streams)];
+
+int le_audio_tx_bufs_alloc(uint8_t *data[], size_t num, size_t size)
+{
+	int ret;
+	bool reserved = false;
+
+	if (num < ARRAY_SIZE(streams)) {
+		LOG_ERR("Not enough entries for all streams");
+		return -EINVAL;
+	}
+
+	for (size_t i = 0U; i < ARRAY_SIZE(streams); i++) {
+		data[i] = NULL;
+
+		ret = iso_tx_buf_alloc(i, &tx_bufs[i]);
+		if (ret || tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		if (net_buf_tailroom(tx_bufs[i]) < size) {
+			LOG_ERR("TX buffer too small for SDU");
+			le_audio_tx_bufs_free();
+			return -ENOMEM;
+		}
+
+		data[i] = net_buf_tail(tx_bufs[i]);
+		reserved = true;
+	}
+
+	if (!reserved) {
+		return -ECANCELED;
+	}
+
+	return 0;
+}
+
+int le_audio_tx_bufs_send(size_t size)
+{
+	int ret;
+	int err = 0;
+
+	for (size_t i = 0U; i < ARRAY_SIZE(streams); i++) {
+		if (tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		net_buf_add(tx_bufs[i], size);
+
+		ret = iso_tx_buf_send(i, tx_bufs[i]);
+		if (ret) {
+			err = ret;
+		}
+
+		tx_bufs[i] = NULL;
+	}
+
+	tx_anchor_update();
+
+	return err;
+}
+
+void le_audio_tx_bufs_free(void)
+{
+	for (size_t i = 0U; i < ARRAY_SIZE(streams); i++) {
+		if (tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		net_buf_unref(tx_bufs[i]);
+		atomic_dec(&iso_tx_pool_alloc[i]);
+		tx_bufs[i] = NULL;
+	}
+}
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
+
 int le_audio_enable(le_audio_receive_cb recv_cb)
 {
 	int ret;
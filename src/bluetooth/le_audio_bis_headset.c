@@ -17,6 +17,7 @@
 #include "ctrl_events.h"
 #include "hw_codec.h"
 #include "channel_assignment.h"
+#include "iso_rx_stats.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(bis_headset, CONFIG_LOG_BLE_LEVEL);
@@ -46,6 +47,70 @@ static bool playing_state = true;
 
 static int bis_headset_cleanup(bool from_sync_lost_cb);
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+/* Scan continuously while re-syncing, to catch the source's next advertisement */
+#define BT_LE_SCAN_RESYNC                                                                          \
+	BT_LE_SCAN_PARAM(BT_LE_SCAN_TYPE_PASSIVE, BT_LE_SCAN_OPT_NONE, BT_GAP_SCAN_FAST_INTERVAL,  \
+			 BT_GAP_SCAN_FAST_INTERVAL)
+
+/* Last broadcast source synced to. Used to re-sync after a dropout */
+static struct {
+	bool valid;
+	/* Re-sync to the cached source in progress */
+	bool active;
+	bt_addr_le_t addr;
+	uint8_t sid;
+	uint32_t broadcast_id;
+	uint32_t bis_index_bitfield;
+	/* Codec parameters compared against a fresh BASE. The codec itself
+	 * points into BASE storage, so it is not kept
+	 */
+	int freq;
+	int frame_duration_us;
+	int octets_per_frame;
+	/* Uptime when sync was lost, 0 if no dropout is being measured */
+	int64_t lost_ms;
+	bool lost_fast;
+} resync;
+
+static void resync_timeout_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(resync_timeout_work, resync_timeout_work_handler);
+
+static void resync_timeout_work_handler(struct k_work *work)
+{
+	int ret;
+
+	if (!resync.active) {
+		return;
+	}
+
+	LOG_WRN("Cached broadcast source not found, scanning for any source");
+
+	resync.active = false;
+	resync.valid = false;
+	resync.lost_fast = false;
+
+	ret = bt_audio_broadcast_sink_scan_stop();
+	if (ret && ret != -EALREADY) {
+		LOG_ERR("Unable to stop scanning: %d", ret);
+		return;
+	}
+
+	ret = bt_audio_broadcast_sink_scan_start(BT_LE_SCAN_PASSIVE);
+	if (ret) {
+		LOG_ERR("Unable to start scanning for broadcast sources");
+	}
+}
+
+static bool resync_codec_match(const struct bt_codec *codec)
+{
+	return bt_codec_cfg_get_freq(codec) == resync.freq &&
+	       bt_codec_cfg_get_frame_duration_us(codec) == resync.frame_duration_us &&
+	       bt_codec_cfg_get_octets_per_frame(codec) == resync.octets_per_frame;
+}
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 static void print_codec(const struct bt_codec *codec)
 {
 	if (codec->id == BT_CODEC_LC3_ID) {
@@ -103,12 +168,22 @@ static void stream_started_cb(struct bt_audio_stream *stream)
 	ERR_CHK(ret);
 
 	LOG_INF("Stream started");
+
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	if (resync.lost_ms) {
+		LOG_INF("Time to audio after sync loss: %d ms (%s re-sync)",
+			(int)(k_uptime_get() - resync.lost_ms), resync.lost_fast ? "fast" : "full");
+		resync.lost_ms = 0;
+	}
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
 }
 
 static void stream_stopped_cb(struct bt_audio_stream *stream)
 {
 	int ret;
 
+	iso_rx_stats_stream_stopped(stream - streams);
+
 	ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_NOT_STREAMING);
 	ERR_CHK(ret);
 
@@ -130,7 +205,9 @@ static void stream_recv_cb(struct bt_audio_stream *stream, const struct bt_iso_r
 		bad_frame = true;
 	}
 
-	receive_cb(buf->data, buf->len, bad_frame, info->ts);
+	iso_rx_stats_recv(stream - streams, info->ts, bad_frame);
+
+	receive_cb(buf->data, buf->len, bad_frame, info->ts, buf);
 
 	recv_cnt++;
 	if ((recv_cnt % 1000U) == 0U) {
@@ -147,10 +224,28 @@ static bool scan_recv_cb(const struct bt_le_scan_recv_info *info, struct net_buf
 {
 	char name[DEVICE_NAME_PEER_LEN];
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	if (resync.active) {
+		if (broadcast_id == resync.broadcast_id && info->sid == resync.sid &&
+		    bt_addr_le_cmp(info->addr, &resync.addr) == 0) {
+			LOG_INF("Cached broadcast source found");
+			return true;
+		}
+
+		return false;
+	}
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 	bt_data_parse(ad, adv_data_parse, (void *)name);
 
 	if (strcmp(name, DEVICE_NAME_PEER) == 0) {
 		LOG_INF("Broadcast source %s found", name);
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+		/* Cached once synced, see syncable_cb */
+		bt_addr_le_copy(&resync.addr, info->addr);
+		resync.sid = info->sid;
+		resync.broadcast_id = broadcast_id;
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
 		return true;
 	}
 
@@ -176,6 +271,10 @@ static void pa_synced_cb(struct bt_audio_broadcast_sink *sink, struct bt_le_per_
 
 	broadcast_sink = sink;
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	k_work_cancel_delayable(&resync_timeout_work);
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 	LOG_DBG("Broadcast source PA synced, waiting for BASE");
 }
 
@@ -196,6 +295,25 @@ static void pa_sync_lost_cb(struct bt_audio_broadcast_sink *sink)
 		return;
 	}
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	resync.lost_ms = k_uptime_get();
+	resync.active = resync.valid;
+	resync.lost_fast = resync.valid;
+
+	if (resync.active) {
+		LOG_INF("Re-syncing to cached broadcast source");
+
+		ret = bt_audio_broadcast_sink_scan_start(BT_LE_SCAN_RESYNC);
+		if (ret) {
+			LOG_ERR("Unable to start scanning for cached broadcast source");
+		}
+
+		k_work_reschedule(&resync_timeout_work,
+				  K_MSEC(CONFIG_BLE_BIS_FAST_RESYNC_TIMEOUT_MS));
+		return;
+	}
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 	LOG_INF("Restarting scanning for broadcast sources");
 
 	ret = bt_audio_broadcast_sink_scan_start(BT_LE_SCAN_PASSIVE);
@@ -229,6 +347,36 @@ static void base_recv_cb(struct bt_audio_broadcast_sink *sink, const struct bt_a
 
 	LOG_DBG("Received BASE with %u subgroup(s) from broadcast sink", base->subgroup_count);
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	if (resync.active) {
+		/* Reuse the cached configuration if the source has not changed it */
+		for (size_t i = 0U; i < base->subgroup_count; i++) {
+			for (size_t j = 0U; j < base->subgroups[i].bis_count; j++) {
+				const uint8_t index = base->subgroups[i].bis_data[j].index;
+
+				if (index == channel &&
+				    (BIT(index) & bis_index_mask) == resync.bis_index_bitfield &&
+				    resync_codec_match(&base->subgroups[i].codec)) {
+					streams[i].codec =
+						(struct bt_codec *)&base->subgroups[i].codec;
+					bis_index_bitfield = resync.bis_index_bitfield;
+
+					ret = ctrl_events_le_audio_event_send(
+						LE_AUDIO_EVT_CONFIG_RECEIVED);
+					ERR_CHK(ret);
+
+					LOG_DBG("Cached configuration reused, waiting for syncable");
+					return;
+				}
+			}
+		}
+
+		LOG_INF("Broadcast configuration changed, parsing BASE");
+		resync.active = false;
+		resync.lost_fast = false;
+	}
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 	/* Search each subgroup for the BIS of interest */
 	for (size_t i = 0U; i < base->subgroup_count; i++) {
 		for (size_t j = 0U; j < base->subgroups[i].bis_count; j++) {
@@ -285,6 +433,26 @@ static void syncable_cb(struct bt_audio_broadcast_sink *sink, bool encrypted)
 	}
 
 	init_routine_completed = true;
+
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	if (!resync.active) {
+		for (size_t i = 0U; i < ARRAY_SIZE(streams); i++) {
+			if (streams[i].codec != NULL) {
+				resync.freq = bt_codec_cfg_get_freq(streams[i].codec);
+				resync.frame_duration_us =
+					bt_codec_cfg_get_frame_duration_us(streams[i].codec);
+				resync.octets_per_frame =
+					bt_codec_cfg_get_octets_per_frame(streams[i].codec);
+				break;
+			}
+		}
+
+		resync.bis_index_bitfield = bis_index_bitfield;
+		resync.valid = true;
+	}
+
+	resync.active = false;
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
 }
 
 static struct bt_audio_broadcast_sink_cb broadcast_sink_cbs = { .scan_recv = scan_recv_cb,
@@ -434,6 +602,13 @@ int le_audio_enable(le_audio_receive_cb recv_cb)
 
 	initialize(recv_cb);
 
+#if (CONFIG_BLE_BIS_FAST_RESYNC)
+	/* Only sync losses are re-synced through the cache */
+	k_work_cancel_delayable(&resync_timeout_work);
+	resync.active = false;
+	resync.lost_ms = 0;
+#endif /* (CONFIG_BLE_BIS_FAST_RESYNC) */
+
 	ret = bis_headset_cleanup(false);
 	if (ret) {
 		LOG_ERR("Error cleaning up");
@@ -13,8 +13,20 @@
 #include "macros_common.h"
 #include "ctrl_events.h"
 #include "audio_datapath.h"
+#include "iso_tx_stats.h"
 #include "ble_audio_services.h"
 #include "channel_assignment.h"
+#include "headset_slot.h"
+#if (CONFIG_BLE_CIS_RECONNECT_CACHE)
+#include "ble_bond_cache.h"
+#endif /* (CONFIG_BLE_CIS_RECONNECT_CACHE) */
+#if (CONFIG_ENCODE_SCHED)
+#include "encode_sched.h"
+#endif /* (CONFIG_ENCODE_SCHED) */
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+#include <zephyr/shell/shell.h>
+#include <zephyr/timing/timing.h>
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(cis_gateway, CONFIG_LOG_BLE_LEVEL);
@@ -40,7 +52,10 @@ LISTIFY(CONFIG_BT_ISO_MAX_CHAN, NET_BUF_POOL_ITERATE, (;))
 			 CONFIG_BLE_ACL_SLAVE_LATENCY, CONFIG_BLE_ACL_SUP_TIMEOUT)
 #define CIS_CONN_RETRY_TIMES 5
 
-static struct bt_conn *headset_conn[CONFIG_BT_MAX_CONN];
+BUILD_ASSERT(CONFIG_BT_AUDIO_UNICAST_CLIENT_ASE_SNK_COUNT >= CONFIG_BT_ISO_MAX_CHAN,
+	     "One sink ASE is needed per headset");
+
+static struct bt_conn *headset_conn[CONFIG_BT_ISO_MAX_CHAN];
 static struct bt_audio_stream audio_streams[CONFIG_BT_AUDIO_UNICAST_CLIENT_ASE_SNK_COUNT];
 static struct bt_audio_unicast_group *unicast_group;
 static struct bt_codec *remote_codecs[CONFIG_BT_AUDIO_UNICAST_CLIENT_PAC_COUNT];
@@ -67,6 +82,28 @@ static struct k_work_delayable stream_start_work[CONFIG_BT_ISO_MAX_CHAN];
 static uint8_t bonded_num;
 static bool playing_state = true;
 
+/* Setup progress of each ACL connection, indexed by bt_conn_index() */
+static struct conn_setup {
+	int64_t connect_ms;
+	int64_t secure_ms;
+	int64_t discovered_ms;
+	int64_t started_ms;
+	bool first_sdu_pending;
+	/* Discovery results are cached from an earlier connection */
+	bool cached;
+	bool vcs_deferred;
+} conn_setup[CONFIG_BT_MAX_CONN];
+
+/* Reference held on each ACL link, indexed by bt_conn_index() */
+static struct bt_conn *acl_conn[CONFIG_BT_MAX_CONN];
+
+/* Uptime when connecting started with no headset connected, 0 once all are streaming */
+static int64_t all_streaming_start_ms;
+
+#if (CONFIG_BLE_ACL_ACCEPT_LIST)
+static bool auto_connect_active;
+#endif /* (CONFIG_BLE_ACL_ACCEPT_LIST) */
+
 static void ble_acl_start_scan(void);
 static bool ble_acl_gateway_all_links_connected(void);
 
@@ -143,26 +180,155 @@ static uint32_t get_and_incr_seq_num(const struct bt_audio_stream *stream)
 	return 0;
 }
 
+static int headset_slot_assign(struct bt_conn *conn, enum audio_channel channel)
+{
+	int slot = headset_slot_take(headset_conn, ARRAY_SIZE(headset_conn), conn, channel);
+
+	if (slot < 0) {
+		return slot;
+	}
+
+	LOG_DBG("Headset assigned to slot %d", slot);
+
+	return 0;
+}
+
+static uint8_t streaming_num_get(void)
+{
+	uint8_t num = 0;
+
+	for (size_t i = 0U; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (audio_streams[i].ep != NULL &&
+		    audio_streams[i].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
+			num++;
+		}
+	}
+
+	return num;
+}
+
+static void conn_setup_first_sdu_check(uint8_t iso_chan_idx)
+{
+	struct bt_conn *conn = audio_streams[iso_chan_idx].conn;
+	struct conn_setup *setup;
+
+	if (conn == NULL) {
+		return;
+	}
+
+	setup = &conn_setup[bt_conn_index(conn)];
+
+	if (!setup->first_sdu_pending) {
+		return;
+	}
+
+	setup->first_sdu_pending = false;
+
+	LOG_INF("Headset %d first SDU %d ms after connect (%s discovery)", iso_chan_idx,
+		(int)(k_uptime_get() - setup->connect_ms), setup->cached ? "cached" : "full");
+	LOG_INF("\tSecurity: %d ms, discovery: %d ms, stream start: %d ms",
+		(int)(setup->secure_ms - setup->connect_ms),
+		(int)(setup->discovered_ms - setup->secure_ms),
+		(int)(setup->started_ms - setup->discovered_ms));
+}
+
+#if (CONFIG_BLE_CIS_RECONNECT_CACHE)
+static void reconnect_cache_apply(struct bt_conn *conn)
+{
+	int ret;
+	struct ble_bond_cache_entry entry;
+
+	ret = ble_bond_cache_get(bt_conn_get_dst(conn), &entry);
+	if (ret) {
+		return;
+	}
+
+	/* Take the slot now instead of waiting for the PACS location read */
+	ret = headset_slot_assign(conn, entry.channel);
+	if (ret) {
+		LOG_WRN("No free slot for cached headset");
+		return;
+	}
+
+	conn_setup[bt_conn_index(conn)].cached = true;
+
+	LOG_DBG("Using cached discovery results");
+}
+
+static void reconnect_cache_update(struct bt_conn *conn, uint8_t conn_index,
+				   uint8_t snk_codec_num)
+{
+	int ret;
+	struct ble_bond_cache_entry entry = { 0 };
+
+	bt_addr_le_copy(&entry.addr, bt_conn_get_dst(conn));
+	entry.channel = HEADSET_SLOT_CH(conn_index);
+	entry.snk_codec_num = snk_codec_num;
+	entry.snk_ep_found = (sinks[conn_index].ep != NULL);
+
+	if (!entry.snk_ep_found) {
+		(void)ble_bond_cache_delete(&entry.addr);
+		return;
+	}
+
+	ret = ble_bond_cache_store(&entry);
+	if (ret) {
+		LOG_WRN("Failed to cache discovery results: %d", ret);
+	}
+}
+#endif /* (CONFIG_BLE_CIS_RECONNECT_CACHE) */
+
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+/* Cost of handing one frame to all streaming headsets, per number of streaming headsets */
+static struct tx_cost {
+	uint32_t frames;
+	uint64_t cycles_total;
+	uint32_t cycles_max;
+} tx_cost[CONFIG_BT_ISO_MAX_CHAN + 1];
+static timing_t tx_cost_start;
+
+static void tx_cost_begin(void)
+{
+	tx_cost_start = timing_counter_get();
+}
+
+static void tx_cost_end(void)
+{
+	timing_t end = timing_counter_get();
+	uint32_t cycles = (uint32_t)timing_cycles_get(&tx_cost_start, &end);
+	struct tx_cost *cost = &tx_cost[streaming_num_get()];
+
+	cost->frames++;
+	cost->cycles_total += cycles;
+	cost->cycles_max = MAX(cost->cycles_max, cycles);
+}
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
+
 static void unicast_client_location_cb(struct bt_conn *conn, enum bt_audio_dir dir,
 				       enum bt_audio_location loc)
 {
 	int ret;
 
+	/* A slot taken from an outdated cache entry is released by headset_slot_assign */
 	if (loc == BT_AUDIO_LOCATION_FRONT_LEFT) {
-		headset_conn[AUDIO_CH_L] = conn;
+		ret = headset_slot_assign(conn, AUDIO_CH_L);
 	} else if (loc == BT_AUDIO_LOCATION_FRONT_RIGHT) {
-		headset_conn[AUDIO_CH_R] = conn;
+		ret = headset_slot_assign(conn, AUDIO_CH_R);
 	} else {
 		LOG_ERR("Channel location not supported");
+		ret = -ENOTSUP;
+	}
+
+	if (ret) {
+		if (ret == -ENOMEM) {
+			LOG_ERR("No free slot for headset at location %d", loc);
+		}
+
 		ret = bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
 		if (ret) {
 			LOG_ERR("Failed to disconnect %d", ret);
 		}
 	}
-
-	if (!ble_acl_gateway_all_links_connected()) {
-		ble_acl_start_scan();
-	}
 }
 
 static void available_contexts_cb(struct bt_conn *conn, enum bt_audio_context snk_ctx,
@@ -207,6 +373,7 @@ static void stream_sent_cb(struct bt_audio_stream *stream)
 		LOG_ERR("Stream not found");
 	} else {
 		atomic_dec(&iso_tx_pool_alloc[channel_index]);
+		iso_tx_stats_sent(channel_index);
 	}
 }
 
@@ -309,6 +476,32 @@ static void stream_started_cb(struct bt_audio_stream *stream)
 
 	LOG_INF("Stream %p started", (void *)stream);
 
+	if (stream->conn != NULL) {
+		struct conn_setup *setup = &conn_setup[bt_conn_index(stream->conn)];
+
+		setup->started_ms = k_uptime_get();
+
+		if (all_streaming_start_ms && streaming_num_get() == ARRAY_SIZE(headset_conn)) {
+			LOG_INF("All %d headsets streaming %d ms after connecting started",
+				CONFIG_BT_ISO_MAX_CHAN,
+				(int)(setup->started_ms - all_streaming_start_ms));
+			all_streaming_start_ms = 0;
+		}
+
+#if (CONFIG_BT_VCS_CLIENT)
+		uint8_t channel_index;
+
+		if (setup->vcs_deferred && !stream_index_get(stream, &channel_index)) {
+			setup->vcs_deferred = false;
+
+			ret = ble_vcs_discover(stream->conn, channel_index);
+			if (ret) {
+				LOG_ERR("Could not do VCS discover");
+			}
+		}
+#endif /* (CONFIG_BT_VCS_CLIENT) */
+	}
+
 	ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_STREAMING);
 	ERR_CHK(ret);
 }
@@ -335,10 +528,10 @@ static void stream_stopped_cb(struct bt_audio_stream *stream)
 		LOG_ERR("Stream not found");
 	} else {
 		atomic_clear(&iso_tx_pool_alloc[channel_index]);
+		iso_tx_stats_stream_stopped(channel_index);
 	}
 
-	if (audio_streams[AUDIO_CH_L].ep->status.state != BT_AUDIO_EP_STATE_STREAMING &&
-	    audio_streams[AUDIO_CH_R].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
+	if (streaming_num_get() == 0) {
 		ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_NOT_STREAMING);
 		ERR_CHK(ret);
 	}
@@ -367,7 +560,7 @@ static struct bt_audio_stream_ops stream_ops = {
 
 static void add_remote_sink(struct bt_audio_ep *ep, uint8_t index)
 {
-	if (index > sizeof(sinks)) {
+	if (index >= ARRAY_SIZE(sinks)) {
 		LOG_ERR("Sink index is out of range");
 	} else {
 		sinks[index].ep = ep;
@@ -385,6 +578,21 @@ static void add_remote_codec(struct bt_codec *codec, int index, uint8_t type)
 	}
 }
 
+/* Drop a link whose setup failed, so it does not hold a headset slot and the
+ * headset can be found and set up again
+ */
+static void conn_setup_abort(struct bt_conn *conn)
+{
+	int ret;
+
+	ret = bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	if (ret) {
+		LOG_ERR("Failed to disconnect %d", ret);
+	}
+
+	ble_acl_start_scan();
+}
+
 static void discover_sink_cb(struct bt_conn *conn, struct bt_codec *codec, struct bt_audio_ep *ep,
 			     struct bt_audio_discover_params *params)
 {
@@ -394,6 +602,7 @@ static void discover_sink_cb(struct bt_conn *conn, struct bt_codec *codec, struc
 
 	if (params->err) {
 		LOG_ERR("Discovery failed: %d", params->err);
+		conn_setup_abort(conn);
 		return;
 	}
 
@@ -420,6 +629,8 @@ static void discover_sink_cb(struct bt_conn *conn, struct bt_codec *codec, struc
 
 	LOG_DBG("Discover complete: err %d", params->err);
 
+	uint8_t snk_codec_num = params->num_caps;
+
 	(void)memset(params, 0, sizeof(*params));
 
 	ret = headset_conn_index_get(conn, &conn_index);
@@ -427,10 +638,27 @@ static void discover_sink_cb(struct bt_conn *conn, struct bt_codec *codec, struc
 	if (ret) {
 		LOG_ERR("Unknown connection, should not reach here");
 	} else {
+		struct conn_setup *setup = &conn_setup[bt_conn_index(conn)];
+
+		setup->discovered_ms = k_uptime_get();
+
+#if (CONFIG_BLE_CIS_RECONNECT_CACHE)
+		reconnect_cache_update(conn, conn_index, snk_codec_num);
+#else
+		ARG_UNUSED(snk_codec_num);
+#endif /* (CONFIG_BLE_CIS_RECONNECT_CACHE) */
+
 #if (CONFIG_BT_VCS_CLIENT)
-		ret = ble_vcs_discover(conn, conn_index);
-		if (ret) {
-			LOG_ERR("Could not do VCS discover");
+		if (setup->cached) {
+			/* Volume control is not needed to start streaming, so a known
+			 * headset is configured first and VCS is discovered once streaming
+			 */
+			setup->vcs_deferred = true;
+		} else {
+			ret = ble_vcs_discover(conn, conn_index);
+			if (ret) {
+				LOG_ERR("Could not do VCS discover");
+			}
 		}
 #endif /* (CONFIG_BT_VCS_CLIENT) */
 		ret = bt_audio_stream_config(conn, &audio_streams[conn_index], sinks[conn_index].ep,
@@ -441,14 +669,26 @@ static void discover_sink_cb(struct bt_conn *conn, struct bt_codec *codec, struc
 	}
 }
 
+static void acl_conn_count(struct bt_conn *conn, void *data)
+{
+	uint8_t *num = data;
+
+	(*num)++;
+}
+
+/* Includes links still connecting or being set up */
+static uint8_t acl_conn_num_get(void)
+{
+	uint8_t num = 0;
+
+	bt_conn_foreach(BT_CONN_TYPE_LE, acl_conn_count, &num);
+
+	return num;
+}
+
 static bool ble_acl_gateway_all_links_connected(void)
 {
-	for (size_t i = 0; i < ARRAY_SIZE(headset_conn); i++) {
-		if (headset_conn[i] == NULL) {
-			return false;
-		}
-	}
-	return true;
+	return acl_conn_num_get() >= ARRAY_SIZE(headset_conn);
 }
 
 static void bond_check(const struct bt_bond_info *info, void *user_data)
@@ -480,7 +720,10 @@ static void bond_connect(const struct bt_bond_info *info, void *user_data)
 		if (ret) {
 			LOG_WRN("Create ACL connection failed: %d", ret);
 			ble_acl_start_scan();
+			return;
 		}
+
+		acl_conn[bt_conn_index(conn)] = conn;
 	}
 }
 
@@ -512,6 +755,8 @@ static int device_found(uint8_t type, const uint8_t *data, uint8_t data_len,
 			return ret;
 		}
 
+		acl_conn[bt_conn_index(conn)] = conn;
+
 		return 0;
 	}
 
@@ -561,17 +806,125 @@ static void on_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
 	}
 }
 
+#if (CONFIG_BLE_ACL_ACCEPT_LIST)
+static void accept_list_add(const struct bt_bond_info *info, void *user_data)
+{
+	int ret;
+	uint8_t *num = user_data;
+	struct bt_conn *conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, &info->addr);
+
+	if (conn != NULL) {
+		/* Already connected */
+		bt_conn_unref(conn);
+		return;
+	}
+
+	ret = bt_le_filter_accept_list_add(&info->addr);
+	if (ret) {
+		LOG_WRN("Failed to add bond to accept list: %d", ret);
+		return;
+	}
+
+	(*num)++;
+}
+
+/* Let the controller connect to the first bonded headset it hears from,
+ * without parsing advertisements on the host
+ */
+static int accept_list_connect_start(void)
+{
+	int ret;
+	uint8_t num = 0;
+	int free_links = (int)ARRAY_SIZE(headset_conn) - acl_conn_num_get();
+
+	ret = bt_le_filter_accept_list_clear();
+	if (ret) {
+		return ret;
+	}
+
+	bt_foreach_bond(BT_ID_DEFAULT, accept_list_add, &num);
+
+	/* Headsets that are not bonded yet can only be found by scanning */
+	if (num < free_links) {
+		return -ENOENT;
+	}
+
+	ret = bt_le_scan_stop();
+	if (ret && ret != -EALREADY) {
+		LOG_WRN("Stop scan failed: %d", ret);
+	}
+
+	ret = bt_conn_le_create_auto(BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_MULTI);
+	if (ret) {
+		return ret;
+	}
+
+	auto_connect_active = true;
+
+	LOG_INF("Connecting to %d bonded headset(s) from accept list", num);
+
+	return 0;
+}
+
+static void accept_list_connect_stop(void)
+{
+	int ret;
+
+	if (!auto_connect_active) {
+		return;
+	}
+
+	ret = bt_conn_create_auto_stop();
+	if (ret) {
+		LOG_WRN("Failed to stop auto connect: %d", ret);
+	}
+
+	auto_connect_active = false;
+}
+#endif /* (CONFIG_BLE_ACL_ACCEPT_LIST) */
+
+static void acl_conn_release(struct bt_conn *conn)
+{
+	uint8_t index = bt_conn_index(conn);
+
+	if (acl_conn[index] != NULL) {
+		bt_conn_unref(acl_conn[index]);
+		acl_conn[index] = NULL;
+	}
+}
+
 static void ble_acl_start_scan(void)
 {
 	int ret;
 
+	if (acl_conn_num_get() == 0) {
+		all_streaming_start_ms = k_uptime_get();
+	}
+
 	/* Reset number of bonds found */
 	bonded_num = 0;
 
 	bt_foreach_bond(BT_ID_DEFAULT, bond_check, NULL);
 
+#if (CONFIG_BLE_ACL_ACCEPT_LIST)
+	if (auto_connect_active) {
+		return;
+	}
+
+	if (bonded_num) {
+		ret = accept_list_connect_start();
+		if (ret == 0) {
+			return;
+		} else if (ret != -ENOENT) {
+			LOG_WRN("Accept list connect failed: %d, scanning instead", ret);
+		}
+	}
+#endif /* (CONFIG_BLE_ACL_ACCEPT_LIST) */
+
 	ret = bt_le_scan_start(BT_LE_SCAN_ACTIVE, on_device_found);
-	if (ret) {
+	if (ret == -EALREADY) {
+		return;
+	} else if (ret) {
 		LOG_WRN("Scanning failed to start: %d", ret);
 		return;
 	}
@@ -586,63 +939,80 @@ static void connected_cb(struct bt_conn *conn, uint8_t err)
 
 	(void)bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
+#if (CONFIG_BLE_ACL_ACCEPT_LIST)
+	/* Auto connect ends with the first connection */
+	auto_connect_active = false;
+#endif /* (CONFIG_BLE_ACL_ACCEPT_LIST) */
+
 	if (err) {
 		LOG_ERR("ACL connection to %s failed, error %d", addr, err);
 
-		bt_conn_unref(conn);
+		acl_conn_release(conn);
 		ble_acl_start_scan();
 
 		return;
 	}
 
+	if (acl_conn[bt_conn_index(conn)] == NULL) {
+		/* Connected from the accept list, no reference was handed out */
+		acl_conn[bt_conn_index(conn)] = bt_conn_ref(conn);
+	}
+
 	/* ACL connection established */
 	/* TODO: Setting TX power for connection if set to anything but 0 */
 	LOG_INF("Connected: %s", addr);
 
+	conn_setup[bt_conn_index(conn)] = (struct conn_setup){
+		.connect_ms = k_uptime_get(),
+		.first_sdu_pending = true,
+	};
+
 	ret = bt_conn_set_security(conn, BT_SECURITY_L2);
 	if (ret) {
 		LOG_ERR("Failed to set security to L2: %d", ret);
+		conn_setup_abort(conn);
+		return;
+	}
+
+	/* Set up the next headset while this one is secured and discovered. Each
+	 * link has its own reference in acl_conn[] and its own discovery params
+	 */
+	if (!ble_acl_gateway_all_links_connected()) {
+		ble_acl_start_scan();
 	}
 }
 
 static void disconnected_cb(struct bt_conn *conn, uint8_t reason)
 {
-	int ret;
-	uint8_t conn_index;
 	char addr[BT_ADDR_LE_STR_LEN];
 
 	(void)bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
 	LOG_INF("Disconnected: %s (reason 0x%02x)", addr, reason);
 
-	bt_conn_unref(conn);
+	acl_conn_release(conn);
 
-	ret = headset_conn_index_get(conn, &conn_index);
-	if (ret) {
+	if (headset_slot_release(headset_conn, ARRAY_SIZE(headset_conn), conn) == 0) {
 		LOG_WRN("Unknown connection");
-	} else {
-		headset_conn[conn_index] = NULL;
 	}
 
+#if (CONFIG_BLE_ACL_ACCEPT_LIST)
+	/* Rebuild the accept list to include the lost headset */
+	accept_list_connect_stop();
+#endif /* (CONFIG_BLE_ACL_ACCEPT_LIST) */
+
 	ble_acl_start_scan();
 }
 
 static int discover_sink(struct bt_conn *conn)
 {
-	int ret = 0;
-	static uint8_t conn_index;
-
-	audio_discover_param[conn_index].func = discover_sink_cb;
-	audio_discover_param[conn_index].dir = BT_AUDIO_DIR_SINK;
-	ret = bt_audio_discover(conn, &audio_discover_param[conn_index]);
-	conn_index++;
+	/* Params per link, discovery of several links may overlap */
+	struct bt_audio_discover_params *params = &audio_discover_param[bt_conn_index(conn)];
 
-	/* Avoid multiple discover procedure sharing the same params */
-	if (conn_index > CONFIG_BT_ISO_MAX_CHAN - 1) {
-		conn_index = 0;
-	}
+	params->func = discover_sink_cb;
+	params->dir = BT_AUDIO_DIR_SINK;
 
-	return ret;
+	return bt_audio_discover(conn, params);
 }
 
 static void security_changed_cb(struct bt_conn *conn, bt_security_t level, enum bt_security_err err)
@@ -655,11 +1025,21 @@ static void security_changed_cb(struct bt_conn *conn, bt_security_t level, enum
 		if (ret) {
 			LOG_ERR("Failed to disconnect %d", ret);
 		}
+
+		ble_acl_start_scan();
 	} else {
 		LOG_DBG("Security changed: level %d", level);
+
+		conn_setup[bt_conn_index(conn)].secure_ms = k_uptime_get();
+
+#if (CONFIG_BLE_CIS_RECONNECT_CACHE)
+		reconnect_cache_apply(conn);
+#endif /* (CONFIG_BLE_CIS_RECONNECT_CACHE) */
+
 		ret = discover_sink(conn);
 		if (ret) {
 			LOG_WRN("Failed to discover sink: %d", ret);
+			conn_setup_abort(conn);
 		}
 	}
 }
@@ -671,13 +1051,14 @@ static struct bt_conn_cb conn_callbacks = {
 
 };
 
-static int iso_stream_send(uint8_t const *const data, size_t size, uint8_t iso_chan_idx)
+static int iso_tx_buf_alloc(uint8_t iso_chan_idx, struct net_buf **buf)
 {
-	int ret;
 	static bool wrn_printed[CONFIG_BT_ISO_MAX_CHAN];
-	struct net_buf *buf;
 
-	if (audio_streams[iso_chan_idx].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
+	*buf = NULL;
+
+	if (audio_streams[iso_chan_idx].ep == NULL ||
+	    audio_streams[iso_chan_idx].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
 		LOG_DBG("Channel not connected %d", iso_chan_idx);
 		return 0;
 	}
@@ -688,23 +1069,33 @@ static int iso_stream_send(uint8_t const *const data, size_t size, uint8_t iso_c
 			wrn_printed[iso_chan_idx] = true;
 		}
 
+		iso_tx_stats_overrun(iso_chan_idx);
+
 		return -ENOMEM;
 	}
 
 	wrn_printed[iso_chan_idx] = false;
 
-	buf = net_buf_alloc(iso_tx_pools[iso_chan_idx], K_NO_WAIT);
-	if (buf == NULL) {
+	*buf = net_buf_alloc(iso_tx_pools[iso_chan_idx], K_NO_WAIT);
+	if (*buf == NULL) {
 		/* This should never occur because of the is_iso_buffer_full() check */
 		LOG_WRN("Out of TX buffers");
 		return -ENOMEM;
 	}
 
-	net_buf_reserve(buf, BT_ISO_CHAN_SEND_RESERVE);
-	net_buf_add_mem(buf, data, size);
+	net_buf_reserve(*buf, BT_ISO_CHAN_SEND_RESERVE);
 
 	atomic_inc(&iso_tx_pool_alloc[iso_chan_idx]);
 
+	return 0;
+}
+
+static void iso_tx_buf_send(uint8_t iso_chan_idx, struct net_buf *buf)
+{
+	int ret;
+
+	iso_tx_stats_send(iso_chan_idx, atomic_get(&iso_tx_pool_alloc[iso_chan_idx]));
+
 	ret = bt_audio_stream_send(&audio_streams[iso_chan_idx], buf,
 				   get_and_incr_seq_num(&audio_streams[iso_chan_idx]),
 				   BT_ISO_TIMESTAMP_NONE);
@@ -712,6 +1103,61 @@ static int iso_stream_send(uint8_t const *const data, size_t size, uint8_t iso_c
 		LOG_WRN("Failed to send audio data: %d", ret);
 		net_buf_unref(buf);
 		atomic_dec(&iso_tx_pool_alloc[iso_chan_idx]);
+		iso_tx_stats_send_cancel(iso_chan_idx);
+		return;
+	}
+
+	conn_setup_first_sdu_check(iso_chan_idx);
+}
+
+static int iso_stream_send(uint8_t const *const data, size_t size, uint8_t iso_chan_idx)
+{
+	int ret;
+	struct net_buf *buf;
+
+	ret = iso_tx_buf_alloc(iso_chan_idx, &buf);
+	if (ret || buf == NULL) {
+		return ret;
+	}
+
+	net_buf_add_mem(buf, data, size);
+	iso_tx_buf_send(iso_chan_idx, buf);
+
+	return 0;
+}
+
+static int tx_anchor_update(void)
+{
+	int ret = -ECANCELED;
+	struct bt_iso_tx_info tx_info = { 0 };
+
+	/* All CISes of the group share the same anchor points */
+	for (size_t i = 0U; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (audio_streams[i].ep != NULL &&
+		    audio_streams[i].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
+			ret = bt_iso_chan_get_tx_sync(audio_streams[i].iso, &tx_info);
+			break;
+		}
+	}
+
+	if (ret == -ECANCELED) {
+		LOG_DBG("No headset in stream state");
+		return ret;
+	}
+
+	if (ret) {
+		LOG_DBG("Error getting ISO TX anchor point: %d", ret);
+	}
+
+	if (tx_info.ts != 0 && !ret) {
+#if (CONFIG_AUDIO_SOURCE_I2S)
+		audio_datapath_sdu_ref_update(tx_info.ts);
+#endif
+#if (CONFIG_ENCODE_SCHED)
+		encode_sched_anchor_update(tx_info.ts);
+#else
+		audio_datapath_just_in_time_check_and_adjust(tx_info.ts);
+#endif /* (CONFIG_ENCODE_SCHED) */
 	}
 
 	return 0;
@@ -742,8 +1188,12 @@ static int initialize(le_audio_receive_cb recv_cb)
 
 	ARG_UNUSED(recv_cb);
 	if (!initialized) {
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+		timing_init();
+		timing_start();
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
 		bt_conn_cb_register(&conn_callbacks);
-		for (size_t i = 0; i < ARRAY_SIZE(audio_streams); i++) {
+		for (size_t i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
 			audio_streams[i].ops = &stream_ops;
 			group_params[i].stream = &audio_streams[i];
 			group_params[i].qos = &lc3_preset_nrf5340.qos;
@@ -811,23 +1261,16 @@ int le_audio_play(void)
 
 	playing_state = true;
 
-	if (audio_streams[AUDIO_CH_L].ep->status.state == BT_AUDIO_EP_STATE_QOS_CONFIGURED) {
-		ret = bt_audio_stream_enable(&audio_streams[AUDIO_CH_L],
-					     lc3_preset_nrf5340.codec.meta,
-					     lc3_preset_nrf5340.codec.meta_count);
-
-		if (ret) {
-			LOG_WRN("Failed to enable left stream");
+	for (size_t i = 0U; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (audio_streams[i].ep == NULL ||
+		    audio_streams[i].ep->status.state != BT_AUDIO_EP_STATE_QOS_CONFIGURED) {
+			continue;
 		}
-	}
 
-	if (audio_streams[AUDIO_CH_R].ep->status.state == BT_AUDIO_EP_STATE_QOS_CONFIGURED) {
-		ret = bt_audio_stream_enable(&audio_streams[AUDIO_CH_R],
-					     lc3_preset_nrf5340.codec.meta,
+		ret = bt_audio_stream_enable(&audio_streams[i], lc3_preset_nrf5340.codec.meta,
 					     lc3_preset_nrf5340.codec.meta_count);
-
 		if (ret) {
-			LOG_WRN("Failed to enable right stream");
+			LOG_WRN("Failed to enable stream %d", i);
 		}
 	}
 
@@ -840,19 +1283,15 @@ int le_audio_pause(void)
 
 	playing_state = false;
 
-	if (audio_streams[AUDIO_CH_L].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
-		ret = bt_audio_stream_disable(&audio_streams[AUDIO_CH_L]);
-
-		if (ret) {
-			LOG_WRN("Failed to disable left stream");
+	for (size_t i = 0U; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (audio_streams[i].ep == NULL ||
+		    audio_streams[i].ep->status.state != BT_AUDIO_EP_STATE_STREAMING) {
+			continue;
 		}
-	}
-
-	if (audio_streams[AUDIO_CH_R].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
-		ret = bt_audio_stream_disable(&audio_streams[AUDIO_CH_R]);
 
+		ret = bt_audio_stream_disable(&audio_streams[i]);
 		if (ret) {
-			LOG_WRN("Failed to disable right stream");
+			LOG_WRN("Failed to disable stream %d", i);
 		}
 	}
 
@@ -862,46 +1301,145 @@ int le_audio_pause(void)
 int le_audio_send(uint8_t const *const data, size_t size)
 {
 	int ret;
-	struct bt_iso_tx_info tx_info = { 0 };
 	size_t sdu_size = LE_AUDIO_SDU_SIZE_OCTETS(CONFIG_LC3_BITRATE);
 
-	if (size != sdu_size * CONFIG_BT_ISO_MAX_CHAN) {
+	if (size != sdu_size * AUDIO_CH_NUM) {
 		LOG_ERR("Not enough data for stereo stream");
 		return -ECANCELED;
 	}
 
-	if (audio_streams[AUDIO_CH_L].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
-		ret = bt_iso_chan_get_tx_sync(audio_streams[AUDIO_CH_L].iso, &tx_info);
-	} else if (audio_streams[AUDIO_CH_R].ep->status.state == BT_AUDIO_EP_STATE_STREAMING) {
-		ret = bt_iso_chan_get_tx_sync(audio_streams[AUDIO_CH_R].iso, &tx_info);
-	} else {
-		LOG_DBG("No headset in stream state");
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+	tx_cost_begin();
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
+
+	ret = tx_anchor_update();
+	if (ret) {
+		return ret;
+	}
+
+	for (size_t i = 0U; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		ret = iso_stream_send(&data[HEADSET_SLOT_CH(i) * sdu_size], sdu_size, i);
+		if (ret) {
+			LOG_DBG("Failed to send data to headset %d", i);
+		}
+	}
+
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+	tx_cost_end();
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
+
+	return 0;
+}
+
+#if (CONFIG_ENCODE_TO_TX_BUF)
+static struct net_buf *tx_bufs[CONFIG_BT_ISO_MAX_CHAN];
+/* Slot the encoder writes each channel into. Copied to the other slots of the channel on send */
+static int8_t tx_bufs_enc_slot[AUDIO_CH_NUM];
+
+int le_audio_tx_bufs_alloc(uint8_t *data[], size_t num, size_t size)
+{
+	int ret;
+	bool reserved = false;
+
+	if (num < AUDIO_CH_NUM) {
+		LOG_ERR("Not enough entries for stereo stream");
+		return -EINVAL;
+	}
+
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+	/* Encoding happens between alloc and send, so it is included in the cost */
+	tx_cost_begin();
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
+
+	for (int ch = 0; ch < AUDIO_CH_NUM; ch++) {
+		data[ch] = NULL;
+		tx_bufs_enc_slot[ch] = -1;
+	}
+
+	for (int i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		ret = iso_tx_buf_alloc(i, &tx_bufs[i]);
+		if (ret || tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		if (net_buf_tailroom(tx_bufs[i]) < size) {
+			LOG_ERR("TX buffer too small for SDU");
+			le_audio_tx_bufs_free();
+			return -ENOMEM;
+		}
+
+		if (tx_bufs_enc_slot[HEADSET_SLOT_CH(i)] < 0) {
+			tx_bufs_enc_slot[HEADSET_SLOT_CH(i)] = i;
+			data[HEADSET_SLOT_CH(i)] = net_buf_tail(tx_bufs[i]);
+		}
+
+		reserved = true;
+	}
+
+	if (!reserved) {
 		return -ECANCELED;
 	}
+
+	return 0;
+}
+
+int le_audio_tx_bufs_send(size_t size)
+{
+	int ret;
+
+	ret = tx_anchor_update();
 	if (ret) {
-		LOG_DBG("Error getting ISO TX anchor point: %d", ret);
+		le_audio_tx_bufs_free();
+		return ret;
 	}
 
-	if (tx_info.ts != 0 && !ret) {
-#if (CONFIG_AUDIO_SOURCE_I2S)
-		audio_datapath_sdu_ref_update(tx_info.ts);
-#endif
-		audio_datapath_just_in_time_check_and_adjust(tx_info.ts);
+	for (int ch = 0; ch < AUDIO_CH_NUM; ch++) {
+		if (tx_bufs_enc_slot[ch] >= 0) {
+			net_buf_add(tx_bufs[tx_bufs_enc_slot[ch]], size);
+		}
 	}
 
-	ret = iso_stream_send(data, sdu_size, AUDIO_CH_L);
-	if (ret) {
-		LOG_DBG("Failed to send data to left channel");
+	/* Copy before sending, as sending hands the encoded buffers over to the host */
+	for (int i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		int8_t enc_slot = tx_bufs_enc_slot[HEADSET_SLOT_CH(i)];
+
+		if (tx_bufs[i] == NULL || enc_slot == i) {
+			continue;
+		}
+
+		net_buf_add_mem(tx_bufs[i], tx_bufs[enc_slot]->data, size);
 	}
 
-	ret = iso_stream_send(&data[sdu_size], sdu_size, AUDIO_CH_R);
-	if (ret) {
-		LOG_DBG("Failed to send data to right channel");
+	for (int i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		iso_tx_buf_send(i, tx_bufs[i]);
+		tx_bufs[i] = NULL;
 	}
 
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+	tx_cost_end();
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
+
 	return 0;
 }
 
+void le_audio_tx_bufs_free(void)
+{
+	for (int i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		if (tx_bufs[i] == NULL) {
+			continue;
+		}
+
+		net_buf_unref(tx_bufs[i]);
+		atomic_dec(&iso_tx_pool_alloc[i]);
+		tx_bufs[i] = NULL;
+	}
+}
+#endif /* (CONFIG_ENCODE_TO_TX_BUF) */
+
 int le_audio_enable(le_audio_receive_cb recv_cb)
 {
 	int ret;
@@ -919,3 +1457,44 @@ int le_audio_disable(void)
 {
 	return 0;
 }
+
+#if (CONFIG_BLE_CIS_TX_COST_STATS)
+static int cmd_cis_tx_cost_show(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	for (size_t i = 1U; i < ARRAY_SIZE(tx_cost); i++) {
+		struct tx_cost *cost = &tx_cost[i];
+		uint32_t cycles_avg = cost->frames ? (cost->cycles_total / cost->frames) : 0;
+
+		shell_print(shell, "%d headset(s): frames: %u avg: %u us max: %u us", i,
+			    cost->frames, (uint32_t)timing_cycles_to_ns(cycles_avg) / NSEC_PER_USEC,
+			    (uint32_t)timing_cycles_to_ns(cost->cycles_max) / NSEC_PER_USEC);
+	}
+
+	return 0;
+}
+
+static int cmd_cis_tx_cost_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	memset(tx_cost, 0, sizeof(tx_cost));
+
+	shell_print(shell, "CIS TX cost statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(cis_tx_cost_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, show, NULL,
+					      "Show TX cost per number of streaming headsets",
+					      cmd_cis_tx_cost_show),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset TX cost statistics", cmd_cis_tx_cost_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(cis_tx_cost, &cis_tx_cost_cmd, "CIS gateway TX cost commands", NULL);
+#endif /* (CONFIG_BLE_CIS_TX_COST_STATS) */
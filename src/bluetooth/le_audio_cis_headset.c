@@ -17,6 +17,7 @@
 #include "ble_audio_services.h"
 #include "audio_datapath.h"
 #include "channel_assignment.h"
+#include "iso_rx_stats.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(cis_headset, CONFIG_LOG_BLE_LEVEL);
@@ -281,7 +282,9 @@ static void stream_recv_cb(struct bt_audio_stream *stream, const struct bt_iso_r
 		bad_frame = true;
 	}
 
-	receive_cb(buf->data, buf->len, bad_frame, info->ts);
+	iso_rx_stats_recv(0, info->ts, bad_frame);
+
+	receive_cb(buf->data, buf->len, bad_frame, info->ts, buf);
 
 	recv_cnt++;
 	if ((recv_cnt % 1000U) == 0U) {
@@ -295,6 +298,8 @@ static void stream_stop_cb(struct bt_audio_stream *stream)
 
 	LOG_INF("Stream stopped");
 
+	iso_rx_stats_stream_stopped(0);
+
 	ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_NOT_STREAMING);
 	ERR_CHK(ret);
 }
@@ -7,20 +7,122 @@
 #include "ctrl_events.h"
 
 #include <zephyr/kernel.h>
-#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
 #include <errno.h>
 
 #include "macros_common.h"
+#include "button_assignments.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(ctrl_events, CONFIG_LOG_CTRL_EVENTS_LEVEL);
 
-#define CTRL_EVENTS_MSGQ_MAX_ELEMENTS 5
 #define CTRL_EVENTS_MSGQ_ALIGNMENT_WORDS 4
 
-K_MSGQ_DEFINE(msg_queue, sizeof(struct event_t), CTRL_EVENTS_MSGQ_MAX_ELEMENTS,
+enum event_class {
+	EVT_CLASS_STATE,
+	EVT_CLASS_VOLUME,
+	EVT_CLASS_UI,
+	EVT_CLASS_NUM,
+};
+
+static const char *const event_class_names[EVT_CLASS_NUM] = {
+	"State",
+	"Volume",
+	"UI",
+};
+
+struct event_class_stats {
+	uint32_t put;
+	uint32_t dropped;
+	uint32_t coalesced;
+	uint32_t depth_max;
+};
+
+K_MSGQ_DEFINE(state_queue, sizeof(struct event_t), CONFIG_CTRL_EVENTS_STATE_QUEUE_SIZE,
+	      CTRL_EVENTS_MSGQ_ALIGNMENT_WORDS);
+K_MSGQ_DEFINE(ui_queue, sizeof(struct event_t), CONFIG_CTRL_EVENTS_UI_QUEUE_SIZE,
 	      CTRL_EVENTS_MSGQ_ALIGNMENT_WORDS);
 
+/* Given once per queued event, and once when volume becomes pending */
+static K_SEM_DEFINE(event_sem, 0, K_SEM_MAX_LIMIT);
+
+static atomic_t volume_delta;
+static atomic_t volume_pending;
+
+static struct event_class_stats stats[EVT_CLASS_NUM];
+static struct k_spinlock stats_lock;
+
+static enum event_class event_class_get(struct event_t const *const event)
+{
+	if (event->event_source == EVT_SRC_LE_AUDIO) {
+		return EVT_CLASS_STATE;
+	}
+
+	if (event->event_source == EVT_SRC_BUTTON &&
+	    event->button_activity.button_action == BUTTON_PRESS &&
+	    (event->button_activity.button_pin == BUTTON_VOLUME_UP ||
+	     event->button_activity.button_pin == BUTTON_VOLUME_DOWN)) {
+		return EVT_CLASS_VOLUME;
+	}
+
+	return EVT_CLASS_UI;
+}
+
+static int queue_put(struct k_msgq *queue, enum event_class class, struct event_t *event)
+{
+	int ret;
+	k_spinlock_key_t key;
+
+	ret = k_msgq_put(queue, (void *)event, K_NO_WAIT);
+
+	key = k_spin_lock(&stats_lock);
+
+	if (ret) {
+		stats[class].dropped++;
+	} else {
+		stats[class].put++;
+		stats[class].depth_max = MAX(stats[class].depth_max, k_msgq_num_used_get(queue));
+	}
+
+	k_spin_unlock(&stats_lock, key);
+
+	if (ret) {
+		LOG_WRN("%s event queue full, event dropped", event_class_names[class]);
+		return ret;
+	}
+
+	k_sem_give(&event_sem);
+
+	return 0;
+}
+
+static int volume_put(int32_t delta)
+{
+	bool coalesced;
+	k_spinlock_key_t key;
+
+	(void)atomic_add(&volume_delta, delta);
+
+	coalesced = atomic_set(&volume_pending, 1);
+	if (!coalesced) {
+		k_sem_give(&event_sem);
+	}
+
+	key = k_spin_lock(&stats_lock);
+
+	stats[EVT_CLASS_VOLUME].put++;
+	if (coalesced) {
+		stats[EVT_CLASS_VOLUME].coalesced++;
+	}
+	stats[EVT_CLASS_VOLUME].depth_max = 1;
+
+	k_spin_unlock(&stats_lock, key);
+
+	return 0;
+}
+
 int ctrl_events_le_audio_event_send(enum le_audio_evt_type evt_type)
 {
 	struct event_t event;
@@ -33,24 +135,113 @@ int ctrl_events_le_audio_event_send(enum le_audio_evt_type evt_type)
 
 bool ctrl_events_queue_empty(void)
 {
-	uint32_t num_free;
-
-	num_free = k_msgq_num_free_get(&msg_queue);
-
-	return (num_free == CTRL_EVENTS_MSGQ_MAX_ELEMENTS ? true : false);
+	return (k_msgq_num_used_get(&state_queue) == 0) &&
+	       (k_msgq_num_used_get(&ui_queue) == 0) && !atomic_get(&volume_pending);
 }
 
 int ctrl_events_put(struct event_t *event)
 {
 	if (event == NULL) {
-		LOG_ERR("Event is NULL. Event source: %d", event->event_source);
+		LOG_ERR("Event is NULL");
 		return -EFAULT;
 	}
 
-	return k_msgq_put(&msg_queue, (void *)event, K_NO_WAIT);
+	switch (event_class_get(event)) {
+	case EVT_CLASS_STATE:
+		return queue_put(&state_queue, EVT_CLASS_STATE, event);
+	case EVT_CLASS_VOLUME:
+		return volume_put(event->button_activity.button_pin == BUTTON_VOLUME_UP ? 1 : -1);
+	default:
+		return queue_put(&ui_queue, EVT_CLASS_UI, event);
+	}
 }
 
 int ctrl_events_get(struct event_t *my_event, k_timeout_t timeout)
 {
-	return k_msgq_get(&msg_queue, (void *)my_event, timeout);
+	int ret;
+
+	while (1) {
+		ret = k_sem_take(&event_sem, timeout);
+		if (ret == -EBUSY) {
+			return -ENOMSG;
+		} else if (ret) {
+			return ret;
+		}
+
+		if (k_msgq_get(&state_queue, (void *)my_event, K_NO_WAIT) == 0) {
+			return 0;
+		}
+
+		if (atomic_clear(&volume_pending)) {
+			int32_t delta = atomic_clear(&volume_delta);
+
+			/* Up and down presses may cancel out, or the delta may
+			 * already have been taken together with an earlier event
+			 */
+			if (delta == 0) {
+				continue;
+			}
+
+			my_event->event_source = EVT_SRC_VOLUME;
+			my_event->volume_delta = delta;
+
+			return 0;
+		}
+
+		if (k_msgq_get(&ui_queue, (void *)my_event, K_NO_WAIT) == 0) {
+			return 0;
+		}
+	}
+}
+
+static int cmd_ctrl_events_stats(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct event_class_stats stats_copy[EVT_CLASS_NUM];
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	memcpy(stats_copy, stats, sizeof(stats_copy));
+
+	k_spin_unlock(&stats_lock, key);
+
+	shell_print(shell, "Queued: state %d/%d, UI %d/%d, volume pending: %s",
+		    k_msgq_num_used_get(&state_queue), CONFIG_CTRL_EVENTS_STATE_QUEUE_SIZE,
+		    k_msgq_num_used_get(&ui_queue), CONFIG_CTRL_EVENTS_UI_QUEUE_SIZE,
+		    atomic_get(&volume_pending) ? "yes" : "no");
+
+	for (int i = 0; i < EVT_CLASS_NUM; i++) {
+		shell_print(shell, "%-6s put: %u dropped: %u coalesced: %u max depth: %u",
+			    event_class_names[i], stats_copy[i].put, stats_copy[i].dropped,
+			    stats_copy[i].coalesced, stats_copy[i].depth_max);
+	}
+
+	return 0;
 }
+
+static int cmd_ctrl_events_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_spinlock_key_t key = k_spin_lock(&stats_lock);
+
+	memset(stats, 0, sizeof(stats));
+
+	k_spin_unlock(&stats_lock, key);
+
+	shell_print(shell, "Event statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(ctrl_events_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, stats, NULL,
+					      "Show event queue statistics", cmd_ctrl_events_stats),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL,
+					      "Reset event queue statistics",
+					      cmd_ctrl_events_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(ctrl_events, &ctrl_events_cmd, "Control event queue commands", NULL);
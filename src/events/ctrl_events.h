@@ -19,6 +19,8 @@
 enum event_src {
 	EVT_SRC_LE_AUDIO,
 	EVT_SRC_BUTTON,
+	/* Coalesced volume up/down button presses */
+	EVT_SRC_VOLUME,
 };
 
 /** @brief Events for activity from event sources
@@ -33,6 +35,8 @@ struct event_t {
 	union {
 		struct le_audio_evt le_audio_activity;
 		struct button_evt button_activity;
+		/* Net number of volume steps, positive is up */
+		int32_t volume_delta;
 	};
 };
 
@@ -47,24 +51,34 @@ struct event_t {
  */
 int ctrl_events_le_audio_event_send(enum le_audio_evt_type evt_type);
 
+/*
+ * Events are put in one of three priority classes, and ctrl_events_get always
+ * returns the highest priority event pending:
+ *  - Stream state: LE Audio events. Never dropped by a burst of button presses.
+ *  - Volume: Volume up/down presses are coalesced into a single EVT_SRC_VOLUME
+ *    event holding the net number of steps. This class never fills up.
+ *  - UI: All other button events.
+ */
+
 /** @brief  Check if event queue is empty
  *
- * @retval True if queue is empty, false if not
+ * @retval True if no events of any class are pending, false if not
  */
 bool ctrl_events_queue_empty(void);
 
-/** @brief  Put event in k_msgq
+/** @brief  Put event in the queue of its priority class
+ *
+ * @note Can be called from ISR. Never blocks
  *
  * @param  event	Pointer to event
  *
  * @retval 0 Event sent
  * @retval -EFAULT Try to send event with address NULL
- * @retval -ENOMSG Returned without waiting or queue purged
- * @retval -EAGAIN Waiting period timed out
+ * @retval -ENOMSG Queue of the event's class is full
  */
 int ctrl_events_put(struct event_t *event);
 
-/** @brief  Get event from k_msgq
+/** @brief  Get highest priority event
  *
  * @param  my_event	Event to get from the queue
  * @param  timeout	Time to wait for event. Can be K_FOREVER
@@ -51,6 +51,9 @@
 #include <nrfx_clock.h>
 
 #include "audio_sync_timer.h"
+#if (CONFIG_I2S_TDM_EMULATION)
+#include "audio_i2s_tdm.h"
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(audio_i2s, CONFIG_LOG_I2S_LEVEL);
@@ -77,7 +80,12 @@ static nrfx_i2s_config_t cfg = {
 	.mode = NRF_I2S_MODE_MASTER,
 	.format = NRF_I2S_FORMAT_I2S,
 	.alignment = NRF_I2S_ALIGN_LEFT,
-#if (CONFIG_AUDIO_BIT_DEPTH_16)
+#if (CONFIG_I2S_TDM_EMULATION)
+	/* Each 32 bit channel carries half of the TDM slots */
+	.sample_width = NRF_I2S_SWIDTH_32BIT,
+	.mck_setup = 0x66666000,
+	.ratio = NRF_I2S_RATIO_128X,
+#elif (CONFIG_AUDIO_BIT_DEPTH_16)
 	.sample_width = NRF_I2S_SWIDTH_16BIT,
 	.mck_setup = 0x66666000,
 	.ratio = NRF_I2S_RATIO_128X,
@@ -100,12 +108,124 @@ static nrfx_i2s_config_t cfg = {
 
 static i2s_blk_comp_callback_t i2s_blk_comp_callback;
 
+#if (CONFIG_I2S_TDM_EMULATION)
+/* One block of I2S frames, each frame being two 32 bit channel words */
+#define TDM_FRAMES_NUM (I2S_SAMPLES_NUM)
+#define TDM_WORDS_NUM (TDM_FRAMES_NUM * AUDIO_I2S_TDM_WORDS_PER_FRAME)
+
+BUILD_ASSERT(CONFIG_I2S_CH_NUM == 2, "TDM emulation routes slots to a stereo datapath");
+BUILD_ASSERT((CONFIG_I2S_TDM_SLOT_NUM * CONFIG_I2S_TDM_SLOT_WIDTH_BITS) <=
+		     AUDIO_I2S_TDM_FRAME_BITS,
+	     "TDM slots do not fit the frame");
+BUILD_ASSERT(CONFIG_I2S_TDM_RX_SLOT_L < CONFIG_I2S_TDM_SLOT_NUM &&
+		     CONFIG_I2S_TDM_RX_SLOT_R < CONFIG_I2S_TDM_SLOT_NUM,
+	     "RX slot not in use");
+BUILD_ASSERT(CONFIG_I2S_TDM_TX_SLOT_L < CONFIG_I2S_TDM_SLOT_NUM &&
+		     CONFIG_I2S_TDM_TX_SLOT_R < CONFIG_I2S_TDM_SLOT_NUM,
+	     "TX slot not in use");
+
+static const struct audio_i2s_tdm_fmt tdm_fmt = {
+	.slot_num = CONFIG_I2S_TDM_SLOT_NUM,
+	.slot_width_bits = CONFIG_I2S_TDM_SLOT_WIDTH_BITS,
+};
+
+static i2s_tdm_rx_callback_t i2s_tdm_rx_callback;
+
+/* Every RX slot of the last released block, one buffer per slot */
+static int16_t tdm_rx_slots[CONFIG_I2S_TDM_SLOT_NUM * TDM_FRAMES_NUM];
+
+/* The datapath uses stereo blocks, while I2S runs on TDM blocks of the same
+ * duration. Each TDM block remembers the datapath buffers it was set up with
+ */
+struct tdm_blk {
+	uint32_t rx[TDM_WORDS_NUM];
+	uint32_t tx[TDM_WORDS_NUM];
+	uint32_t *rx_user;
+	uint8_t const *tx_user;
+};
+
+static struct tdm_blk tdm_blks[2];
+static uint8_t tdm_next_idx;
+
+/* Put the stereo datapath block into the TX slots */
+static void tdm_tx_fill(struct tdm_blk *blk, uint8_t const *tx_user)
+{
+	blk->tx_user = tx_user;
+
+	if (tx_user == NULL) {
+		return;
+	}
+
+	audio_i2s_tdm_pack(&tdm_fmt, (int16_t const *)tx_user, blk->tx, TDM_FRAMES_NUM,
+			   CONFIG_I2S_TDM_TX_SLOT_L, CONFIG_I2S_TDM_TX_SLOT_R);
+}
+
+/* Split the RX block into its slots, and take the routed ones into the stereo datapath block */
+static void tdm_rx_drain(struct tdm_blk const *blk)
+{
+	if (blk->rx_user == NULL) {
+		return;
+	}
+
+	audio_i2s_tdm_unpack(&tdm_fmt, blk->rx, tdm_rx_slots, TDM_FRAMES_NUM);
+	audio_i2s_tdm_stereo_get(tdm_rx_slots, (int16_t *)blk->rx_user, TDM_FRAMES_NUM,
+				 CONFIG_I2S_TDM_RX_SLOT_L, CONFIG_I2S_TDM_RX_SLOT_R);
+}
+
+/* Set up the next TDM block, and get the buffers to hand to nrfx */
+static nrfx_i2s_buffers_t tdm_blk_next(uint8_t const *tx_buf, uint32_t *rx_buf)
+{
+	struct tdm_blk *blk = &tdm_blks[tdm_next_idx];
+
+	tdm_next_idx ^= 1;
+
+	tdm_tx_fill(blk, tx_buf);
+	blk->rx_user = rx_buf;
+
+	return (nrfx_i2s_buffers_t){ .p_rx_buffer = blk->rx,
+				     .p_tx_buffer = (tx_buf != NULL) ? blk->tx : NULL };
+}
+
+/* Find the TDM block released by I2S, and give back its datapath buffers */
+static struct tdm_blk *tdm_blk_release(nrfx_i2s_buffers_t const *released_bufs)
+{
+	for (int i = 0; i < ARRAY_SIZE(tdm_blks); i++) {
+		struct tdm_blk *blk = &tdm_blks[i];
+
+		if (released_bufs->p_rx_buffer == blk->rx ||
+		    (released_bufs->p_tx_buffer != NULL && released_bufs->p_tx_buffer == blk->tx)) {
+			tdm_rx_drain(blk);
+			return blk;
+		}
+	}
+
+	return NULL;
+}
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 static void i2s_comp_handler(nrfx_i2s_buffers_t const *released_bufs, uint32_t status)
 {
 	if ((status == NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED) && released_bufs &&
 	    i2s_blk_comp_callback && (released_bufs->p_rx_buffer || released_bufs->p_tx_buffer)) {
+#if (CONFIG_I2S_TDM_EMULATION)
+		uint32_t frame_start_ts = audio_sync_timer_i2s_frame_start_ts_get();
+		struct tdm_blk *blk = tdm_blk_release(released_bufs);
+
+		if (blk == NULL) {
+			return;
+		}
+
+		if (i2s_tdm_rx_callback && blk->rx_user != NULL) {
+			i2s_tdm_rx_callback(frame_start_ts, tdm_rx_slots, CONFIG_I2S_TDM_SLOT_NUM,
+					    TDM_FRAMES_NUM);
+		}
+
+		i2s_blk_comp_callback(frame_start_ts, blk->rx_user,
+				      (uint32_t const *)blk->tx_user);
+#else
 		i2s_blk_comp_callback(audio_sync_timer_i2s_frame_start_ts_get(),
 				      released_bufs->p_rx_buffer, released_bufs->p_tx_buffer);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
 	}
 }
 
@@ -117,8 +237,12 @@ void audio_i2s_set_next_buf(const uint8_t *tx_buf, uint32_t *rx_buf)
 	__ASSERT_NO_MSG(tx_buf != NULL);
 #endif /* (CONFIG_STREAM_BIDIRECTIONAL || (CONFIG_AUDIO_DEV == HEADSET)) */
 
+#if (CONFIG_I2S_TDM_EMULATION)
+	const nrfx_i2s_buffers_t i2s_buf = tdm_blk_next(tx_buf, rx_buf);
+#else
 	const nrfx_i2s_buffers_t i2s_buf = { .p_rx_buffer = rx_buf,
 					     .p_tx_buffer = (uint32_t *)tx_buf };
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
 
 	nrfx_err_t ret;
 
@@ -134,13 +258,22 @@ void audio_i2s_start(const uint8_t *tx_buf, uint32_t *rx_buf)
 	__ASSERT_NO_MSG(tx_buf != NULL);
 #endif /* (CONFIG_STREAM_BIDIRECTIONAL || (CONFIG_AUDIO_DEV == HEADSET)) */
 
+	nrfx_err_t ret;
+
+#if (CONFIG_I2S_TDM_EMULATION)
+	tdm_next_idx = 0;
+
+	const nrfx_i2s_buffers_t i2s_buf = tdm_blk_next(tx_buf, rx_buf);
+
+	/* A TDM block has the duration of a datapath block, with twice the words */
+	ret = nrfx_i2s_start(&i2s_buf, TDM_WORDS_NUM, 0);
+#else
 	const nrfx_i2s_buffers_t i2s_buf = { .p_rx_buffer = rx_buf,
 					     .p_tx_buffer = (uint32_t *)tx_buf };
 
-	nrfx_err_t ret;
-
 	/* Buffer size in 32-bit words */
 	ret = nrfx_i2s_start(&i2s_buf, I2S_SAMPLES_NUM, 0);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
 	__ASSERT_NO_MSG(ret == NRFX_SUCCESS);
 
 	state = AUDIO_I2S_STATE_STARTED;
@@ -160,6 +293,13 @@ void audio_i2s_blk_comp_cb_register(i2s_blk_comp_callback_t blk_comp_callback)
 	i2s_blk_comp_callback = blk_comp_callback;
 }
 
+#if (CONFIG_I2S_TDM_EMULATION)
+void audio_i2s_tdm_rx_cb_register(i2s_tdm_rx_callback_t tdm_rx_callback)
+{
+	i2s_tdm_rx_callback = tdm_rx_callback;
+}
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 void audio_i2s_init(void)
 {
 	__ASSERT_NO_MSG(state == AUDIO_I2S_STATE_UNINIT);
@@ -184,5 +324,11 @@ void audio_i2s_init(void)
 	ret = nrfx_i2s_init(&cfg, i2s_comp_handler);
 	__ASSERT_NO_MSG(ret == NRFX_SUCCESS);
 
+#if (CONFIG_I2S_TDM_EMULATION)
+	LOG_INF("I2S TDM: %d slots of %d bits, RX L/R from slot %d/%d, TX L/R in slot %d/%d",
+		CONFIG_I2S_TDM_SLOT_NUM, CONFIG_I2S_TDM_SLOT_WIDTH_BITS, CONFIG_I2S_TDM_RX_SLOT_L,
+		CONFIG_I2S_TDM_RX_SLOT_R, CONFIG_I2S_TDM_TX_SLOT_L, CONFIG_I2S_TDM_TX_SLOT_R);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 	state = AUDIO_I2S_STATE_IDLE;
 }
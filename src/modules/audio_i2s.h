@@ -82,6 +82,22 @@
 typedef void (*i2s_blk_comp_callback_t)(uint32_t frame_start_ts, uint32_t *rx_buf_released,
 					uint32_t const *tx_buf_released);
 
+#if (CONFIG_I2S_TDM_EMULATION)
+/**
+ * @brief I2S TDM RX block callback type
+ *
+ * @note Called from the I2S interrupt for each received block, before the block
+ *	 complete callback. The slot buffers are reused for the next block
+ *
+ * @param frame_start_ts I2S frame start timestamp
+ * @param slots Received samples, slot_num buffers of frames samples, one after the other
+ * @param slot_num Number of slots
+ * @param frames Number of samples in each slot buffer
+ */
+typedef void (*i2s_tdm_rx_callback_t)(uint32_t frame_start_ts, int16_t const *slots,
+				      uint8_t slot_num, uint32_t frames);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 /**
  * @brief Supply the buffers to be used in the next part of the I2S transfer
  *
@@ -110,6 +126,15 @@ void audio_i2s_stop(void);
  */
 void audio_i2s_blk_comp_cb_register(i2s_blk_comp_callback_t blk_comp_callback);
 
+#if (CONFIG_I2S_TDM_EMULATION)
+/**
+ * @brief Register callback function for the received blocks of all TDM slots
+ *
+ * @param tdm_rx_callback Callback function
+ */
+void audio_i2s_tdm_rx_cb_register(i2s_tdm_rx_callback_t tdm_rx_callback);
+#endif /* (CONFIG_I2S_TDM_EMULATION) */
+
 /**
  * @brief Initialize I2S module
  */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "audio_i2s_tdm.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Raw bits of a slot, right aligned */
+static uint32_t slot_bits_get(struct audio_i2s_tdm_fmt const *fmt, uint32_t const *frame,
+			      uint8_t slot)
+{
+	uint32_t pos = slot * fmt->slot_width_bits;
+	uint32_t shift = 32 - fmt->slot_width_bits - (pos % 32);
+	uint32_t mask = UINT32_MAX >> (32 - fmt->slot_width_bits);
+
+	return (frame[pos / 32] >> shift) & mask;
+}
+
+static void slot_bits_set(struct audio_i2s_tdm_fmt const *fmt, uint32_t *frame, uint8_t slot,
+			  uint32_t bits)
+{
+	uint32_t pos = slot * fmt->slot_width_bits;
+	uint32_t shift = 32 - fmt->slot_width_bits - (pos % 32);
+	uint32_t mask = UINT32_MAX >> (32 - fmt->slot_width_bits);
+
+	frame[pos / 32] &= ~(mask << shift);
+	frame[pos / 32] |= (bits & mask) << shift;
+}
+
+static int16_t slot_to_s16(uint8_t width_bits, uint32_t bits)
+{
+	int32_t val;
+
+	switch (width_bits) {
+	case 8:
+		return (int16_t)((int8_t)bits * 256);
+	case 16:
+		return (int16_t)bits;
+	default:
+		/* Round to the upper 16 bits, saturating at full scale */
+		val = (int32_t)(((int64_t)(int32_t)bits + 0x8000) >> 16);
+		return (val > INT16_MAX) ? INT16_MAX : (int16_t)val;
+	}
+}
+
+static uint32_t s16_to_slot(uint8_t width_bits, int16_t sample)
+{
+	int32_t val;
+
+	switch (width_bits) {
+	case 8:
+		/* Round to the upper 8 bits, saturating at full scale */
+		val = ((int32_t)sample + 0x80) >> 8;
+		return (uint32_t)((val > INT8_MAX) ? INT8_MAX : val);
+	case 16:
+		return (uint16_t)sample;
+	default:
+		return (uint32_t)(uint16_t)sample << 16;
+	}
+}
+
+int audio_i2s_tdm_fmt_check(struct audio_i2s_tdm_fmt const *fmt)
+{
+	if (fmt->slot_width_bits != 8 && fmt->slot_width_bits != 16 &&
+	    fmt->slot_width_bits != 32) {
+		return -EINVAL;
+	}
+
+	if (fmt->slot_num == 0 ||
+	    fmt->slot_num > (AUDIO_I2S_TDM_FRAME_BITS / fmt->slot_width_bits)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+void audio_i2s_tdm_pack(struct audio_i2s_tdm_fmt const *fmt, int16_t const *pcm, uint32_t *words,
+			uint32_t frames, uint8_t slot_l, uint8_t slot_r)
+{
+	memset(words, 0, frames * AUDIO_I2S_TDM_WORDS_PER_FRAME * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < frames; i++) {
+		uint32_t *frame = &words[i * AUDIO_I2S_TDM_WORDS_PER_FRAME];
+
+		slot_bits_set(fmt, frame, slot_l, s16_to_slot(fmt->slot_width_bits, pcm[2 * i]));
+		slot_bits_set(fmt, frame, slot_r,
+			      s16_to_slot(fmt->slot_width_bits, pcm[2 * i + 1]));
+	}
+}
+
+void audio_i2s_tdm_unpack(struct audio_i2s_tdm_fmt const *fmt, uint32_t const *words,
+			  int16_t *slots, uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		uint32_t const *frame = &words[i * AUDIO_I2S_TDM_WORDS_PER_FRAME];
+
+		for (uint8_t s = 0; s < fmt->slot_num; s++) {
+			slots[s * frames + i] =
+				slot_to_s16(fmt->slot_width_bits, slot_bits_get(fmt, frame, s));
+		}
+	}
+}
+
+void audio_i2s_tdm_stereo_get(int16_t const *slots, int16_t *pcm, uint32_t frames,
+			      uint8_t slot_l, uint8_t slot_r)
+{
+	int16_t const *left = &slots[slot_l * frames];
+	int16_t const *right = &slots[slot_r * frames];
+
+	for (uint32_t i = 0; i < frames; i++) {
+		pcm[2 * i] = left[i];
+		pcm[2 * i + 1] = right[i];
+	}
+}
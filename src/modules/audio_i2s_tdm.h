@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AUDIO_I2S_TDM_H_
+#define _AUDIO_I2S_TDM_H_
+
+#include <stdint.h>
+
+/*
+ * Slot layout of the emulated TDM frame
+ *
+ * Each frame is two 32 bit I2S channel words, 64 bits in total. Slots of
+ * 8, 16 or 32 bits follow each other from the start of the frame, most
+ * significant bit first, so slot 0 is in the upper bits of the first word.
+ * Bits after the last slot in use are padding.
+ *
+ * Samples are converted from and to the 16 bit datapath. Narrower slots are
+ * scaled up on RX and rounded on TX, wider slots are rounded on RX and
+ * scaled up on TX.
+ */
+
+#define AUDIO_I2S_TDM_WORDS_PER_FRAME 2
+#define AUDIO_I2S_TDM_FRAME_BITS (AUDIO_I2S_TDM_WORDS_PER_FRAME * 32)
+#define AUDIO_I2S_TDM_SLOT_NUM_MAX (AUDIO_I2S_TDM_FRAME_BITS / 8)
+
+struct audio_i2s_tdm_fmt {
+	uint8_t slot_num;
+	uint8_t slot_width_bits;
+};
+
+/**
+ * @brief Check that a slot layout fits the TDM frame
+ *
+ * @param fmt	Slot layout
+ *
+ * @return 0 if the layout is valid, -EINVAL otherwise
+ */
+int audio_i2s_tdm_fmt_check(struct audio_i2s_tdm_fmt const *fmt);
+
+/**
+ * @brief Put stereo 16 bit frames into TDM frames
+ *
+ * @note Slots without a channel and padding bits are silent. If both
+ *	 channels use the same slot, the right channel is sent
+ *
+ * @param fmt		Slot layout
+ * @param pcm		Interleaved stereo samples
+ * @param words		[out] TDM frames, AUDIO_I2S_TDM_WORDS_PER_FRAME words each
+ * @param frames	Number of frames
+ * @param slot_l	Slot to send the left channel in
+ * @param slot_r	Slot to send the right channel in
+ */
+void audio_i2s_tdm_pack(struct audio_i2s_tdm_fmt const *fmt, int16_t const *pcm, uint32_t *words,
+			uint32_t frames, uint8_t slot_l, uint8_t slot_r);
+
+/**
+ * @brief Take every slot of TDM frames into per-slot 16 bit buffers
+ *
+ * @param fmt		Slot layout
+ * @param words		TDM frames, AUDIO_I2S_TDM_WORDS_PER_FRAME words each
+ * @param slots		[out] fmt->slot_num buffers of frames samples, one after the other
+ * @param frames	Number of frames
+ */
+void audio_i2s_tdm_unpack(struct audio_i2s_tdm_fmt const *fmt, uint32_t const *words,
+			  int16_t *slots, uint32_t frames);
+
+/**
+ * @brief Interleave two per-slot buffers into stereo 16 bit frames
+ *
+ * @param slots		Per-slot buffers as given by audio_i2s_tdm_unpack()
+ * @param pcm		[out] Interleaved stereo samples
+ * @param frames	Number of frames
+ * @param slot_l	Slot taken as the left channel
+ * @param slot_r	Slot taken as the right channel
+ */
+void audio_i2s_tdm_stereo_get(int16_t const *slots, int16_t *pcm, uint32_t frames,
+			      uint8_t slot_l, uint8_t slot_r);
+
+#endif /* _AUDIO_I2S_TDM_H_ */
@@ -7,67 +7,290 @@
 #include "audio_usb.h"
 
 #include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
 #include <zephyr/usb/usb_device.h>
 #include <zephyr/usb/class/usb_audio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "macros_common.h"
 #include "data_fifo.h"
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+#include "audio_usb_out.h"
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
+#include "audio_usb_format.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(audio_usb, CONFIG_LOG_AUDIO_USB_LEVEL);
 
+/* USB OUT audio in another format than the 16 bit pipeline is converted on the gateway */
+#define USB_OUT_CONVERT                                                                            \
+	((CONFIG_AUDIO_SOURCE_USB) && (CONFIG_AUDIO_DEV == GATEWAY) && (CONFIG_AUDIO_BIT_DEPTH_16))
+
 #define USB_FRAME_SIZE_STEREO                                                                      \
 	(((CONFIG_AUDIO_SAMPLE_RATE_HZ * CONFIG_AUDIO_BIT_DEPTH_OCTETS) / 1000) * 2)
 
-static struct data_fifo *fifo_tx;
 static struct data_fifo *fifo_rx;
 
 NET_BUF_POOL_FIXED_DEFINE(pool_out, CONFIG_FIFO_FRAME_SPLIT_NUM, USB_FRAME_SIZE_STEREO, 8,
 			  net_buf_destroy);
 
+#if (USB_OUT_CONVERT)
+/* USB OUT packets in other formats are converted here */
+static int16_t usb_out_conv[USB_FRAME_SIZE_STEREO / sizeof(int16_t)];
+#endif /* (USB_OUT_CONVERT) */
+
+#if !(CONFIG_USB_OUT_DIRECT_SPLIT)
+static void usb_out_fifo_write(void const *const data, size_t size)
+{
+	int ret;
+	void *data_in;
+
+	ret = data_fifo_pointer_first_vacant_get(fifo_rx, &data_in, K_NO_WAIT);
+
+	/* RX FIFO can fill up due to retransmissions or disconnect */
+#if (CONFIG_FIFO_RX_SPSC)
+	if (ret == -ENOMEM) {
+		/* Only the consumer may free blocks, drop the newest block instead */
+		LOG_WRN("USB RX overrun");
+		return;
+	}
+#else
+	if (ret == -ENOMEM) {
+		void *temp;
+		size_t temp_size;
+
+		LOG_WRN("USB RX overrun");
+
+		ret = data_fifo_pointer_last_filled_get(fifo_rx, &temp, &temp_size, K_NO_WAIT);
+		ERR_CHK(ret);
+
+		ret = data_fifo_block_free(fifo_rx, &temp);
+		ERR_CHK(ret);
+
+		ret = data_fifo_pointer_first_vacant_get(fifo_rx, &data_in, K_NO_WAIT);
+	}
+#endif /* (CONFIG_FIFO_RX_SPSC) */
+
+	ERR_CHK_MSG(ret, "RX failed to get block");
+
+	memcpy(data_in, data, size);
+
+	ret = data_fifo_block_lock(fifo_rx, &data_in, size);
+	ERR_CHK_MSG(ret, "Failed to lock block");
+}
+#endif /* !(CONFIG_USB_OUT_DIRECT_SPLIT) */
+
 #if (CONFIG_STREAM_BIDIRECTIONAL)
+/* Return path: decoded frames are written to a ring in whole frames and
+ * read by USB in 1 ms chunks, one per SOF
+ */
+#define IN_CHUNKS_PER_FRAME (CONFIG_AUDIO_FRAME_DURATION_US / 1000)
+#define IN_FRAME_SIZE (USB_FRAME_SIZE_STEREO * IN_CHUNKS_PER_FRAME)
+#define IN_RING_CHUNKS (IN_CHUNKS_PER_FRAME * CONFIG_AUDIO_USB_IN_FRAME_NUM)
+#define IN_PREFILL_CHUNKS CONFIG_AUDIO_USB_IN_PREFILL_MS
+/* Fill level after a frame is written, above which the ISO side is running faster than USB */
+#define IN_HIGH_WATER_CHUNKS (IN_PREFILL_CHUNKS + IN_CHUNKS_PER_FRAME)
+
+BUILD_ASSERT(IN_HIGH_WATER_CHUNKS < IN_RING_CHUNKS,
+	     "AUDIO_USB_IN_FRAME_NUM too small for AUDIO_USB_IN_PREFILL_MS");
+
+static struct {
+	uint8_t buf[IN_RING_CHUNKS][USB_FRAME_SIZE_STEREO] __aligned(sizeof(uint32_t));
+	/* Next chunk to send */
+	uint32_t rd;
+	/* Chunks written and not sent. rd + fill is always frame aligned */
+	uint32_t fill;
+	/* Set when the prefill level is reached, cleared on underrun */
+	bool running;
+
+	uint32_t underruns;
+	uint32_t overruns;
+	uint32_t skips;
+} usb_in;
+
+static struct k_spinlock usb_in_lock;
+
+/* Impulse based round trip measurement, USB OUT to USB IN */
+#define LOOPBACK_THRESH (INT16_MAX / 4)
+#define LOOPBACK_TIMEOUT_US 1000000
+
+enum loopback_state {
+	LOOPBACK_IDLE,
+	LOOPBACK_ARMED,
+	LOOPBACK_SENT,
+};
+
+static struct {
+	enum loopback_state state;
+	uint32_t sent_cyc;
+	/* Last result, 0 if no impulse was detected */
+	uint32_t device_us;
+	uint32_t queued_us;
+} loopback;
+
+static void loopback_impulse_insert(void *data, size_t size)
+{
+	if (loopback.state != LOOPBACK_ARMED) {
+		return;
+	}
+
+	memset(data, 0, size);
+	((int16_t *)data)[0] = INT16_MAX;
+	((int16_t *)data)[1] = INT16_MAX;
+
+	loopback.sent_cyc = k_cycle_get_32();
+	loopback.state = LOOPBACK_SENT;
+}
+
+static void loopback_impulse_detect(int16_t const *const frame, uint32_t queued_chunks)
+{
+	uint32_t elapsed_us;
+
+	if (loopback.state != LOOPBACK_SENT) {
+		return;
+	}
+
+	elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - loopback.sent_cyc);
+
+	for (size_t i = 0; i < IN_FRAME_SIZE / sizeof(int16_t); i++) {
+		if (abs(frame[i]) > LOOPBACK_THRESH) {
+			/* The impulse is sent on USB IN after the audio queued ahead of it */
+			uint32_t sample_idx = i / 2;
+
+			loopback.device_us = elapsed_us;
+			loopback.queued_us = queued_chunks * 1000 +
+					     (sample_idx * 1000000) / CONFIG_AUDIO_SAMPLE_RATE_HZ;
+			loopback.state = LOOPBACK_IDLE;
+
+			LOG_INF("Loopback: %u us to return path, %u us queued for USB IN",
+				loopback.device_us, loopback.queued_us);
+			return;
+		}
+	}
+
+	if (elapsed_us > LOOPBACK_TIMEOUT_US) {
+		LOG_WRN("Loopback: no impulse detected");
+		loopback.device_us = 0;
+		loopback.queued_us = 0;
+		loopback.state = LOOPBACK_IDLE;
+	}
+}
+
+int audio_usb_in_frame_get(void **frame, size_t *size)
+{
+	if (fifo_rx == NULL) {
+		return -ECANCELED;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&usb_in_lock);
+
+	/* Drop the oldest frame if there is no room, to bound the latency */
+	if (usb_in.fill > (IN_RING_CHUNKS - IN_CHUNKS_PER_FRAME)) {
+		usb_in.rd = (usb_in.rd + IN_CHUNKS_PER_FRAME) % IN_RING_CHUNKS;
+		usb_in.fill -= IN_CHUNKS_PER_FRAME;
+		usb_in.overruns++;
+	}
+
+	*frame = usb_in.buf[(usb_in.rd + usb_in.fill) % IN_RING_CHUNKS];
+	*size = IN_FRAME_SIZE;
+
+	k_spin_unlock(&usb_in_lock, key);
+
+	return 0;
+}
+
+int audio_usb_in_frame_commit(void const *const frame, size_t size)
+{
+	uint32_t queued_chunks;
+
+	if (size != IN_FRAME_SIZE) {
+		LOG_WRN("Wrong return frame size: %d", size);
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&usb_in_lock);
+
+	queued_chunks = usb_in.fill;
+	usb_in.fill += IN_CHUNKS_PER_FRAME;
+
+	if (!usb_in.running && usb_in.fill >= IN_PREFILL_CHUNKS) {
+		usb_in.running = true;
+	} else if (usb_in.fill > IN_HIGH_WATER_CHUNKS) {
+		/* Skip one chunk to follow the USB clock */
+		usb_in.rd = (usb_in.rd + 1) % IN_RING_CHUNKS;
+		usb_in.fill--;
+		usb_in.skips++;
+	}
+
+	k_spin_unlock(&usb_in_lock, key);
+
+	if (CONFIG_AUDIO_BIT_DEPTH_OCTETS == 2) {
+		loopback_impulse_detect(frame, queued_chunks);
+	}
+
+	return 0;
+}
+
 static void data_write(const struct device *dev)
 {
 	int ret;
+	struct net_buf *buf_out;
 
-	if (fifo_tx == NULL) {
+	if (fifo_rx == NULL) {
 		return;
 	}
 
-	void *data_out;
-	size_t data_out_size;
-	struct net_buf *buf_out;
+	if (usb_audio_get_in_frame_size(dev) != USB_FRAME_SIZE_STEREO) {
+		LOG_WRN("Wrong size write: %d", usb_audio_get_in_frame_size(dev));
+		return;
+	}
 
 	buf_out = net_buf_alloc(&pool_out, K_NO_WAIT);
-
-	ret = data_fifo_pointer_last_filled_get(fifo_tx, &data_out, &data_out_size, K_NO_WAIT);
-	if (ret) {
-		LOG_WRN("USB TX underrun");
-		net_buf_unref(buf_out);
+	if (buf_out == NULL) {
+		LOG_WRN("USB TX out of buffers");
 		return;
 	}
 
-	memcpy(buf_out->data, data_out, data_out_size);
-	data_fifo_block_free(fifo_tx, &data_out);
+	k_spinlock_key_t key = k_spin_lock(&usb_in_lock);
 
-	if (data_out_size == usb_audio_get_in_frame_size(dev)) {
-		ret = usb_audio_send(dev, buf_out, data_out_size);
-		if (ret) {
-			LOG_WRN("USB TX failed, ret: %d", ret);
-			net_buf_unref(buf_out);
-		}
+	if (usb_in.running && usb_in.fill == 0) {
+		usb_in.running = false;
+		usb_in.underruns++;
+	}
 
+	/* Send silence until enough is buffered to absorb the ISO jitter */
+	if (usb_in.running) {
+		memcpy(buf_out->data, usb_in.buf[usb_in.rd], USB_FRAME_SIZE_STEREO);
+		usb_in.rd = (usb_in.rd + 1) % IN_RING_CHUNKS;
+		usb_in.fill--;
 	} else {
-		LOG_WRN("Wrong size write: %d", data_out_size);
+		memset(buf_out->data, 0, USB_FRAME_SIZE_STEREO);
+	}
+
+	k_spin_unlock(&usb_in_lock, key);
+
+	ret = usb_audio_send(dev, buf_out, USB_FRAME_SIZE_STEREO);
+	if (ret) {
+		LOG_WRN("USB TX failed, ret: %d", ret);
+		net_buf_unref(buf_out);
 	}
 }
+
+static void usb_in_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&usb_in_lock);
+
+	usb_in.rd = 0;
+	usb_in.fill = 0;
+	usb_in.running = false;
+
+	k_spin_unlock(&usb_in_lock, key);
+}
 #endif /* (CONFIG_STREAM_BIDIRECTIONAL) */
 
 static void data_received(const struct device *dev, struct net_buf *buffer, size_t size)
 {
-	int ret;
-	void *data_in;
-
 	if (fifo_rx == NULL) {
 		/* Throwing away data */
 		net_buf_unref(buffer);
@@ -79,37 +302,50 @@ static void data_received(const struct device *dev, struct net_buf *buffer, size
 		ERR_CHK(-EINVAL);
 	}
 
+	void *data = buffer->data;
+
 	/* Receive data from USB */
-	if (size != USB_FRAME_SIZE_STEREO) {
+#if (USB_OUT_CONVERT)
+	int ret = audio_usb_format_detect(size);
+
+	if (ret) {
 		LOG_WRN("Wrong length: %d", size);
 		net_buf_unref(buffer);
 		return;
 	}
 
-	ret = data_fifo_pointer_first_vacant_get(fifo_rx, &data_in, K_NO_WAIT);
-
-	/* RX FIFO can fill up due to retransmissions or disconnect */
-	if (ret == -ENOMEM) {
-		void *temp;
-		size_t temp_size;
-
-		LOG_WRN("USB RX overrun");
-
-		ret = data_fifo_pointer_last_filled_get(fifo_rx, &temp, &temp_size, K_NO_WAIT);
-		ERR_CHK(ret);
-
-		ret = data_fifo_block_free(fifo_rx, &temp);
+	if (!audio_usb_format_is_native()) {
+		ret = audio_usb_format_convert(buffer->data, size, usb_out_conv,
+					       sizeof(usb_out_conv), &size);
 		ERR_CHK(ret);
-
-		ret = data_fifo_pointer_first_vacant_get(fifo_rx, &data_in, K_NO_WAIT);
+		data = usb_out_conv;
 	}
+#else
+	if (size != USB_FRAME_SIZE_STEREO) {
+		LOG_WRN("Wrong length: %d", size);
+		net_buf_unref(buffer);
+		return;
+	}
+#endif /* (USB_OUT_CONVERT) */
 
-	ERR_CHK_MSG(ret, "RX failed to get block");
+#if (CONFIG_STREAM_BIDIRECTIONAL)
+	if (CONFIG_AUDIO_BIT_DEPTH_OCTETS == 2) {
+		loopback_impulse_insert(data, size);
+	}
+#endif /* (CONFIG_STREAM_BIDIRECTIONAL) */
 
-	memcpy(data_in, buffer->data, size);
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+	int err = audio_usb_out_write(data, size);
 
-	ret = data_fifo_block_lock(fifo_rx, &data_in, size);
-	ERR_CHK_MSG(ret, "Failed to lock block");
+	if (err == -ENOMEM) {
+		/* The encoder may hold the oldest frame, so the newest packet is dropped */
+		LOG_WRN("USB RX overrun");
+	} else {
+		ERR_CHK(err);
+	}
+#else
+	usb_out_fifo_write(data, size);
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
 
 	net_buf_unref(buffer);
 }
@@ -133,13 +369,20 @@ static const struct usb_audio_ops ops = {
 #endif /* (CONFIG_STREAM_BIDIRECTIONAL) */
 };
 
-int audio_usb_start(struct data_fifo *fifo_tx_in, struct data_fifo *fifo_rx_in)
+int audio_usb_start(struct data_fifo *fifo_rx_in)
 {
-	if (fifo_tx_in == NULL || fifo_rx_in == NULL) {
+	if (fifo_rx_in == NULL) {
 		return -EINVAL;
 	}
 
-	fifo_tx = fifo_tx_in;
+#if (CONFIG_STREAM_BIDIRECTIONAL)
+	usb_in_reset();
+#endif /* (CONFIG_STREAM_BIDIRECTIONAL) */
+
+#if (USB_OUT_CONVERT)
+	audio_usb_format_reset();
+#endif /* (USB_OUT_CONVERT) */
+
 	fifo_rx = fifo_rx_in;
 
 	return 0;
@@ -147,8 +390,12 @@ int audio_usb_start(struct data_fifo *fifo_tx_in, struct data_fifo *fifo_rx_in)
 
 void audio_usb_stop(void)
 {
-	fifo_tx = NULL;
 	fifo_rx = NULL;
+
+#if (CONFIG_USB_OUT_DIRECT_SPLIT)
+	/* USB no longer writes, so stale frames are not encoded at the next start */
+	audio_usb_out_restart();
+#endif /* (CONFIG_USB_OUT_DIRECT_SPLIT) */
 }
 
 int audio_usb_disable(void)
@@ -186,3 +433,58 @@ int audio_usb_init(void)
 
 	return 0;
 }
+
+#if (CONFIG_STREAM_BIDIRECTIONAL)
+static int cmd_usb_in_stats(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(shell, "Return path fill: %u ms, prefill: %d ms, running: %d", usb_in.fill,
+		    IN_PREFILL_CHUNKS, usb_in.running);
+	shell_print(shell, "Underruns: %u, overrun frame drops: %u, drift skips: %u",
+		    usb_in.underruns, usb_in.overruns, usb_in.skips);
+
+	if (loopback.device_us) {
+		shell_print(shell, "Last loopback: %u us to return path + %u us queued = %u us",
+			    loopback.device_us, loopback.queued_us,
+			    loopback.device_us + loopback.queued_us);
+	}
+
+	return 0;
+}
+
+static int cmd_usb_in_loopback(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (CONFIG_AUDIO_BIT_DEPTH_OCTETS != 2) {
+		shell_error(shell, "Loopback measurement needs 16 bit samples");
+		return -ENOTSUP;
+	}
+
+	if (loopback.state != LOOPBACK_IDLE) {
+		shell_error(shell, "Measurement already running");
+		return -EBUSY;
+	}
+
+	loopback.state = LOOPBACK_ARMED;
+
+	shell_print(shell, "Impulse sent with the next USB OUT frame, result is logged");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(usb_in_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, stats, NULL,
+					      "Show return path buffer statistics",
+					      cmd_usb_in_stats),
+			       SHELL_COND_CMD(CONFIG_SHELL, loopback, NULL,
+					      "Measure round trip latency with an impulse. "
+					      "Needs the headset to loop audio back",
+					      cmd_usb_in_loopback),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(usb_in, &usb_in_cmd, "USB audio return path", NULL);
+#endif /* (CONFIG_STREAM_BIDIRECTIONAL) */
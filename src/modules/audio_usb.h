@@ -10,14 +10,36 @@
 #include "data_fifo.h"
 
 /**
- * @brief Set fifo buffers to be used by USB module and start sending/receiving data
+ * @brief Set fifo buffer to be used by USB module and start sending/receiving data
  *
- * @param fifo_tx_in  Pointer to fifo structure for tx
  * @param fifo_rx_in  Pointer to fifo structure for rx
  *
  * @return 0 if successful, error otherwise
  */
-int audio_usb_start(struct data_fifo *fifo_tx_in, struct data_fifo *fifo_rx_in);
+int audio_usb_start(struct data_fifo *fifo_rx_in);
+
+/**
+ * @brief Get the buffer for the next decoded frame of the return path
+ *
+ * @note The frame is sent on USB IN once committed. If the return path
+ *       is full, the oldest frame is dropped
+ *
+ * @param frame	[out] Buffer for one stereo frame
+ * @param size	[out] Size of the buffer
+ *
+ * @return 0 if successful, -ECANCELED if USB is stopped
+ */
+int audio_usb_in_frame_get(void **frame, size_t *size);
+
+/**
+ * @brief Commit the frame written to the buffer from audio_usb_in_frame_get
+ *
+ * @param frame	Buffer from audio_usb_in_frame_get
+ * @param size	Size of the frame, must be a full frame
+ *
+ * @return 0 if successful, error otherwise
+ */
+int audio_usb_in_frame_commit(void const *const frame, size_t size);
 
 /**
  * @brief Stop sending/receiving data
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "audio_usb_format.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(audio_usb_format, CONFIG_LOG_AUDIO_USB_LEVEL);
+
+#define CH_NUM 2
+#define PACKET_SIZE(rate, bits) (((rate) / 1000) * ((bits) / 8) * CH_NUM)
+
+static const struct audio_usb_format formats[] = {
+	{ .sample_rate_hz = 48000, .bit_depth = 16 },
+	{ .sample_rate_hz = 48000, .bit_depth = 24 },
+	{ .sample_rate_hz = 96000, .bit_depth = 16 },
+	{ .sample_rate_hz = 96000, .bit_depth = 24 },
+};
+
+BUILD_ASSERT(CONFIG_AUDIO_SAMPLE_RATE_HZ == 48000, "Conversion only supports 48 kHz output");
+
+/* Half-band low-pass for the 2:1 decimation, a Kaiser windowed sinc with
+ * 71 taps in Q15. Flat to 20 kHz, and at least 76 dB down from 28 kHz at
+ * 96 kHz input. Every other tap is zero, so only the taps at odd offsets
+ * from the center are listed. The center tap is one half
+ */
+static const int16_t hb_coef[] = {
+	10399, -3382, 1932, -1281, 901, -649, 470, -339, 240,
+	-167, 113, -73, 46, -27, 14, -7, 3, -1,
+};
+
+#define HB_TAPS (4 * ARRAY_SIZE(hb_coef) - 1)
+#define HB_CENTER_SHIFT 14
+#define DEC_IN_FRAMES_MAX 96
+
+/* Selected format, or NULL if no packet has been received */
+static const struct audio_usb_format *fmt_cur;
+/* Decimation input per channel, 24 bit. The last HB_TAPS - 1 samples of the
+ * previous packet are followed by the current packet
+ */
+static int32_t dec_buf[CH_NUM][HB_TAPS - 1 + DEC_IN_FRAMES_MAX];
+
+/* Round to the nearest 16 bit value, from a value with frac_bits more bits */
+static int16_t s16_round(int64_t val, uint8_t frac_bits)
+{
+	val = (val + (1LL << (frac_bits - 1))) >> frac_bits;
+
+	return (int16_t)CLAMP(val, INT16_MIN, INT16_MAX);
+}
+
+static int32_t s24_get(uint8_t const *in)
+{
+	return (int32_t)(sys_get_le24(in) << 8) >> 8;
+}
+
+/* Round packed 24 bit samples to 16 bit */
+static void s24_to_s16(uint8_t const *in, int16_t *out, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++) {
+		out[i] = s16_round(s24_get(in), 8);
+		in += 3;
+	}
+}
+
+/* Load one packet of 96 kHz stereo samples into dec_buf, scaled to 24 bit */
+static void dec_load(void const *in, uint8_t bit_depth, size_t frames_in)
+{
+	for (size_t i = 0; i < frames_in; i++) {
+		for (int ch = 0; ch < CH_NUM; ch++) {
+			int32_t *x = &dec_buf[ch][HB_TAPS - 1 + i];
+
+			if (bit_depth == 24) {
+				*x = s24_get((uint8_t const *)in + (i * CH_NUM + ch) * 3);
+			} else {
+				*x = (int32_t)((int16_t const *)in)[i * CH_NUM + ch] * 256;
+			}
+		}
+	}
+}
+
+/* 2:1 decimation of the packet in dec_buf with the half-band filter. Output i
+ * is centered on packet sample 2i - HB_TAPS / 2 + 1, so no look-ahead across
+ * packets is needed
+ */
+static void dec_filter(int16_t *out, size_t frames_out)
+{
+	for (int ch = 0; ch < CH_NUM; ch++) {
+		for (size_t i = 0; i < frames_out; i++) {
+			int32_t const *x = &dec_buf[ch][2 * i + 1 + HB_TAPS / 2];
+			int64_t acc = (int64_t)x[0] << HB_CENTER_SHIFT;
+
+			for (size_t k = 0; k < ARRAY_SIZE(hb_coef); k++) {
+				int offs = 2 * k + 1;
+
+				acc += (int64_t)hb_coef[k] * (x[-offs] + x[offs]);
+			}
+
+			/* Q15 coefficients on 24 bit input */
+			out[i * CH_NUM + ch] = s16_round(acc, 15 + 8);
+		}
+
+		memmove(dec_buf[ch], &dec_buf[ch][2 * frames_out],
+			(HB_TAPS - 1) * sizeof(dec_buf[ch][0]));
+	}
+}
+
+int audio_usb_format_detect(size_t packet_size)
+{
+	if (fmt_cur != NULL &&
+	    packet_size == PACKET_SIZE(fmt_cur->sample_rate_hz, fmt_cur->bit_depth)) {
+		return 0;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(formats); i++) {
+		if (packet_size == PACKET_SIZE(formats[i].sample_rate_hz, formats[i].bit_depth)) {
+			fmt_cur = &formats[i];
+			audio_usb_format_reset();
+			LOG_INF("USB format: %d bit, %d Hz", fmt_cur->bit_depth,
+				fmt_cur->sample_rate_hz);
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+bool audio_usb_format_is_native(void)
+{
+	return fmt_cur != NULL && fmt_cur->bit_depth == 16 &&
+	       fmt_cur->sample_rate_hz == CONFIG_AUDIO_SAMPLE_RATE_HZ;
+}
+
+int audio_usb_format_convert(void const *const in, size_t in_size, int16_t *out,
+			     size_t out_size_max, size_t *out_size)
+{
+	size_t in_frames;
+	size_t out_frames;
+
+	if (fmt_cur == NULL || in_size != PACKET_SIZE(fmt_cur->sample_rate_hz,
+						      fmt_cur->bit_depth)) {
+		return -EINVAL;
+	}
+
+	in_frames = in_size / ((fmt_cur->bit_depth / 8) * CH_NUM);
+	out_frames = in_frames * CONFIG_AUDIO_SAMPLE_RATE_HZ / fmt_cur->sample_rate_hz;
+
+	if ((out_frames * CH_NUM * sizeof(int16_t)) > out_size_max) {
+		return -ENOMEM;
+	}
+
+	if (fmt_cur->sample_rate_hz == CONFIG_AUDIO_SAMPLE_RATE_HZ) {
+		if (fmt_cur->bit_depth == 24) {
+			s24_to_s16(in, out, in_frames * CH_NUM);
+		} else {
+			memcpy(out, in, in_size);
+		}
+	} else {
+		dec_load(in, fmt_cur->bit_depth, in_frames);
+		dec_filter(out, out_frames);
+	}
+
+	*out_size = out_frames * CH_NUM * sizeof(int16_t);
+
+	return 0;
+}
+
+void audio_usb_format_get(struct audio_usb_format *fmt)
+{
+	if (fmt_cur == NULL) {
+		memset(fmt, 0, sizeof(*fmt));
+		return;
+	}
+
+	*fmt = *fmt_cur;
+}
+
+void audio_usb_format_reset(void)
+{
+	memset(dec_buf, 0, sizeof(dec_buf));
+}
+
+static int cmd_usb_fmt_show(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	if (fmt_cur == NULL) {
+		shell_print(shell, "No USB audio received yet");
+	} else {
+		shell_print(shell, "USB format: %d bit, %d Hz%s", fmt_cur->bit_depth,
+			    fmt_cur->sample_rate_hz,
+			    audio_usb_format_is_native() ? "" : ", converted");
+	}
+
+	shell_print(shell, "Accepted formats:");
+
+	for (int i = 0; i < ARRAY_SIZE(formats); i++) {
+		shell_print(shell, "\t%d bit, %d Hz", formats[i].bit_depth,
+			    formats[i].sample_rate_hz);
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(usb_fmt_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, show, NULL,
+					      "Show the USB OUT audio format", cmd_usb_fmt_show),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(usb_fmt, &usb_fmt_cmd, "USB audio format", NULL);
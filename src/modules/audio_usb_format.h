@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AUDIO_USB_FORMAT_H_
+#define _AUDIO_USB_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Conversion of USB OUT audio to the pipeline format
+ *
+ * Stereo 16 and 24 bit at 48 and 96 kHz are accepted. The format in use is
+ * found from the length of the 1 ms packets, which is unique for each of them.
+ * Audio is converted to 16 bit at CONFIG_AUDIO_SAMPLE_RATE_HZ, 24 bit samples
+ * are rounded and 96 kHz is decimated with a half-band filter.
+ *
+ * Only the conversion is done here. The USB audio class has one streaming
+ * alternate setting per direction, so the host sends the single format
+ * declared by the USB audio descriptors in devicetree.
+ */
+
+struct audio_usb_format {
+	uint32_t sample_rate_hz;
+	uint8_t bit_depth;
+};
+
+/**
+ * @brief Select the USB format from the length of a received packet
+ *
+ * @note The format change is logged, and the conversion state is reset
+ *
+ * @param packet_size	Size of a 1 ms USB OUT packet
+ *
+ * @return 0 if the format is supported, -EINVAL otherwise
+ */
+int audio_usb_format_detect(size_t packet_size);
+
+/**
+ * @brief Check if the selected USB format is the pipeline format
+ *
+ * @return true if packets can be used without conversion
+ */
+bool audio_usb_format_is_native(void);
+
+/**
+ * @brief Convert a packet in the selected USB format to the pipeline format
+ *
+ * @param in		Packet received on USB OUT
+ * @param in_size	Size of the packet
+ * @param out		Buffer for 1 ms of stereo audio in the pipeline format
+ * @param out_size_max	Size of the buffer
+ * @param out_size	[out] Size of the converted audio
+ *
+ * @return 0 if successful, error otherwise
+ */
+int audio_usb_format_convert(void const *const in, size_t in_size, int16_t *out,
+			     size_t out_size_max, size_t *out_size);
+
+/**
+ * @brief Get the selected USB format
+ *
+ * @param fmt	[out] Format, zero if no packet has been received yet
+ */
+void audio_usb_format_get(struct audio_usb_format *fmt);
+
+/**
+ * @brief Reset the conversion state, e.g. when the USB stream is restarted
+ */
+void audio_usb_format_reset(void);
+
+#endif /* _AUDIO_USB_FORMAT_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "audio_usb_out.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <errno.h>
+
+#include "channel_assignment.h"
+#include "pcm_stream_channel_modifier.h"
+
+#define USB_FRAME_SIZE_STEREO                                                                      \
+	(((CONFIG_AUDIO_SAMPLE_RATE_HZ * CONFIG_AUDIO_BIT_DEPTH_OCTETS) / 1000) * 2)
+#define CHUNKS_PER_FRAME (CONFIG_AUDIO_FRAME_DURATION_US / 1000)
+#define CH_CHUNK_SIZE (USB_FRAME_SIZE_STEREO / 2)
+#define CH_FRAME_SIZE (CH_CHUNK_SIZE * CHUNKS_PER_FRAME)
+/* One frame is encoded while the next ones are filled */
+#define FRAME_NUM (CONFIG_FIFO_RX_FRAME_COUNT + 1)
+
+static struct {
+	uint8_t pcm[FRAME_NUM][AUDIO_CH_NUM][CH_FRAME_SIZE] __aligned(sizeof(uint32_t));
+	/* Frame and 1 ms chunk written next. Only written by USB, and by a
+	 * restart while USB is stopped
+	 */
+	uint32_t wr_frame;
+	uint32_t wr_chunk;
+	/* Frame read next. Only written by the encoder */
+	atomic_t rd_frame;
+	/* The encoder holds frame rd_frame */
+	bool rd_held;
+} usb_out;
+
+static K_SEM_DEFINE(frames_sem, 0, FRAME_NUM);
+
+/* Serialises the reader against a restart */
+static struct k_spinlock rd_lock;
+
+int audio_usb_out_write(void const *const data, size_t size)
+{
+	int ret;
+	size_t size_mono;
+	uint32_t slot = usb_out.wr_frame % FRAME_NUM;
+	size_t offset = usb_out.wr_chunk * CH_CHUNK_SIZE;
+
+	if (size != USB_FRAME_SIZE_STEREO) {
+		return -EINVAL;
+	}
+
+	if (usb_out.wr_chunk == 0 &&
+	    (usb_out.wr_frame - (uint32_t)atomic_get(&usb_out.rd_frame)) >= FRAME_NUM) {
+		return -ENOMEM;
+	}
+
+	ret = pscm_two_channel_split(data, size, CONFIG_AUDIO_BIT_DEPTH_BITS,
+				     &usb_out.pcm[slot][AUDIO_CH_L][offset],
+				     &usb_out.pcm[slot][AUDIO_CH_R][offset], &size_mono);
+	if (ret) {
+		return ret;
+	}
+
+	if (++usb_out.wr_chunk == CHUNKS_PER_FRAME) {
+		usb_out.wr_chunk = 0;
+		usb_out.wr_frame++;
+		k_sem_give(&frames_sem);
+	}
+
+	return 0;
+}
+
+uint32_t audio_usb_out_fill_us_get(uint32_t *capacity_us)
+{
+	uint32_t frames = usb_out.wr_frame - (uint32_t)atomic_get(&usb_out.rd_frame);
+
+	*capacity_us = FRAME_NUM * CONFIG_AUDIO_FRAME_DURATION_US;
+
+	return (frames * CHUNKS_PER_FRAME + usb_out.wr_chunk) * 1000;
+}
+
+void audio_usb_out_restart(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&rd_lock);
+	uint32_t rd_frame = (uint32_t)atomic_get(&usb_out.rd_frame);
+
+	/* A frame held by the encoder is kept until it is freed, so its
+	 * buffer is not written again while it is encoded
+	 */
+	usb_out.wr_frame = usb_out.rd_held ? rd_frame + 1 : rd_frame;
+	usb_out.wr_chunk = 0;
+	k_sem_reset(&frames_sem);
+
+	k_spin_unlock(&rd_lock, key);
+}
+
+int audio_usb_out_frame_get(void *pcm_data_mono[], size_t *pcm_size_mono, k_timeout_t timeout)
+{
+	int ret;
+	uint32_t rd_frame;
+	uint32_t slot;
+	k_spinlock_key_t key;
+
+	ret = k_sem_take(&frames_sem, timeout);
+	if (ret) {
+		return ret;
+	}
+
+	key = k_spin_lock(&rd_lock);
+
+	rd_frame = (uint32_t)atomic_get(&usb_out.rd_frame);
+
+	if (rd_frame == usb_out.wr_frame) {
+		/* Dropped by a restart after the semaphore was taken */
+		k_spin_unlock(&rd_lock, key);
+		return -EAGAIN;
+	}
+
+	usb_out.rd_held = true;
+
+	k_spin_unlock(&rd_lock, key);
+
+	slot = rd_frame % FRAME_NUM;
+
+	for (int ch = 0; ch < AUDIO_CH_NUM; ch++) {
+		pcm_data_mono[ch] = usb_out.pcm[slot][ch];
+	}
+
+	*pcm_size_mono = CH_FRAME_SIZE;
+
+	return 0;
+}
+
+void audio_usb_out_frame_free(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&rd_lock);
+
+	if (usb_out.rd_held) {
+		usb_out.rd_held = false;
+		atomic_inc(&usb_out.rd_frame);
+	}
+
+	k_spin_unlock(&rd_lock, key);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AUDIO_USB_OUT_H_
+#define _AUDIO_USB_OUT_H_
+
+#include <zephyr/kernel.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Frame ring for USB OUT audio
+ *
+ * Each 1 ms USB OUT packet is split per channel straight into the frame
+ * buffers the encoder reads, so a packet is not copied again before it is
+ * encoded. USB is the only writer and the encoder the only reader.
+ */
+
+/**
+ * @brief Split a 1 ms stereo packet into the frame being filled
+ *
+ * @note When all frames are full, the packet is dropped. The encoder may
+ *	 hold the oldest frame, so it cannot be overwritten
+ *
+ * @param data	Interleaved stereo PCM
+ * @param size	Size of data, one 1 ms packet
+ *
+ * @return 0 if successful, -ENOMEM if the packet was dropped, -EINVAL if the
+ *	   size does not match
+ */
+int audio_usb_out_write(void const *const data, size_t size);
+
+/**
+ * @brief Get the amount of buffered audio
+ *
+ * @param capacity_us	[out] Audio the ring can hold, in us
+ *
+ * @return Buffered audio in us, including a partly filled frame
+ */
+uint32_t audio_usb_out_fill_us_get(uint32_t *capacity_us);
+
+/**
+ * @brief Drop all received audio, e.g. when the stream is stopped
+ *
+ * @note Must be called while USB does not write. A frame held by the
+ *	 encoder stays valid until it is freed. An encoder waiting in
+ *	 audio_usb_out_frame_get returns -EAGAIN
+ */
+void audio_usb_out_restart(void);
+
+/**
+ * @brief Get the next complete frame received on USB OUT
+ *
+ * @note The frame stays valid until audio_usb_out_frame_free is called.
+ *	 Only one frame can be held at a time
+ *
+ * @param pcm_data_mono	[out] Buffer for each channel, AUDIO_CH_NUM entries
+ * @param pcm_size_mono	[out] Size of each channel buffer
+ * @param timeout	Time to wait for a frame
+ *
+ * @return 0 if successful, -EAGAIN or -EBUSY if no frame is ready, -EAGAIN also
+ *	   if the frame was dropped by audio_usb_out_restart
+ */
+int audio_usb_out_frame_get(void *pcm_data_mono[], size_t *pcm_size_mono, k_timeout_t timeout);
+
+/**
+ * @brief Release the frame from audio_usb_out_frame_get
+ */
+void audio_usb_out_frame_free(void);
+
+#endif /* _AUDIO_USB_OUT_H_ */
@@ -141,17 +141,19 @@ static void button_isr(const struct device *port, struct gpio_callback *cb, uint
 	event.button_activity.button_action = BUTTON_PRESS;
 	event.event_source = EVT_SRC_BUTTON;
 
-	/* To avoid filling up the event queue with button presses,
-	 * we only allow button events if all other events have been processed
+	/* Button events are queued separately from stream state events, and
+	 * volume presses are coalesced, so a burst of presses can only fill
+	 * up the UI event queue
 	 */
-	if (ctrl_events_queue_empty()) {
-		ret = ctrl_events_put(&event);
-		ERR_CHK(ret);
-		debounce_is_ongoing = true;
-		k_timer_start(&button_debounce_timer, K_MSEC(CONFIG_BUTTON_DEBOUNCE_MS), K_NO_WAIT);
-	} else {
-		LOG_WRN("Event queue is not empty, try again later");
+	ret = ctrl_events_put(&event);
+	if (ret == -ENOMSG) {
+		LOG_WRN("Event queue is full, try again later");
+		return;
 	}
+	ERR_CHK(ret);
+
+	debounce_is_ongoing = true;
+	k_timer_start(&button_debounce_timer, K_MSEC(CONFIG_BUTTON_DEBOUNCE_MS), K_NO_WAIT);
 }
 
 int button_pressed(gpio_pin_t button_pin, bool *button_pressed)
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "audio_trace.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "audio_sync_timer.h"
+
+#define EVT_NUM CONFIG_AUDIO_TRACE_EVT_NUM
+#define EVT_HEX_LEN (sizeof(struct audio_trace_evt) * 2 + 1)
+
+BUILD_ASSERT((EVT_NUM & (EVT_NUM - 1)) == 0, "AUDIO_TRACE_EVT_NUM must be a power of two");
+BUILD_ASSERT(sizeof(struct audio_trace_evt) == 12, "Record layout is shared with the decoder");
+
+static struct audio_trace_evt evts[EVT_NUM];
+/* Events reserved so far, used modulo EVT_NUM */
+static atomic_t head;
+static atomic_t full;
+static atomic_t enabled = ATOMIC_INIT(0);
+
+void audio_trace_event_ts(uint32_t ts_us, uint8_t id, uint8_t a8, uint16_t a16, uint32_t a32)
+{
+	if (!atomic_get(&enabled)) {
+		return;
+	}
+
+	uint32_t idx = (uint32_t)atomic_inc(&head) % EVT_NUM;
+	struct audio_trace_evt *evt = &evts[idx];
+
+	if (idx == (EVT_NUM - 1)) {
+		atomic_set(&full, 1);
+	}
+
+	/* The ID is written last, so a dump can tell a record being written */
+	evt->id = 0;
+	compiler_barrier();
+
+	evt->ts_us = ts_us;
+	evt->a8 = a8;
+	evt->a16 = a16;
+	evt->a32 = a32;
+
+	compiler_barrier();
+	evt->id = id;
+}
+
+void audio_trace_event(uint8_t id, uint8_t a8, uint16_t a16, uint32_t a32)
+{
+	audio_trace_event_ts(audio_sync_timer_curr_time_get(), id, a8, a16, a32);
+}
+
+static int cmd_audio_trace_dump(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	char hex[EVT_HEX_LEN];
+	bool was_enabled = atomic_clear(&enabled);
+	uint32_t end = (uint32_t)atomic_get(&head);
+	uint32_t num = atomic_get(&full) ? EVT_NUM : MIN(end, EVT_NUM);
+
+	shell_print(shell, "AT_BEGIN %u", num);
+
+	for (uint32_t i = end - num; i != end; i++) {
+		struct audio_trace_evt *evt = &evts[i % EVT_NUM];
+		struct audio_trace_evt copy;
+		uint8_t id = evt->id;
+
+		if (id == 0) {
+			continue;
+		}
+
+		compiler_barrier();
+		memcpy(&copy, evt, sizeof(copy));
+		compiler_barrier();
+
+		/* A writer that was interrupted before recording was disabled may
+		 * rewrite the record while it is copied, skip it then
+		 */
+		if (evt->id != id || copy.id != id) {
+			continue;
+		}
+
+		(void)bin2hex((uint8_t *)&copy, sizeof(copy), hex, sizeof(hex));
+		shell_print(shell, "AT:%s", hex);
+	}
+
+	shell_print(shell, "AT_END");
+
+	if (was_enabled) {
+		atomic_set(&enabled, 1);
+	}
+
+	return 0;
+}
+
+static int cmd_audio_trace_clear(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	bool was_enabled = atomic_clear(&enabled);
+
+	memset(evts, 0, sizeof(evts));
+	atomic_clear(&head);
+	atomic_clear(&full);
+
+	if (was_enabled) {
+		atomic_set(&enabled, 1);
+	}
+
+	shell_print(shell, "Audio trace cleared");
+
+	return 0;
+}
+
+static int cmd_audio_trace_start(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	atomic_set(&enabled, 1);
+
+	shell_print(shell, "Audio trace started");
+
+	return 0;
+}
+
+static int cmd_audio_trace_stop(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	atomic_clear(&enabled);
+
+	shell_print(shell, "Audio trace stopped");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(audio_trace_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, dump, NULL,
+					      "Dump the trace as hex records for tools/audio_trace",
+					      cmd_audio_trace_dump),
+			       SHELL_COND_CMD(CONFIG_SHELL, clear, NULL, "Clear the trace",
+					      cmd_audio_trace_clear),
+			       SHELL_COND_CMD(CONFIG_SHELL, start, NULL, "Start recording",
+					      cmd_audio_trace_start),
+			       SHELL_COND_CMD(CONFIG_SHELL, stop, NULL,
+					      "Stop recording, e.g. right after an issue",
+					      cmd_audio_trace_stop),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(audio_trace, &audio_trace_cmd, "Audio timing trace", NULL);
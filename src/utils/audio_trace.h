@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AUDIO_TRACE_H_
+#define _AUDIO_TRACE_H_
+
+#include <stdint.h>
+
+/*
+ * Binary trace of audio timing events
+ *
+ * Events are written to a ring buffer from ISR or thread context without
+ * locks, and timestamped with the audio sync timer. The oldest events are
+ * overwritten. Recording starts disabled and is started by the audio_trace
+ * shell command. The buffer is dumped as hex lines by the same command, over
+ * UART or RTT, and decoded by tools/audio_trace.
+ *
+ * Event IDs and the record layout are shared with the decoder, so existing
+ * values must not change.
+ */
+
+enum audio_trace_id {
+	/* ts: I2S frame start, a16: out.fifo consumer block, a32: producer block */
+	AUDIO_TRACE_I2S_FRAME_START = 1,
+	/* ts: frame received, a8: bad frame, a32: sdu_ref */
+	AUDIO_TRACE_SDU_RECV = 2,
+	/* a8: new drift compensation state */
+	AUDIO_TRACE_DRIFT_STATE = 3,
+	/* a8: new presentation compensation state */
+	AUDIO_TRACE_PRES_STATE = 4,
+	/* a32: presentation delay adjustment in us, signed */
+	AUDIO_TRACE_PRES_ADJ = 5,
+	/* a32: total I2S TX underrun blocks */
+	AUDIO_TRACE_I2S_UNDERRUN = 6,
+	/* ts: I2S frame start. An I2S RX block was dropped */
+	AUDIO_TRACE_I2S_OVERRUN = 7,
+};
+
+/* Record layout, little endian */
+struct audio_trace_evt {
+	uint32_t ts_us;
+	uint8_t id;
+	uint8_t a8;
+	uint16_t a16;
+	uint32_t a32;
+};
+
+#if (CONFIG_AUDIO_TRACE)
+/**
+ * @brief Record an event with a given timestamp
+ *
+ * @param ts_us	Audio sync timer timestamp
+ * @param id	Event ID, see enum audio_trace_id
+ * @param a8	Event argument
+ * @param a16	Event argument
+ * @param a32	Event argument
+ */
+void audio_trace_event_ts(uint32_t ts_us, uint8_t id, uint8_t a8, uint16_t a16, uint32_t a32);
+
+/**
+ * @brief Record an event timestamped with the current audio sync timer value
+ *
+ * @param id	Event ID, see enum audio_trace_id
+ * @param a8	Event argument
+ * @param a16	Event argument
+ * @param a32	Event argument
+ */
+void audio_trace_event(uint8_t id, uint8_t a8, uint16_t a16, uint32_t a32);
+
+#define AUDIO_TRACE(id, a8, a16, a32) audio_trace_event(id, a8, a16, a32)
+#define AUDIO_TRACE_TS(ts_us, id, a8, a16, a32) audio_trace_event_ts(ts_us, id, a8, a16, a32)
+#else
+#define AUDIO_TRACE(id, a8, a16, a32)
+#define AUDIO_TRACE_TS(ts_us, id, a8, a16, a32)
+#endif /* (CONFIG_AUDIO_TRACE) */
+
+#endif /* _AUDIO_TRACE_H_ */
@@ -7,13 +7,80 @@
 #include "data_fifo.h"
 
 #include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
 
 #include "macros_common.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(data_fifo, CONFIG_LOG_DEFAULT_LEVEL);
 
-static struct k_spinlock lock;
+#if (CONFIG_DATA_FIFO_STATS)
+static sys_slist_t fifo_list = SYS_SLIST_STATIC_INIT(&fifo_list);
+
+static void stats_reset(struct data_fifo_stats *stats)
+{
+	stats->locked_max = 0;
+	stats->locked_min = UINT32_MAX;
+	stats->overruns = 0;
+	stats->underruns = 0;
+	stats->residency_cnt = 0;
+	stats->residency_max_us = 0;
+	stats->residency_sum_us = 0;
+}
+
+/* The stats are updated from ISR and thread context, so they are kept under the
+ * instance lock. The lock is only taken for the update, also on the lock-free SPSC paths
+ */
+
+/* Timestamp block and update high watermark. locked_num is the count including the block */
+static inline void stats_lock(struct data_fifo *data_fifo, struct data_fifo_msgq *elem,
+			      uint32_t locked_num)
+{
+	elem->lock_ts = k_cycle_get_32();
+
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+	data_fifo->stats.locked_max = MAX(data_fifo->stats.locked_max, locked_num);
+
+	k_spin_unlock(&data_fifo->lock, key);
+}
+
+/* Update residency and low watermark. locked_num is the count excluding the block */
+static inline void stats_get(struct data_fifo *data_fifo, struct data_fifo_msgq *elem,
+			     uint32_t locked_num)
+{
+	struct data_fifo_stats *stats = &data_fifo->stats;
+	uint32_t residency_us = k_cyc_to_us_floor32(k_cycle_get_32() - elem->lock_ts);
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+	stats->locked_min = MIN(stats->locked_min, locked_num);
+	stats->residency_max_us = MAX(stats->residency_max_us, residency_us);
+	stats->residency_sum_us += residency_us;
+	stats->residency_cnt++;
+
+	k_spin_unlock(&data_fifo->lock, key);
+}
+
+static inline void stats_count(struct data_fifo *data_fifo, uint32_t *counter)
+{
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+	(*counter)++;
+
+	k_spin_unlock(&data_fifo->lock, key);
+}
+
+#define STATS_LOCK(fifo, elem, num) stats_lock(fifo, elem, num)
+#define STATS_GET(fifo, elem, num) stats_get(fifo, elem, num)
+#define STATS_OVERRUN(fifo) stats_count(fifo, &(fifo)->stats.overruns)
+#define STATS_UNDERRUN(fifo) stats_count(fifo, &(fifo)->stats.underruns)
+#else
+#define STATS_LOCK(fifo, elem, num)
+#define STATS_GET(fifo, elem, num)
+#define STATS_OVERRUN(fifo)
+#define STATS_UNDERRUN(fifo)
+#endif /* (CONFIG_DATA_FIFO_STATS) */
 
 /** @brief Checks that the elements in the msgq and slab are legal.
  * I.e. the number of msgq elements cannot be more than mem blocks used.
@@ -22,12 +89,12 @@ static int msgq_slab_legal_used_elements(struct data_fifo *data_fifo, uint32_t *
 					 uint32_t *slab_blocks_num_used_in)
 {
 	/* Lock so msgq and slab reads are in sync */
-	k_spinlock_key_t key = k_spin_lock(&lock);
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
 
 	uint32_t msgq_num_used = k_msgq_num_used_get(&data_fifo->msgq);
 	uint32_t slab_blocks_num_used = k_mem_slab_num_used_get(&data_fifo->mem_slab);
 
-	k_spin_unlock(&lock, key);
+	k_spin_unlock(&data_fifo->lock, key);
 
 	if (slab_blocks_num_used < msgq_num_used) {
 		LOG_ERR("Num used mgsq %d cannot be larger than used blocks %d", msgq_num_used,
@@ -43,6 +110,256 @@ static int msgq_slab_legal_used_elements(struct data_fifo *data_fifo, uint32_t *
 	return 0;
 }
 
+#if (CONFIG_DATA_FIFO_SPSC)
+static inline uint32_t spsc_idx_next(struct data_fifo *data_fifo, uint32_t idx)
+{
+	return ((idx + 1) == (2 * data_fifo->elements_max)) ? 0 : (idx + 1);
+}
+
+/* Number of elements between two ring indices */
+static inline uint32_t spsc_dist(struct data_fifo *data_fifo, uint32_t head, uint32_t tail)
+{
+	return (head + (2 * data_fifo->elements_max) - tail) % (2 * data_fifo->elements_max);
+}
+
+static inline struct data_fifo_msgq *spsc_slot(struct data_fifo *data_fifo, uint32_t idx)
+{
+	return &((struct data_fifo_msgq *)data_fifo->msgq_buffer)[idx % data_fifo->elements_max];
+}
+
+/**
+ * @brief Wait for the other side of the ring to make progress
+ *
+ * @note The waiting flag is set before the condition is checked again, so
+ *	 the other side either sees the flag and gives the semaphore, or the
+ *	 progress is seen here. Stale semaphore counts only cause a re-check.
+ */
+static int spsc_wait(atomic_t *waiting, struct k_sem *sem,
+		     bool (*ready)(struct data_fifo *, uint32_t), struct data_fifo *data_fifo,
+		     uint32_t num, k_timeout_t timeout)
+{
+	int ret;
+
+	atomic_set(waiting, 1);
+
+	if (ready(data_fifo, num)) {
+		atomic_clear(waiting);
+		return 0;
+	}
+
+	ret = k_sem_take(sem, timeout);
+	atomic_clear(waiting);
+
+	return ret;
+}
+
+/* Map a failed wait to -ECANCELED if the ring was emptied since gen was read */
+static inline int spsc_wait_ret(struct data_fifo *data_fifo, uint32_t gen, int ret)
+{
+	return (atomic_get(&data_fifo->ring.gen) != gen) ? -ECANCELED : ret;
+}
+
+/* Publish a new consumer index, unless the ring was emptied since gen was read.
+ * The lock only spans the check and the store, and is shared with spsc_reset.
+ */
+static bool spsc_consumer_commit(struct data_fifo *data_fifo, atomic_t *idx, uint32_t val,
+				 uint32_t gen)
+{
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+	bool valid = (atomic_get(&data_fifo->ring.gen) == gen);
+
+	if (valid) {
+		atomic_set(idx, val);
+	}
+
+	k_spin_unlock(&data_fifo->lock, key);
+
+	return valid;
+}
+
+/* Check if num blocks can be allocated */
+static bool spsc_space_ready(struct data_fifo *data_fifo, uint32_t num)
+{
+	return (spsc_dist(data_fifo, atomic_get(&data_fifo->ring.alloc_idx),
+			  atomic_get(&data_fifo->ring.free_idx)) +
+		num) <= data_fifo->elements_max;
+}
+
+/* Check if num blocks can be fetched */
+static bool spsc_data_ready(struct data_fifo *data_fifo, uint32_t num)
+{
+	return spsc_dist(data_fifo, atomic_get(&data_fifo->ring.lock_idx),
+			 atomic_get(&data_fifo->ring.get_idx)) >= num;
+}
+
+static int spsc_vacant_get(struct data_fifo *data_fifo, void **data, k_timeout_t timeout)
+{
+	int ret;
+	uint32_t gen = atomic_get(&data_fifo->ring.gen);
+
+	while (!spsc_space_ready(data_fifo, 1)) {
+		if (K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+			STATS_OVERRUN(data_fifo);
+			return -ENOMEM;
+		}
+
+		ret = spsc_wait(&data_fifo->ring.producer_waiting, &data_fifo->ring.space_sem,
+				spsc_space_ready, data_fifo, 1, timeout);
+		if (ret) {
+			STATS_OVERRUN(data_fifo);
+			return spsc_wait_ret(data_fifo, gen, ret);
+		}
+	}
+
+	uint32_t alloc_idx = atomic_get(&data_fifo->ring.alloc_idx);
+	struct data_fifo_msgq *slot = spsc_slot(data_fifo, alloc_idx);
+
+	slot->block_ptr = &data_fifo->slab_buffer[(alloc_idx % data_fifo->elements_max) *
+						  data_fifo->block_size_max];
+	*data = slot->block_ptr;
+
+	atomic_set(&data_fifo->ring.alloc_idx, spsc_idx_next(data_fifo, alloc_idx));
+
+	return 0;
+}
+
+static int spsc_block_lock(struct data_fifo *data_fifo, void **data, size_t size)
+{
+	uint32_t lock_idx = atomic_get(&data_fifo->ring.lock_idx);
+	struct data_fifo_msgq *slot = spsc_slot(data_fifo, lock_idx);
+
+	if (lock_idx == atomic_get(&data_fifo->ring.alloc_idx) || slot->block_ptr != *data) {
+		LOG_ERR("Block must be locked in allocation order");
+		return -EPERM;
+	}
+
+	slot->size = size;
+	STATS_LOCK(data_fifo, slot,
+		   spsc_dist(data_fifo, lock_idx, atomic_get(&data_fifo->ring.get_idx)) + 1);
+
+	/* Publish the block to the consumer */
+	atomic_set(&data_fifo->ring.lock_idx, spsc_idx_next(data_fifo, lock_idx));
+
+	if (atomic_get(&data_fifo->ring.consumer_waiting)) {
+		k_sem_give(&data_fifo->ring.data_sem);
+	}
+
+	return 0;
+}
+
+static int spsc_last_filled_get(struct data_fifo *data_fifo, void **data, size_t *size,
+				k_timeout_t timeout)
+{
+	int ret;
+	uint32_t gen = atomic_get(&data_fifo->ring.gen);
+
+	while (!spsc_data_ready(data_fifo, 1)) {
+		if (K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+			STATS_UNDERRUN(data_fifo);
+			return -ENOMSG;
+		}
+
+		ret = spsc_wait(&data_fifo->ring.consumer_waiting, &data_fifo->ring.data_sem,
+				spsc_data_ready, data_fifo, 1, timeout);
+		if (ret) {
+			STATS_UNDERRUN(data_fifo);
+			return spsc_wait_ret(data_fifo, gen, ret);
+		}
+	}
+
+	uint32_t get_idx = atomic_get(&data_fifo->ring.get_idx);
+	struct data_fifo_msgq *slot = spsc_slot(data_fifo, get_idx);
+
+	*data = slot->block_ptr;
+	*size = slot->size;
+	STATS_GET(data_fifo, slot,
+		  spsc_dist(data_fifo, atomic_get(&data_fifo->ring.lock_idx), get_idx) - 1);
+
+	if (!spsc_consumer_commit(data_fifo, &data_fifo->ring.get_idx,
+				  spsc_idx_next(data_fifo, get_idx), gen)) {
+		return -ECANCELED;
+	}
+
+	data_fifo->ring.get_gen = gen;
+
+	return 0;
+}
+
+/* Check if the blocks held by the consumer were fetched before a reset */
+static bool spsc_held_stale(struct data_fifo *data_fifo)
+{
+	if (data_fifo->ring.get_gen != atomic_get(&data_fifo->ring.gen)) {
+		LOG_DBG("Free of blocks fetched before reset ignored");
+		return true;
+	}
+
+	return false;
+}
+
+static int spsc_block_free(struct data_fifo *data_fifo, void **data)
+{
+	if (spsc_held_stale(data_fifo)) {
+		return 0;
+	}
+
+	uint32_t free_idx = atomic_get(&data_fifo->ring.free_idx);
+	struct data_fifo_msgq *slot = spsc_slot(data_fifo, free_idx);
+
+	if (free_idx == atomic_get(&data_fifo->ring.get_idx) || slot->block_ptr != *data) {
+		LOG_ERR("Block must be freed in fetch order");
+		return -EPERM;
+	}
+
+	/* Hand the block back to the producer */
+	if (!spsc_consumer_commit(data_fifo, &data_fifo->ring.free_idx,
+				  spsc_idx_next(data_fifo, free_idx), data_fifo->ring.get_gen)) {
+		return 0;
+	}
+
+	if (atomic_get(&data_fifo->ring.producer_waiting)) {
+		k_sem_give(&data_fifo->ring.space_sem);
+	}
+
+	return 0;
+}
+
+/* Advance a ring index by n */
+static inline uint32_t spsc_idx_add(struct data_fifo *data_fifo, uint32_t idx, uint32_t n)
+{
+	return (idx + n) % (2 * data_fifo->elements_max);
+}
+
+static void spsc_num_used_get(struct data_fifo *data_fifo, uint32_t *alloced_num,
+			      uint32_t *locked_num)
+{
+	/* Read order makes sure alloced_num is never smaller than locked_num */
+	uint32_t free_idx = atomic_get(&data_fifo->ring.free_idx);
+	uint32_t get_idx = atomic_get(&data_fifo->ring.get_idx);
+	uint32_t lock_idx = atomic_get(&data_fifo->ring.lock_idx);
+	uint32_t alloc_idx = atomic_get(&data_fifo->ring.alloc_idx);
+
+	*alloced_num = spsc_dist(data_fifo, alloc_idx, free_idx);
+	*locked_num = spsc_dist(data_fifo, lock_idx, get_idx);
+}
+
+static void spsc_reset(struct data_fifo *data_fifo)
+{
+	k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+	atomic_inc(&data_fifo->ring.gen);
+	atomic_clear(&data_fifo->ring.alloc_idx);
+	atomic_clear(&data_fifo->ring.lock_idx);
+	atomic_clear(&data_fifo->ring.get_idx);
+	atomic_clear(&data_fifo->ring.free_idx);
+
+	k_spin_unlock(&data_fifo->lock, key);
+
+	/* Wake up a blocked side, which then sees the new generation */
+	k_sem_reset(&data_fifo->ring.space_sem);
+	k_sem_reset(&data_fifo->ring.data_sem);
+}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 int data_fifo_pointer_first_vacant_get(struct data_fifo *data_fifo, void **data,
 				       k_timeout_t timeout)
 {
@@ -50,7 +367,17 @@ int data_fifo_pointer_first_vacant_get(struct data_fifo *data_fifo, void **data,
 	__ASSERT_NO_MSG(data_fifo->initialized);
 	int ret;
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		return spsc_vacant_get(data_fifo, data, timeout);
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	ret = k_mem_slab_alloc(&data_fifo->mem_slab, data, timeout);
+	if (ret) {
+		STATS_OVERRUN(data_fifo);
+	}
+
 	return ret;
 }
 
@@ -68,10 +395,17 @@ int data_fifo_block_lock(struct data_fifo *data_fifo, void **data, size_t size)
 		return -EINVAL;
 	}
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		return spsc_block_lock(data_fifo, data, size);
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	struct data_fifo_msgq msgq_tmp;
 
 	msgq_tmp.block_ptr = *data;
 	msgq_tmp.size = size;
+	STATS_LOCK(data_fifo, &msgq_tmp, k_msgq_num_used_get(&data_fifo->msgq) + 1);
 
 	/* Since num elements in the slab and msgq are equal, there
 	 * must be space in the queue. if k_msg_put fails, it
@@ -93,13 +427,22 @@ int data_fifo_pointer_last_filled_get(struct data_fifo *data_fifo, void **data,
 	__ASSERT_NO_MSG(data_fifo->initialized);
 	int ret;
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		return spsc_last_filled_get(data_fifo, data, size, timeout);
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	struct data_fifo_msgq msgq_tmp;
 
 	ret = k_msgq_get(&data_fifo->msgq, &msgq_tmp, timeout);
 	if (ret) {
+		STATS_UNDERRUN(data_fifo);
 		return ret;
 	}
 
+	STATS_GET(data_fifo, &msgq_tmp, k_msgq_num_used_get(&data_fifo->msgq));
+
 	*data = msgq_tmp.block_ptr;
 	*size = msgq_tmp.size;
 	return 0;
@@ -110,11 +453,114 @@ int data_fifo_block_free(struct data_fifo *data_fifo, void **data)
 	__ASSERT_NO_MSG(data_fifo != NULL);
 	__ASSERT_NO_MSG(data_fifo->initialized);
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		return spsc_block_free(data_fifo, data);
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	k_mem_slab_free(&data_fifo->mem_slab, data);
 
 	return 0;
 }
 
+#if (CONFIG_DATA_FIFO_SPSC)
+int data_fifo_span_get(struct data_fifo *data_fifo, void **data, size_t *size,
+		       uint32_t num_blocks, k_timeout_t timeout)
+{
+	__ASSERT_NO_MSG(data_fifo != NULL);
+	__ASSERT_NO_MSG(data_fifo->initialized);
+	int ret;
+
+	if (!data_fifo->spsc || num_blocks == 0 || num_blocks > data_fifo->span_max) {
+		return -EINVAL;
+	}
+
+	uint32_t gen = atomic_get(&data_fifo->ring.gen);
+
+	while (!spsc_data_ready(data_fifo, num_blocks)) {
+		if (K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+			STATS_UNDERRUN(data_fifo);
+			return -ENOMSG;
+		}
+
+		/* Woken on every lock, re-check until the whole span is filled */
+		ret = spsc_wait(&data_fifo->ring.consumer_waiting, &data_fifo->ring.data_sem,
+				spsc_data_ready, data_fifo, num_blocks, timeout);
+		if (ret) {
+			STATS_UNDERRUN(data_fifo);
+			return spsc_wait_ret(data_fifo, gen, ret);
+		}
+	}
+
+	uint32_t get_idx = atomic_get(&data_fifo->ring.get_idx);
+	uint32_t first_slot = get_idx % data_fifo->elements_max;
+
+	for (uint32_t i = 0; i < num_blocks; i++) {
+		if (spsc_slot(data_fifo, get_idx + i)->size != data_fifo->block_size_max) {
+			LOG_ERR("Span block %d not filled", i);
+			return -EMSGSIZE;
+		}
+	}
+
+	if ((first_slot + num_blocks) > data_fifo->elements_max) {
+		/* Span wraps the end of the ring, copy the head blocks into the slack */
+		uint32_t num_wrapped = first_slot + num_blocks - data_fifo->elements_max;
+
+		memcpy(&data_fifo->slab_buffer[data_fifo->elements_max * data_fifo->block_size_max],
+		       data_fifo->slab_buffer, num_wrapped * data_fifo->block_size_max);
+	}
+
+	*data = spsc_slot(data_fifo, get_idx)->block_ptr;
+	*size = num_blocks * data_fifo->block_size_max;
+	STATS_GET(data_fifo, spsc_slot(data_fifo, get_idx),
+		  spsc_dist(data_fifo, atomic_get(&data_fifo->ring.lock_idx), get_idx) - num_blocks);
+
+	if (!spsc_consumer_commit(data_fifo, &data_fifo->ring.get_idx,
+				  spsc_idx_add(data_fifo, get_idx, num_blocks), gen)) {
+		return -ECANCELED;
+	}
+
+	data_fifo->ring.get_gen = gen;
+
+	return 0;
+}
+
+int data_fifo_span_free(struct data_fifo *data_fifo, void **data, uint32_t num_blocks)
+{
+	__ASSERT_NO_MSG(data_fifo != NULL);
+	__ASSERT_NO_MSG(data_fifo->initialized);
+
+	if (!data_fifo->spsc) {
+		return -EPERM;
+	}
+
+	if (spsc_held_stale(data_fifo)) {
+		return 0;
+	}
+
+	uint32_t free_idx = atomic_get(&data_fifo->ring.free_idx);
+
+	if (spsc_dist(data_fifo, atomic_get(&data_fifo->ring.get_idx), free_idx) < num_blocks ||
+	    spsc_slot(data_fifo, free_idx)->block_ptr != *data) {
+		LOG_ERR("Span must be freed in fetch order");
+		return -EPERM;
+	}
+
+	if (!spsc_consumer_commit(data_fifo, &data_fifo->ring.free_idx,
+				  spsc_idx_add(data_fifo, free_idx, num_blocks),
+				  data_fifo->ring.get_gen)) {
+		return 0;
+	}
+
+	if (atomic_get(&data_fifo->ring.producer_waiting)) {
+		k_sem_give(&data_fifo->ring.space_sem);
+	}
+
+	return 0;
+}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 int data_fifo_num_used_get(struct data_fifo *data_fifo, uint32_t *alloced_num, uint32_t *locked_num)
 {
 	__ASSERT_NO_MSG(data_fifo != NULL);
@@ -124,6 +570,13 @@ int data_fifo_num_used_get(struct data_fifo *data_fifo, uint32_t *alloced_num, u
 	uint32_t msgq_num_used = UINT32_MAX;
 	uint32_t slab_blocks_num_used = UINT32_MAX;
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		spsc_num_used_get(data_fifo, alloced_num, locked_num);
+		return 0;
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	ret = msgq_slab_legal_used_elements(data_fifo, &msgq_num_used, &slab_blocks_num_used);
 	if (ret) {
 		return ret;
@@ -142,6 +595,14 @@ int data_fifo_empty(struct data_fifo *data_fifo)
 	void *old_data;
 	size_t size;
 
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		/* The producer must be stopped, a waiting consumer gets -ECANCELED */
+		spsc_reset(data_fifo);
+		return 0;
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	ret = data_fifo_num_used_get(data_fifo, &fifo_alloced_num, &fifo_locked_num);
 	if (ret) {
 		LOG_ERR("Failed to get num used in FIFO");
@@ -184,6 +645,22 @@ int data_fifo_init(struct data_fifo *data_fifo)
 	__ASSERT_NO_MSG((data_fifo->block_size_max % WB_UP(1)) == 0);
 	int ret;
 
+#if (CONFIG_DATA_FIFO_STATS)
+	stats_reset(&data_fifo->stats);
+	sys_slist_append(&fifo_list, &data_fifo->stats.node);
+#endif /* (CONFIG_DATA_FIFO_STATS) */
+
+#if (CONFIG_DATA_FIFO_SPSC)
+	if (data_fifo->spsc) {
+		k_sem_init(&data_fifo->ring.space_sem, 0, 1);
+		k_sem_init(&data_fifo->ring.data_sem, 0, 1);
+		spsc_reset(data_fifo);
+		data_fifo->initialized = true;
+
+		return 0;
+	}
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 	k_msgq_init(&data_fifo->msgq, data_fifo->msgq_buffer, sizeof(struct data_fifo_msgq),
 		    data_fifo->elements_max);
 
@@ -198,3 +675,81 @@ int data_fifo_init(struct data_fifo *data_fifo)
 
 	return ret;
 }
+
+#if (CONFIG_DATA_FIFO_STATS)
+static int cmd_fifo_stats(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	int ret;
+	struct data_fifo_stats *stats;
+	struct data_fifo_stats snap;
+
+	shell_print(shell, "%-14s %5s %5s %5s %5s %8s %8s %9s %9s", "name", "alloc", "lock",
+		    "hwm", "lwm", "overrun", "underrun", "res_avg", "res_max");
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&fifo_list, stats, node) {
+		struct data_fifo *data_fifo = CONTAINER_OF(stats, struct data_fifo, stats);
+		uint32_t alloced_num = 0;
+		uint32_t locked_num = 0;
+
+		if (!data_fifo->initialized) {
+			continue;
+		}
+
+		ret = data_fifo_num_used_get(data_fifo, &alloced_num, &locked_num);
+		if (ret) {
+			shell_warn(shell, "%s: illegal state %d", stats->name, ret);
+		}
+
+		k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+		snap = *stats;
+
+		k_spin_unlock(&data_fifo->lock, key);
+
+		shell_print(shell, "%-14s %5u %5u %5u %5d %8u %8u %6u us %6u us", snap.name,
+			    alloced_num, locked_num, snap.locked_max,
+			    (snap.locked_min == UINT32_MAX) ? -1 : (int)snap.locked_min,
+			    snap.overruns, snap.underruns,
+			    snap.residency_cnt ?
+				    (uint32_t)(snap.residency_sum_us / snap.residency_cnt) :
+				    0,
+			    snap.residency_max_us);
+	}
+
+	return 0;
+}
+
+static int cmd_fifo_stats_reset(const struct shell *shell, size_t argc, const char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct data_fifo_stats *stats;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&fifo_list, stats, node) {
+		struct data_fifo *data_fifo = CONTAINER_OF(stats, struct data_fifo, stats);
+		k_spinlock_key_t key = k_spin_lock(&data_fifo->lock);
+
+		stats_reset(stats);
+
+		k_spin_unlock(&data_fifo->lock, key);
+	}
+
+	shell_print(shell, "FIFO statistics reset");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(fifo_cmd,
+			       SHELL_COND_CMD(CONFIG_SHELL, stats, NULL,
+					      "Show watermarks, overruns and residency of all FIFOs",
+					      cmd_fifo_stats),
+			       SHELL_COND_CMD(CONFIG_SHELL, reset, NULL, "Reset FIFO statistics",
+					      cmd_fifo_stats_reset),
+			       SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(fifo, &fifo_cmd, "data_fifo statistics", NULL);
+#endif /* (CONFIG_DATA_FIFO_STATS) */
@@ -17,8 +17,59 @@
 struct data_fifo_msgq {
 	void *block_ptr;
 	size_t size;
+#if (CONFIG_DATA_FIFO_STATS)
+	/* Cycle count when the block was locked */
+	uint32_t lock_ts;
+#endif /* (CONFIG_DATA_FIFO_STATS) */
 };
 
+#if (CONFIG_DATA_FIFO_STATS)
+/* Updated and read under the data_fifo lock */
+struct data_fifo_stats {
+	sys_snode_t node;
+	const char *name;
+	/* High and low watermark of locked blocks, sampled at lock and get */
+	uint32_t locked_max;
+	uint32_t locked_min;
+	/* Failed allocations */
+	uint32_t overruns;
+	/* Get on an empty FIFO */
+	uint32_t underruns;
+	/* Time from lock to get */
+	uint32_t residency_cnt;
+	uint32_t residency_max_us;
+	uint64_t residency_sum_us;
+};
+
+#define DATA_FIFO_STATS_INIT(_name) .stats = { .name = #_name },
+#else
+#define DATA_FIFO_STATS_INIT(_name)
+#endif /* (CONFIG_DATA_FIFO_STATS) */
+
+#if (CONFIG_DATA_FIFO_SPSC)
+/* Single-producer/single-consumer ring state.
+ * Each index is only written by one side, and runs from 0 to
+ * (2 * elements_max - 1) so that a full ring can be told apart from an empty one.
+ * The producer owns alloc_idx and lock_idx, the consumer owns get_idx and free_idx.
+ * gen is incremented each time the ring is emptied, so that a side which
+ * was waiting can tell that the ring was reset under it. get_gen is the
+ * generation of the blocks the consumer holds, a free of blocks fetched
+ * before a reset is ignored.
+ */
+struct data_fifo_spsc {
+	atomic_t alloc_idx;
+	atomic_t lock_idx;
+	atomic_t get_idx;
+	atomic_t free_idx;
+	atomic_t gen;
+	atomic_t producer_waiting;
+	atomic_t consumer_waiting;
+	uint32_t get_gen;
+	struct k_sem space_sem;
+	struct k_sem data_sem;
+};
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 struct data_fifo {
 	char *msgq_buffer;
 	char *slab_buffer;
@@ -27,6 +78,16 @@ struct data_fifo {
 	uint32_t elements_max;
 	size_t block_size_max;
 	bool initialized;
+	struct k_spinlock lock;
+#if (CONFIG_DATA_FIFO_STATS)
+	struct data_fifo_stats stats;
+#endif /* (CONFIG_DATA_FIFO_STATS) */
+#if (CONFIG_DATA_FIFO_SPSC)
+	bool spsc;
+	/* Max number of blocks fetched as one span */
+	uint32_t span_max;
+	struct data_fifo_spsc ring;
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
 };
 
 #define DATA_FIFO_DEFINE(name, elements_max_in, block_size_max_in)                                 \
@@ -38,8 +99,51 @@ struct data_fifo {
 				  .slab_buffer = _slab_buffer_##name,                              \
 				  .block_size_max = block_size_max_in,                             \
 				  .elements_max = elements_max_in,                                 \
+				  DATA_FIFO_STATS_INIT(name)                                       \
 				  .initialized = false }
 
+#if (CONFIG_DATA_FIFO_SPSC)
+/**
+ * @brief Define a lock-free single-producer/single-consumer data_fifo
+ *
+ * Same API and semantics as a data_fifo from DATA_FIFO_DEFINE, with these restrictions:
+ * - Only one context may allocate and lock blocks, and only one context may
+ *   get and free blocks.
+ * - Blocks must be locked in the order they were allocated, and freed in the
+ *   order they were fetched.
+ * - The producer cannot evict old blocks on overrun, and must drop new data instead.
+ *
+ * The message queue buffer is reused as the ring of block descriptors.
+ */
+#define DATA_FIFO_SPSC_DEFINE(name, elements_max_in, block_size_max_in)                            \
+	DATA_FIFO_SPSC_SPAN_DEFINE(name, elements_max_in, block_size_max_in, 1)
+
+/**
+ * @brief Define a SPSC data_fifo where up to span_max_in consecutive blocks
+ *	  can be read as one contiguous span, see data_fifo_span_get.
+ *
+ * The slab is followed by (span_max_in - 1) blocks of slack. A span which wraps
+ * the end of the ring gets its first blocks copied into the slack. If the
+ * consumer only reads spans of span_max_in blocks and elements_max_in is a
+ * multiple of span_max_in, spans never wrap and no copy takes place.
+ */
+#define DATA_FIFO_SPSC_SPAN_DEFINE(name, elements_max_in, block_size_max_in, span_max_in)          \
+	BUILD_ASSERT((span_max_in) >= 1 && (span_max_in) <= (elements_max_in));                    \
+	char __aligned(WB_UP(1))                                                                   \
+		_msgq_buffer_##name[(elements_max_in) * sizeof(struct data_fifo_msgq)] = { 0 };    \
+	char __aligned(WB_UP(1))                                                                   \
+		_slab_buffer_##name[((elements_max_in) + (span_max_in)-1) * (block_size_max_in)] = \
+			{ 0 };                                                                     \
+	struct data_fifo name = { .msgq_buffer = _msgq_buffer_##name,                              \
+				  .slab_buffer = _slab_buffer_##name,                              \
+				  .block_size_max = block_size_max_in,                             \
+				  .elements_max = elements_max_in,                                 \
+				  DATA_FIFO_STATS_INIT(name)                                       \
+				  .initialized = false,                                            \
+				  .spsc = true,                                                    \
+				  .span_max = span_max_in }
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 /**
  * @brief Get pointer to first vacant block in slab.
  *
@@ -57,6 +161,8 @@ struct data_fifo {
  *
  * @retval 0 Memory allocated.
  * @retval Return values from k_mem_slab_alloc.
+ *	A SPSC data_fifo returns the same values (-ENOMEM, -EAGAIN), and
+ *	-ECANCELED if it was emptied while waiting.
  */
 int data_fifo_pointer_first_vacant_get(struct data_fifo *data_fifo, void **data,
 				       k_timeout_t timeout);
@@ -80,6 +186,7 @@ int data_fifo_pointer_first_vacant_get(struct data_fifo *data_fifo, void **data,
  * @retval -ESPIPE	Generic return if an error occurs in k_msg_put.
  *			Since data has already been added to the slab, there
  *			must be space in the message queue.
+ * @retval -EPERM	SPSC only: block is not the oldest allocated block.
  */
 int data_fifo_block_lock(struct data_fifo *data_fifo, void **data, size_t size);
 
@@ -100,6 +207,8 @@ int data_fifo_block_lock(struct data_fifo *data_fifo, void **data, size_t size);
  *
  * @retval 0 Memory pointer retrieved.
  * @retval Return values from k_msgq_get.
+ *	A SPSC data_fifo returns the same values (-ENOMSG, -EAGAIN), and
+ *	-ECANCELED if it was emptied while waiting.
  */
 int data_fifo_pointer_last_filled_get(struct data_fifo *data_fifo, void **data, size_t *size,
 				      k_timeout_t timeout);
@@ -112,11 +221,53 @@ int data_fifo_pointer_last_filled_get(struct data_fifo *data_fifo, void **data,
  * @param data_fifo Pointer to the data_fifo structure.
  * @param data Double pointer to the memory area which is to be freed.
  *
- * @retval 0	Memory block is freed.
+ * @retval 0	Memory block is freed. For a SPSC data_fifo, also if the
+ *		block was fetched before the data_fifo was emptied.
  * @retval Return values from k_mem_slab_free.
+ * @retval -EPERM	SPSC only: block is not the oldest fetched block.
  */
 int data_fifo_block_free(struct data_fifo *data_fifo, void **data);
 
+#if (CONFIG_DATA_FIFO_SPSC)
+/**
+ * @brief Get the oldest num_blocks filled blocks as one contiguous span.
+ *
+ * Only for data_fifos defined with DATA_FIFO_SPSC_SPAN_DEFINE. All blocks in
+ * the span must have been locked with the block size max given to the define.
+ *
+ * @param data_fifo Pointer to the data_fifo structure.
+ * @param data Double pointer to the start of the span.
+ * @param size Total size of the span in bytes.
+ * @param num_blocks Number of blocks in the span. Must not exceed span_max_in.
+ * @param timeout Non-negative waiting period to wait for num_blocks to be
+ *	filled. Use K_NO_WAIT to return without waiting,
+ *	or K_FOREVER to wait as long as necessary.
+ *
+ * @retval 0		Span retrieved.
+ * @retval -ENOMSG	Not enough filled blocks and K_NO_WAIT given.
+ * @retval -EAGAIN	Waiting period timed out.
+ * @retval -ECANCELED	The data_fifo was emptied while waiting, e.g. as the
+ *			stream was stopped.
+ * @retval -EINVAL	Not a SPSC data_fifo or num_blocks out of range.
+ * @retval -EMSGSIZE	A block in the span is not completely filled.
+ */
+int data_fifo_span_get(struct data_fifo *data_fifo, void **data, size_t *size,
+		       uint32_t num_blocks, k_timeout_t timeout);
+
+/**
+ * @brief Free a span retrieved with data_fifo_span_get.
+ *
+ * @param data_fifo Pointer to the data_fifo structure.
+ * @param data Double pointer to the start of the span.
+ * @param num_blocks Number of blocks in the span.
+ *
+ * @retval 0		Span freed, or ignored if it was fetched before the
+ *			data_fifo was emptied.
+ * @retval -EPERM	Span is not the oldest fetched blocks.
+ */
+int data_fifo_span_free(struct data_fifo *data_fifo, void **data, uint32_t num_blocks);
+#endif /* (CONFIG_DATA_FIFO_SPSC) */
+
 /**
  * @brief See how many alloced and locked blocks are in the system.
  *
@@ -135,6 +286,9 @@ int data_fifo_num_used_get(struct data_fifo *data_fifo, uint32_t *alloced_num,
 /**
  * @brief Empty all items from data_fifo
  *
+ * @note For a SPSC data_fifo, the producer must be stopped first. A consumer
+ *	 blocked in a get call is woken up and gets -ECANCELED.
+ *
  * @param data_fifo Pointer to the data FIFO to be emptied
  *
  * @return 0 if success, error otherwise
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t mono_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
+{
+	while (__atomic_exchange_n(&l->locked, 1, __ATOMIC_ACQUIRE)) {
+		sched_yield();
+	}
+
+	return 0;
+}
+
+void k_spin_unlock(struct k_spinlock *l, k_spinlock_key_t key)
+{
+	ARG_UNUSED(key);
+
+	__atomic_store_n(&l->locked, 0, __ATOMIC_RELEASE);
+}
+
+int k_sem_init(struct k_sem *sem, unsigned int initial_count, unsigned int limit)
+{
+	pthread_mutex_init(&sem->mtx, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = initial_count;
+	sem->limit = limit;
+	sem->resets = 0;
+
+	return 0;
+}
+
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout)
+{
+	int ret = 0;
+	struct timespec abs;
+
+	pthread_mutex_lock(&sem->mtx);
+
+	unsigned int resets = sem->resets;
+
+	if (timeout.ms > 0) {
+		clock_gettime(CLOCK_REALTIME, &abs);
+		abs.tv_sec += timeout.ms / 1000;
+		abs.tv_nsec += (timeout.ms % 1000) * 1000000;
+		if (abs.tv_nsec >= 1000000000) {
+			abs.tv_sec++;
+			abs.tv_nsec -= 1000000000;
+		}
+	}
+
+	while (sem->count == 0) {
+		if (timeout.ms == 0 || sem->resets != resets) {
+			ret = (timeout.ms == 0) ? -EBUSY : -EAGAIN;
+			break;
+		}
+
+		if (timeout.ms < 0) {
+			pthread_cond_wait(&sem->cond, &sem->mtx);
+		} else if (pthread_cond_timedwait(&sem->cond, &sem->mtx, &abs) == ETIMEDOUT) {
+			ret = -EAGAIN;
+			break;
+		}
+	}
+
+	if (ret == 0) {
+		sem->count--;
+	}
+
+	pthread_mutex_unlock(&sem->mtx);
+
+	return ret;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mtx);
+
+	if (sem->count < sem->limit) {
+		sem->count++;
+	}
+
+	pthread_cond_broadcast(&sem->cond);
+	pthread_mutex_unlock(&sem->mtx);
+}
+
+void k_sem_reset(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mtx);
+	sem->count = 0;
+	sem->resets++;
+	pthread_cond_broadcast(&sem->cond);
+	pthread_mutex_unlock(&sem->mtx);
+}
+
+unsigned int k_sem_count_get(struct k_sem *sem)
+{
+	return __atomic_load_n(&sem->count, __ATOMIC_SEQ_CST);
+}
+
+int k_mutex_lock(struct k_mutex *mutex, k_timeout_t timeout)
+{
+	ARG_UNUSED(timeout);
+
+	return -pthread_mutex_lock(&mutex->mtx);
+}
+
+int k_mutex_unlock(struct k_mutex *mutex)
+{
+	return -pthread_mutex_unlock(&mutex->mtx);
+}
+
+void k_msgq_init(struct k_msgq *msgq, char *buffer, size_t msg_size, uint32_t max_msgs)
+{
+	pthread_mutex_init(&msgq->mtx, NULL);
+	msgq->buffer = buffer;
+	msgq->msg_size = msg_size;
+	msgq->max_msgs = max_msgs;
+	msgq->read_idx = 0;
+	msgq->used = 0;
+}
+
+int k_msgq_put(struct k_msgq *msgq, const void *data, k_timeout_t timeout)
+{
+	int ret = -ENOMSG;
+
+	__ASSERT_NO_MSG(K_TIMEOUT_EQ(timeout, K_NO_WAIT));
+
+	pthread_mutex_lock(&msgq->mtx);
+
+	if (msgq->used < msgq->max_msgs) {
+		uint32_t idx = (msgq->read_idx + msgq->used) % msgq->max_msgs;
+
+		memcpy(&msgq->buffer[idx * msgq->msg_size], data, msgq->msg_size);
+		msgq->used++;
+		ret = 0;
+	}
+
+	pthread_mutex_unlock(&msgq->mtx);
+
+	return ret;
+}
+
+int k_msgq_get(struct k_msgq *msgq, void *data, k_timeout_t timeout)
+{
+	int ret = -ENOMSG;
+
+	__ASSERT_NO_MSG(K_TIMEOUT_EQ(timeout, K_NO_WAIT));
+
+	pthread_mutex_lock(&msgq->mtx);
+
+	if (msgq->used > 0) {
+		memcpy(data, &msgq->buffer[msgq->read_idx * msgq->msg_size], msgq->msg_size);
+		msgq->read_idx = (msgq->read_idx + 1) % msgq->max_msgs;
+		msgq->used--;
+		ret = 0;
+	}
+
+	pthread_mutex_unlock(&msgq->mtx);
+
+	return ret;
+}
+
+uint32_t k_msgq_num_used_get(struct k_msgq *msgq)
+{
+	return __atomic_load_n(&msgq->used, __ATOMIC_SEQ_CST);
+}
+
+int k_mem_slab_init(struct k_mem_slab *slab, void *buffer, size_t block_size,
+		    uint32_t num_blocks)
+{
+	ARG_UNUSED(slab);
+	ARG_UNUSED(buffer);
+	ARG_UNUSED(block_size);
+	ARG_UNUSED(num_blocks);
+
+	return -ENOTSUP;
+}
+
+int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, k_timeout_t timeout)
+{
+	ARG_UNUSED(slab);
+	ARG_UNUSED(mem);
+	ARG_UNUSED(timeout);
+
+	return -ENOTSUP;
+}
+
+void k_mem_slab_free(struct k_mem_slab *slab, void **mem)
+{
+	ARG_UNUSED(slab);
+	ARG_UNUSED(mem);
+}
+
+uint32_t k_mem_slab_num_used_get(struct k_mem_slab *slab)
+{
+	ARG_UNUSED(slab);
+
+	return 0;
+}
+
+uint32_t k_cycle_get_32(void)
+{
+	return (uint32_t)mono_us();
+}
+
+int64_t k_uptime_get(void)
+{
+	return mono_us() / 1000;
+}
+
+int64_t k_uptime_ticks(void)
+{
+	return mono_us();
+}
+
+void k_busy_wait(uint32_t usec)
+{
+	uint64_t end = mono_us() + usec;
+
+	while (mono_us() < end) {
+	}
+}
+
+int32_t k_msleep(int32_t ms)
+{
+	struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+
+	nanosleep(&ts, NULL);
+
+	return 0;
+}
+
+void k_yield(void)
+{
+	sched_yield();
+}
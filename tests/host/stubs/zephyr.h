@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_ZEPHYR_H_
+#define _HOST_STUB_ZEPHYR_H_
+
+#include <zephyr/kernel.h>
+
+#endif /* _HOST_STUB_ZEPHYR_H_ */
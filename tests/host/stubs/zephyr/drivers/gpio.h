@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_GPIO_H_
+#define _HOST_STUB_GPIO_H_
+
+#include <stdint.h>
+
+typedef uint8_t gpio_pin_t;
+
+/* Button pins of the devicetree aliases used by button_assignments.h */
+#define DT_ALIAS(alias) DT_STUB_ALIAS_##alias
+#define DT_GPIO_PIN(node, prop) (node)
+
+#define DT_STUB_ALIAS_sw0 2
+#define DT_STUB_ALIAS_sw1 3
+#define DT_STUB_ALIAS_sw2 4
+#define DT_STUB_ALIAS_sw3 5
+#define DT_STUB_ALIAS_sw4 6
+
+#endif /* _HOST_STUB_GPIO_H_ */
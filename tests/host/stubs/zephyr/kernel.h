@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_KERNEL_H_
+#define _HOST_STUB_KERNEL_H_
+
+/*
+ * Minimal Zephyr kernel API for running application modules on the host.
+ * Semaphores and spinlocks are backed by pthreads so that code written for
+ * thread/ISR concurrency can be exercised by real threads. Only what the
+ * modules under test use is provided.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+typedef struct {
+	int64_t ms;
+} k_timeout_t;
+
+#define K_FOREVER ((k_timeout_t){ .ms = -1 })
+#define K_NO_WAIT ((k_timeout_t){ .ms = 0 })
+#define K_MSEC(t) ((k_timeout_t){ .ms = (t) })
+#define K_SECONDS(t) K_MSEC((t)*1000)
+#define K_MINUTES(t) K_SECONDS((t)*60)
+#define K_TIMEOUT_EQ(a, b) ((a).ms == (b).ms)
+
+#define __ASSERT_NO_MSG(cond)                                                                      \
+	do {                                                                                       \
+		if (!(cond)) {                                                                     \
+			abort();                                                                   \
+		}                                                                                  \
+	} while (0)
+#define __ASSERT(cond, ...) __ASSERT_NO_MSG(cond)
+
+#define k_oops() abort()
+
+/* Init functions are not run, tests call them or their public equivalent */
+struct device;
+
+#define SYS_INIT(...) extern int sys_init_unused
+
+/* Spinlocks only give mutual exclusion, there are no interrupts to mask */
+struct k_spinlock {
+	int locked;
+};
+
+typedef int k_spinlock_key_t;
+
+k_spinlock_key_t k_spin_lock(struct k_spinlock *l);
+void k_spin_unlock(struct k_spinlock *l, k_spinlock_key_t key);
+
+struct k_sem {
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	unsigned int count;
+	unsigned int limit;
+	/* Incremented by k_sem_reset to release waiters with -EAGAIN */
+	unsigned int resets;
+};
+
+#define K_SEM_MAX_LIMIT UINT32_MAX
+#define K_SEM_DEFINE(name, initial_count, count_limit)                                            \
+	struct k_sem name = { .mtx = PTHREAD_MUTEX_INITIALIZER,                                    \
+			      .cond = PTHREAD_COND_INITIALIZER,                                    \
+			      .count = (initial_count),                                            \
+			      .limit = (count_limit) }
+
+int k_sem_init(struct k_sem *sem, unsigned int initial_count, unsigned int limit);
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout);
+void k_sem_give(struct k_sem *sem);
+void k_sem_reset(struct k_sem *sem);
+unsigned int k_sem_count_get(struct k_sem *sem);
+
+struct k_mutex {
+	pthread_mutex_t mtx;
+};
+
+#define K_MUTEX_DEFINE(name) struct k_mutex name = { .mtx = PTHREAD_MUTEX_INITIALIZER }
+
+int k_mutex_lock(struct k_mutex *mutex, k_timeout_t timeout);
+int k_mutex_unlock(struct k_mutex *mutex);
+
+/* Message queues only support K_NO_WAIT */
+struct k_msgq {
+	pthread_mutex_t mtx;
+	char *buffer;
+	size_t msg_size;
+	uint32_t max_msgs;
+	uint32_t read_idx;
+	uint32_t used;
+};
+
+#define K_MSGQ_DEFINE(name, q_msg_size, q_max_msgs, q_align)                                       \
+	static char __aligned(q_align) _msgq_buf_##name[(q_msg_size) * (q_max_msgs)];             \
+	struct k_msgq name = { .mtx = PTHREAD_MUTEX_INITIALIZER,                                   \
+			       .buffer = _msgq_buf_##name,                                         \
+			       .msg_size = (q_msg_size),                                           \
+			       .max_msgs = (q_max_msgs) }
+
+/* Memory slabs are not backed, calls fail with -ENOTSUP */
+struct k_mem_slab {
+	int unused;
+};
+
+void k_msgq_init(struct k_msgq *msgq, char *buffer, size_t msg_size, uint32_t max_msgs);
+int k_msgq_put(struct k_msgq *msgq, const void *data, k_timeout_t timeout);
+int k_msgq_get(struct k_msgq *msgq, void *data, k_timeout_t timeout);
+uint32_t k_msgq_num_used_get(struct k_msgq *msgq);
+int k_mem_slab_init(struct k_mem_slab *slab, void *buffer, size_t block_size,
+		    uint32_t num_blocks);
+int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, k_timeout_t timeout);
+void k_mem_slab_free(struct k_mem_slab *slab, void **mem);
+uint32_t k_mem_slab_num_used_get(struct k_mem_slab *slab);
+
+#define USEC_PER_MSEC 1000U
+#define USEC_PER_SEC 1000000U
+
+/* Time is taken from CLOCK_MONOTONIC, with 1 us cycles */
+uint32_t k_cycle_get_32(void);
+int64_t k_uptime_get(void);
+int64_t k_uptime_ticks(void);
+void k_busy_wait(uint32_t usec);
+int32_t k_msleep(int32_t ms);
+void k_yield(void);
+
+#define k_cyc_to_us_floor32(c) ((uint32_t)(c))
+#define k_ticks_to_us_floor64(t) ((uint64_t)(t))
+
+#endif /* _HOST_STUB_KERNEL_H_ */
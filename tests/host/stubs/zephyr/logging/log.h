@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_LOG_H_
+#define _HOST_STUB_LOG_H_
+
+#include <stdio.h>
+
+/* Errors and warnings go to stderr, so a failing test shows why */
+#define LOG_MODULE_REGISTER(...) extern int log_module_unused
+#define LOG_MODULE_DECLARE(...) extern int log_module_unused
+
+#define LOG_PRINT(level, fmt, ...) fprintf(stderr, level ": " fmt "\n", ##__VA_ARGS__)
+#define LOG_SILENT(...)                                                                            \
+	do {                                                                                       \
+		if (0) {                                                                           \
+			printf(__VA_ARGS__);                                                       \
+		}                                                                                  \
+	} while (0)
+
+#define LOG_ERR(...) LOG_PRINT("ERR", __VA_ARGS__)
+#define LOG_WRN(...) LOG_PRINT("WRN", __VA_ARGS__)
+#define LOG_INF(...) LOG_SILENT(__VA_ARGS__)
+#define LOG_DBG(...) LOG_SILENT(__VA_ARGS__)
+#define LOG_HEXDUMP_DBG(...)
+
+#endif /* _HOST_STUB_LOG_H_ */
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_NET_BUF_H_
+#define _HOST_STUB_NET_BUF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct net_buf {
+	uint8_t *data;
+	uint16_t len;
+};
+
+#endif /* _HOST_STUB_NET_BUF_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_SHELL_H_
+#define _HOST_STUB_SHELL_H_
+
+#include <stdio.h>
+
+/* Shell commands are compiled but not registered. The shell argument is
+ * unused, output goes to stdout
+ */
+struct shell;
+
+#define shell_print(sh, fmt, ...) ((void)(sh), printf(fmt "\n", ##__VA_ARGS__))
+#define shell_info(sh, fmt, ...) shell_print(sh, fmt, ##__VA_ARGS__)
+#define shell_warn(sh, fmt, ...) shell_print(sh, fmt, ##__VA_ARGS__)
+#define shell_error(sh, fmt, ...) shell_print(sh, fmt, ##__VA_ARGS__)
+
+#define SHELL_COND_CMD(...)
+#define SHELL_CMD(...)
+#define SHELL_SUBCMD_SET_END
+#define SHELL_STATIC_SUBCMD_SET_CREATE(name, ...) extern int shell_cmd_unused
+#define SHELL_CMD_REGISTER(...) extern int shell_cmd_unused
+
+#endif /* _HOST_STUB_SHELL_H_ */
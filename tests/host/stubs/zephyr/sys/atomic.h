@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_ATOMIC_H_
+#define _HOST_STUB_ATOMIC_H_
+
+#include <stdbool.h>
+
+/* Zephyr atomic API on top of the GCC builtins, sequentially consistent */
+
+typedef long atomic_t;
+typedef long atomic_val_t;
+
+#define ATOMIC_INIT(i) (i)
+#define ATOMIC_BITS (sizeof(atomic_val_t) * 8)
+
+static inline atomic_val_t atomic_get(const atomic_t *target)
+{
+	return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_clear(atomic_t *target)
+{
+	return atomic_set(target, 0);
+}
+
+static inline atomic_val_t atomic_add(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_sub(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_fetch_sub(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_inc(atomic_t *target)
+{
+	return atomic_add(target, 1);
+}
+
+static inline atomic_val_t atomic_dec(atomic_t *target)
+{
+	return atomic_sub(target, 1);
+}
+
+static inline atomic_val_t atomic_or(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_fetch_or(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_and(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_fetch_and(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_cas(atomic_t *target, atomic_val_t old_value, atomic_val_t new_value)
+{
+	return __atomic_compare_exchange_n(target, &old_value, new_value, false,
+					   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_test_bit(const atomic_t *target, int bit)
+{
+	return (atomic_get(target) >> bit) & 1;
+}
+
+static inline void atomic_set_bit(atomic_t *target, int bit)
+{
+	(void)atomic_or(target, 1L << bit);
+}
+
+static inline void atomic_clear_bit(atomic_t *target, int bit)
+{
+	(void)atomic_and(target, ~(1L << bit));
+}
+
+static inline bool atomic_test_and_set_bit(atomic_t *target, int bit)
+{
+	return (atomic_or(target, 1L << bit) >> bit) & 1;
+}
+
+static inline bool atomic_test_and_clear_bit(atomic_t *target, int bit)
+{
+	return (atomic_and(target, ~(1L << bit)) >> bit) & 1;
+}
+
+#endif /* _HOST_STUB_ATOMIC_H_ */
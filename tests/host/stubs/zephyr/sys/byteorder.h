@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_BYTEORDER_H_
+#define _HOST_STUB_BYTEORDER_H_
+
+#include <stdint.h>
+
+static inline uint16_t sys_get_le16(const uint8_t src[2])
+{
+	return ((uint16_t)src[1] << 8) | src[0];
+}
+
+static inline void sys_put_le16(uint16_t val, uint8_t dst[2])
+{
+	dst[0] = val;
+	dst[1] = val >> 8;
+}
+
+static inline uint32_t sys_get_le24(const uint8_t src[3])
+{
+	return ((uint32_t)src[2] << 16) | sys_get_le16(&src[0]);
+}
+
+static inline uint32_t sys_get_le32(const uint8_t src[4])
+{
+	return ((uint32_t)sys_get_le16(&src[2]) << 16) | sys_get_le16(&src[0]);
+}
+
+static inline void sys_put_le32(uint32_t val, uint8_t dst[4])
+{
+	sys_put_le16(val, &dst[0]);
+	sys_put_le16(val >> 16, &dst[2]);
+}
+
+#endif /* _HOST_STUB_BYTEORDER_H_ */
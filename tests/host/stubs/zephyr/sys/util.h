@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HOST_STUB_UTIL_H_
+#define _HOST_STUB_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif /* MIN */
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif /* MAX */
+
+#define CLAMP(val, low, high) (((val) <= (low)) ? (low) : MIN(val, high))
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define BIT(n) (1UL << (n))
+#define ROUND_UP(x, align) ((((x) + ((align)-1)) / (align)) * (align))
+#define WB_UP(x) ROUND_UP(x, sizeof(void *))
+#define CONTAINER_OF(ptr, type, field) ((type *)(((char *)(ptr)) - offsetof(type, field)))
+
+#define ARG_UNUSED(x) (void)(x)
+#define BUILD_ASSERT(cond, ...) _Static_assert(cond, "" __VA_ARGS__)
+#define __aligned(x) __attribute__((__aligned__(x)))
+#define __packed __attribute__((__packed__))
+#define compiler_barrier() __asm__ __volatile__("" ::: "memory")
+
+static inline size_t bin2hex(const uint8_t *buf, size_t buflen, char *hex, size_t hexlen)
+{
+	static const char digits[] = "0123456789abcdef";
+
+	if (hexlen < (buflen * 2 + 1)) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < buflen; i++) {
+		hex[2 * i] = digits[buf[i] >> 4];
+		hex[2 * i + 1] = digits[buf[i] & 0xF];
+	}
+
+	hex[2 * buflen] = '\0';
+
+	return 2 * buflen;
+}
+
+#endif /* _HOST_STUB_UTIL_H_ */
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+
+#include "audio_i2s_tdm.h"
+#include "test_common.h"
+
+#define FRAMES 48
+
+static const struct audio_i2s_tdm_fmt fmts[] = {
+	{ .slot_num = 8, .slot_width_bits = 8 },
+	{ .slot_num = 4, .slot_width_bits = 16 },
+	{ .slot_num = 3, .slot_width_bits = 16 },
+	{ .slot_num = 2, .slot_width_bits = 32 },
+};
+
+static int16_t pcm_in[FRAMES * 2];
+static int16_t pcm_out[FRAMES * 2];
+static int16_t slots[AUDIO_I2S_TDM_SLOT_NUM_MAX * FRAMES];
+static uint32_t words[FRAMES * AUDIO_I2S_TDM_WORDS_PER_FRAME];
+
+static void pcm_fill(void)
+{
+	for (int i = 0; i < FRAMES; i++) {
+		/* Full scale and sign changes on both channels */
+		pcm_in[2 * i] = (int16_t)(i * 1361 - 32768);
+		pcm_in[2 * i + 1] = (int16_t)(-i * 977 + 1);
+	}
+}
+
+/* A 16 bit sample as it comes back through a slot of the given width */
+static int16_t slot_quantize(int16_t sample, uint8_t width_bits)
+{
+	if (width_bits != 8) {
+		return sample;
+	}
+
+	return (int16_t)(MIN(((int32_t)sample + 0x80) >> 8, INT8_MAX) * 256);
+}
+
+static void test_fmt_check(void)
+{
+	for (int f = 0; f < ARRAY_SIZE(fmts); f++) {
+		TEST_ASSERT_EQ(audio_i2s_tdm_fmt_check(&fmts[f]), 0);
+	}
+
+	TEST_ASSERT_EQ(audio_i2s_tdm_fmt_check(
+			       &(struct audio_i2s_tdm_fmt){ .slot_num = 5, .slot_width_bits = 16 }),
+		       -EINVAL);
+	TEST_ASSERT_EQ(audio_i2s_tdm_fmt_check(
+			       &(struct audio_i2s_tdm_fmt){ .slot_num = 3, .slot_width_bits = 32 }),
+		       -EINVAL);
+	TEST_ASSERT_EQ(audio_i2s_tdm_fmt_check(
+			       &(struct audio_i2s_tdm_fmt){ .slot_num = 2, .slot_width_bits = 24 }),
+		       -EINVAL);
+	TEST_ASSERT_EQ(audio_i2s_tdm_fmt_check(
+			       &(struct audio_i2s_tdm_fmt){ .slot_num = 0, .slot_width_bits = 8 }),
+		       -EINVAL);
+}
+
+/* Slots follow each other from the upper bits of the first word */
+static void test_layout(void)
+{
+	const int16_t pcm[] = { 0x1234, -2 };
+
+	audio_i2s_tdm_pack(&fmts[1], pcm, words, 1, 0, 3);
+	TEST_ASSERT_EQ(words[0], 0x12340000);
+	TEST_ASSERT_EQ(words[1], 0x0000FFFE);
+
+	audio_i2s_tdm_pack(&fmts[1], pcm, words, 1, 1, 2);
+	TEST_ASSERT_EQ(words[0], 0x00001234);
+	TEST_ASSERT_EQ(words[1], 0xFFFE0000);
+
+	/* 8 bit slots are rounded, -2 rounds to 0 */
+	audio_i2s_tdm_pack(&fmts[0], pcm, words, 1, 2, 5);
+	TEST_ASSERT_EQ(words[0], 0x00001200);
+	TEST_ASSERT_EQ(words[1], 0x00000000);
+
+	audio_i2s_tdm_pack(&fmts[0], (const int16_t[]){ 0x7FFF, -0x8000 }, words, 1, 7, 3);
+	TEST_ASSERT_EQ(words[0], 0x00000080);
+	TEST_ASSERT_EQ(words[1], 0x0000007F);
+
+	/* 32 bit slots carry the sample in the upper half */
+	audio_i2s_tdm_pack(&fmts[3], pcm, words, 1, 1, 0);
+	TEST_ASSERT_EQ(words[0], 0xFFFE0000);
+	TEST_ASSERT_EQ(words[1], 0x12340000);
+
+	/* With three slots, the last quarter of the frame is padding */
+	audio_i2s_tdm_pack(&fmts[2], pcm, words, 1, 2, 1);
+	TEST_ASSERT_EQ(words[0], 0x0000FFFE);
+	TEST_ASSERT_EQ(words[1], 0x12340000);
+}
+
+/* Wider slots are rounded to 16 bits, saturating at full scale */
+static void test_unpack_convert(void)
+{
+	words[0] = 0x7FFFFFFF;
+	words[1] = 0x12348000;
+	audio_i2s_tdm_unpack(&fmts[3], words, slots, 1);
+	TEST_ASSERT_EQ(slots[0], 0x7FFF);
+	TEST_ASSERT_EQ(slots[1], 0x1235);
+
+	words[0] = 0x80007FFF;
+	words[1] = 0xFFFF8000;
+	audio_i2s_tdm_unpack(&fmts[3], words, slots, 1);
+	TEST_ASSERT_EQ(slots[0], -0x8000);
+	TEST_ASSERT_EQ(slots[1], 0);
+
+	words[0] = 0x7F80FF01;
+	words[1] = 0;
+	audio_i2s_tdm_unpack(&fmts[0], words, slots, 1);
+	TEST_ASSERT_EQ(slots[0], 0x7F00);
+	TEST_ASSERT_EQ(slots[1], -0x8000);
+	TEST_ASSERT_EQ(slots[2], -0x100);
+	TEST_ASSERT_EQ(slots[3], 0x100);
+}
+
+/* Every routing puts each channel in its slot, with all other slots silent */
+static void test_pack_routing(void)
+{
+	pcm_fill();
+
+	for (int f = 0; f < ARRAY_SIZE(fmts); f++) {
+		const struct audio_i2s_tdm_fmt *fmt = &fmts[f];
+
+		for (int l = 0; l < fmt->slot_num; l++) {
+			for (int r = 0; r < fmt->slot_num; r++) {
+				if (l == r) {
+					continue;
+				}
+
+				memset(words, 0xA5, sizeof(words));
+				audio_i2s_tdm_pack(fmt, pcm_in, words, FRAMES, l, r);
+				audio_i2s_tdm_unpack(fmt, words, slots, FRAMES);
+
+				for (int s = 0; s < fmt->slot_num; s++) {
+					for (int i = 0; i < FRAMES; i++) {
+						int16_t expected = 0;
+
+						if (s == l) {
+							expected = pcm_in[2 * i];
+						} else if (s == r) {
+							expected = pcm_in[2 * i + 1];
+						}
+
+						TEST_ASSERT_EQ(slots[s * FRAMES + i],
+							       slot_quantize(expected,
+									     fmt->slot_width_bits));
+					}
+				}
+
+				/* The padding after the last slot is sent as zero */
+				for (int i = 0; i < FRAMES && fmt->slot_num == 3; i++) {
+					TEST_ASSERT_EQ(words[2 * i + 1] & 0xFFFF, 0);
+				}
+			}
+		}
+	}
+}
+
+/* Taking the slots a frame was packed into as stereo gives the samples back */
+static void test_loopback(void)
+{
+	pcm_fill();
+
+	for (int f = 1; f < ARRAY_SIZE(fmts); f++) {
+		const struct audio_i2s_tdm_fmt *fmt = &fmts[f];
+
+		for (int l = 0; l < fmt->slot_num; l++) {
+			for (int r = 0; r < fmt->slot_num; r++) {
+				if (l == r) {
+					continue;
+				}
+
+				audio_i2s_tdm_pack(fmt, pcm_in, words, FRAMES, l, r);
+				audio_i2s_tdm_unpack(fmt, words, slots, FRAMES);
+				memset(pcm_out, 0, sizeof(pcm_out));
+				audio_i2s_tdm_stereo_get(slots, pcm_out, FRAMES, l, r);
+
+				TEST_ASSERT(memcmp(pcm_in, pcm_out, sizeof(pcm_in)) == 0);
+			}
+		}
+	}
+}
+
+/* All slots are received, and stereo can take any slot as either channel */
+static void test_unpack_all_slots(void)
+{
+	for (int i = 0; i < FRAMES; i++) {
+		words[2 * i] = ((uint32_t)(0x1000 + i) << 16) | (0x2000 + i);
+		words[2 * i + 1] = ((uint32_t)(0x8000 + i) << 16) | (0xF000 + i);
+	}
+
+	audio_i2s_tdm_unpack(&fmts[1], words, slots, FRAMES);
+
+	for (int i = 0; i < FRAMES; i++) {
+		TEST_ASSERT_EQ(slots[i], 0x1000 + i);
+		TEST_ASSERT_EQ(slots[FRAMES + i], 0x2000 + i);
+		TEST_ASSERT_EQ(slots[2 * FRAMES + i], (int16_t)(0x8000 + i));
+		TEST_ASSERT_EQ(slots[3 * FRAMES + i], (int16_t)(0xF000 + i));
+	}
+
+	audio_i2s_tdm_stereo_get(slots, pcm_out, FRAMES, 3, 1);
+
+	for (int i = 0; i < FRAMES; i++) {
+		TEST_ASSERT_EQ(pcm_out[2 * i], (int16_t)(0xF000 + i));
+		TEST_ASSERT_EQ(pcm_out[2 * i + 1], 0x2000 + i);
+	}
+
+	audio_i2s_tdm_stereo_get(slots, pcm_out, FRAMES, 2, 2);
+
+	for (int i = 0; i < FRAMES; i++) {
+		TEST_ASSERT_EQ(pcm_out[2 * i], (int16_t)(0x8000 + i));
+		TEST_ASSERT_EQ(pcm_out[2 * i + 1], (int16_t)(0x8000 + i));
+	}
+}
+
+int main(void)
+{
+	TEST_RUN(test_fmt_check);
+	TEST_RUN(test_layout);
+	TEST_RUN(test_unpack_convert);
+	TEST_RUN(test_pack_routing);
+	TEST_RUN(test_loopback);
+	TEST_RUN(test_unpack_all_slots);
+
+	return 0;
+}
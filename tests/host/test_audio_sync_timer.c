@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+
+#include "audio_sync_timer.h"
+#include "test_common.h"
+
+#define WRAP (1ULL << 32)
+#define MINUTE_US (60ULL * 1000000)
+/* Kernel tick at 32768 Hz, in us */
+#define TICK_US 31
+
+static uint32_t rand_state = 1;
+
+static uint32_t rand32(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return (rand_state >> 16) | ((rand_state * 1103515245 + 12345) & 0xFFFF0000);
+}
+
+static void test_diff_us(void)
+{
+	TEST_ASSERT_EQ(audio_sync_timer_diff_us(5, UINT32_MAX - 4), 10);
+	TEST_ASSERT_EQ(audio_sync_timer_diff_us(UINT32_MAX - 4, 5), -10);
+	TEST_ASSERT_EQ(audio_sync_timer_diff_us(INT32_MAX, 0), INT32_MAX);
+	TEST_ASSERT_EQ(audio_sync_timer_diff_us(0, INT32_MAX), -INT32_MAX);
+	TEST_ASSERT_EQ(audio_sync_timer_diff_us(1234, 1234), 0);
+
+	TEST_ASSERT(audio_sync_timer_is_after(5, UINT32_MAX - 4));
+	TEST_ASSERT(!audio_sync_timer_is_after(UINT32_MAX - 4, 5));
+	TEST_ASSERT(!audio_sync_timer_is_after(1234, 1234));
+	TEST_ASSERT(audio_sync_timer_is_after(0x80000000, 1));
+}
+
+/* Reference phase from 64 bit arithmetic */
+static int32_t phase_ref(int64_t diff, int64_t period)
+{
+	int64_t phase = ((diff % period) + period) % period;
+
+	return (phase >= period / 2) ? phase - period : phase;
+}
+
+static void test_phase_us(void)
+{
+	const uint32_t periods[] = { 1000, 7500, 10000, 10 };
+
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(1499, 0, 1000), 499);
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(1500, 0, 1000), -500);
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(0, 1500, 1000), -500);
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(0, 501, 1000), 499);
+
+	/* 2^32 is not a multiple of 1000, an unsigned modulo is off by 296 us here */
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(0, 296, 1000), -296);
+	TEST_ASSERT_EQ(audio_sync_timer_phase_us(200, UINT32_MAX - 99, 1000), 300);
+
+	for (int i = 0; i < 100000; i++) {
+		uint32_t period = periods[i % ARRAY_SIZE(periods)];
+		uint32_t b = rand32();
+		int32_t diff = (int32_t)(rand32() >> 1) - INT32_MAX / 2;
+
+		TEST_ASSERT_EQ(audio_sync_timer_phase_us(b + diff, b, period),
+			       phase_ref(diff, period));
+	}
+}
+
+/* Sync timer as cleared by the NET core, with the true time to compare to */
+struct sim {
+	struct audio_sync_timer_ext ext;
+	uint64_t t_us;
+	uint64_t last_clear_us;
+	uint32_t clears;
+	/* Error of the reference clock, within one tick */
+	bool coarse_ref;
+};
+
+static void sim_clear(struct sim *s)
+{
+	s->last_clear_us = s->t_us;
+	s->clears++;
+}
+
+static uint64_t sim_read(struct sim *s)
+{
+	uint32_t now = (uint32_t)(s->t_us - s->last_clear_us);
+	uint64_t ref_us = s->coarse_ref ? (s->t_us / TICK_US) * TICK_US : s->t_us;
+	uint64_t now64 = audio_sync_timer_ext_update(&s->ext, now, s->clears, ref_us);
+
+	TEST_ASSERT_EQ((uint32_t)(now64 - s->ext.base), now);
+
+	return now64;
+}
+
+static void test_ext_wrap(void)
+{
+	struct sim s = { 0 };
+
+	TEST_ASSERT_EQ(sim_read(&s), 0);
+
+	s.t_us = WRAP - 10;
+	TEST_ASSERT_EQ(sim_read(&s), WRAP - 10);
+
+	s.t_us = WRAP + 5;
+	TEST_ASSERT_EQ(sim_read(&s), WRAP + 5);
+
+	/* Three hours read every 10 minutes, wrapping about every 71 minutes */
+	for (int i = 0; i < 18; i++) {
+		s.t_us += 10 * MINUTE_US - (rand32() % 1000);
+		TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+	}
+}
+
+/* The timebase runs on through a clear with the time elapsed since the last read */
+static void test_ext_clear(void)
+{
+	struct sim s = { 0 };
+
+	s.t_us = 5000000;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+
+	s.t_us += 1000;
+	sim_clear(&s);
+	s.t_us += 200;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+
+	/* Cleared and read again at a higher value than the last read. This
+	 * clear cannot be told from the timer value alone
+	 */
+	s.t_us += 3000000;
+	sim_clear(&s);
+	s.t_us += 100;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+
+	/* Two clears between reads */
+	s.t_us += 7000;
+	sim_clear(&s);
+	s.t_us += 7000;
+	sim_clear(&s);
+	s.t_us += 7000;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+
+	/* Cleared shortly before the timer would have wrapped */
+	s.t_us += 10 * MINUTE_US;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+	s.t_us = s.last_clear_us + WRAP - 1000;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+	s.t_us += 500;
+	sim_clear(&s);
+	s.t_us += 1000;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+	s.t_us += 10 * MINUTE_US;
+	TEST_ASSERT_EQ(sim_read(&s), s.t_us);
+}
+
+/* With a coarse reference clock the timebase stays monotonic, and the error
+ * only grows by a tick per clear
+ */
+static void test_ext_clear_coarse_ref(void)
+{
+	struct sim s = { .coarse_ref = true };
+	uint64_t prev = 0;
+	int clears = 0;
+
+	for (int i = 0; i < 100000; i++) {
+		uint64_t now64;
+
+		s.t_us += rand32() % 3000;
+
+		if (rand32() % 100 == 0) {
+			sim_clear(&s);
+			clears++;
+			/* Read right after the clear, before a tick has passed */
+			s.t_us += rand32() % 10;
+		}
+
+		now64 = sim_read(&s);
+
+		TEST_ASSERT(now64 >= prev);
+		TEST_ASSERT(llabs((int64_t)(now64 - s.t_us)) <= (int64_t)clears * TICK_US);
+		prev = now64;
+	}
+
+	printf("\t%d clears, final error %lld us\n", clears,
+	       (long long)(prev - s.t_us));
+}
+
+int main(void)
+{
+	TEST_RUN(test_diff_us);
+	TEST_RUN(test_phase_us);
+	TEST_RUN(test_ext_wrap);
+	TEST_RUN(test_ext_clear);
+	TEST_RUN(test_ext_clear_coarse_ref);
+
+	return 0;
+}
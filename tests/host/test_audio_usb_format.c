@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <math.h>
+#include <string.h>
+
+#include "audio_usb_format.h"
+#include "test_common.h"
+
+#define PI 3.14159265358979323846
+#define CH_NUM 2
+#define OUT_FRAMES 48
+#define PACKETS 20
+/* The half-band filter is centered 34 input samples back */
+#define DEC_DELAY_FRAMES 17
+
+static uint8_t in_buf[96 * 3 * CH_NUM];
+static int16_t out_buf[OUT_FRAMES * CH_NUM];
+
+static size_t packet_size(uint32_t rate, uint8_t bits)
+{
+	return (rate / 1000) * (bits / 8) * CH_NUM;
+}
+
+static void put_s24(uint8_t *p, int32_t val)
+{
+	p[0] = val & 0xFF;
+	p[1] = (val >> 8) & 0xFF;
+	p[2] = (val >> 16) & 0xFF;
+}
+
+/* Fill a packet with a sine on the left channel and its negation on the right */
+static void sine_packet(uint32_t rate, uint8_t bits, double freq_hz, double amplitude,
+			uint32_t first_frame)
+{
+	uint32_t frames = rate / 1000;
+
+	for (uint32_t i = 0; i < frames; i++) {
+		double x = amplitude * sin(2 * PI * freq_hz * (first_frame + i) / rate);
+		int32_t l = lround(x);
+		int32_t r = -l;
+
+		if (bits == 16) {
+			sys_put_le16(l, &in_buf[i * 4]);
+			sys_put_le16(r, &in_buf[i * 4 + 2]);
+		} else {
+			/* The low byte is rounded off, down on the left and up on the right */
+			put_s24(&in_buf[i * 6], l * 256 + 0x7F);
+			put_s24(&in_buf[i * 6 + 3], r * 256 - 0x80);
+		}
+	}
+}
+
+static void convert(uint32_t rate, uint8_t bits)
+{
+	size_t out_size;
+
+	TEST_ASSERT_EQ(audio_usb_format_convert(in_buf, packet_size(rate, bits), out_buf,
+						sizeof(out_buf), &out_size),
+		       0);
+	TEST_ASSERT_EQ(out_size, sizeof(out_buf));
+}
+
+static void test_detect(void)
+{
+	struct audio_usb_format fmt;
+
+	audio_usb_format_get(&fmt);
+	TEST_ASSERT_EQ(fmt.sample_rate_hz, 0);
+	TEST_ASSERT(!audio_usb_format_is_native());
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(100), -EINVAL);
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(576), 0);
+	audio_usb_format_get(&fmt);
+	TEST_ASSERT_EQ(fmt.sample_rate_hz, 96000);
+	TEST_ASSERT_EQ(fmt.bit_depth, 24);
+	TEST_ASSERT(!audio_usb_format_is_native());
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(288), 0);
+	audio_usb_format_get(&fmt);
+	TEST_ASSERT_EQ(fmt.sample_rate_hz, 48000);
+	TEST_ASSERT_EQ(fmt.bit_depth, 24);
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(384), 0);
+	audio_usb_format_get(&fmt);
+	TEST_ASSERT_EQ(fmt.sample_rate_hz, 96000);
+	TEST_ASSERT_EQ(fmt.bit_depth, 16);
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(192), 0);
+	TEST_ASSERT(audio_usb_format_is_native());
+
+	/* An unknown packet size keeps the current format */
+	TEST_ASSERT_EQ(audio_usb_format_detect(191), -EINVAL);
+	TEST_ASSERT(audio_usb_format_is_native());
+}
+
+static void test_convert_errors(void)
+{
+	size_t out_size;
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(576), 0);
+	TEST_ASSERT_EQ(audio_usb_format_convert(in_buf, 288, out_buf, sizeof(out_buf), &out_size),
+		       -EINVAL);
+	TEST_ASSERT_EQ(audio_usb_format_convert(in_buf, 576, out_buf, sizeof(out_buf) - 1,
+						&out_size),
+		       -ENOMEM);
+}
+
+static void test_s24_to_s16(void)
+{
+	const int32_t in[] = { 0x123456, -0x123456, 0x7FFFFF, -0x800000, 0x0000FF,
+			       0x000080, -0x80, -0x81, -1 };
+	/* Rounded to nearest, full scale saturates */
+	const int16_t expected[] = { 0x1234, -0x1234, 0x7FFF, -0x8000, 1, 1, 0, -1, 0 };
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(288), 0);
+
+	memset(in_buf, 0, sizeof(in_buf));
+	for (int i = 0; i < ARRAY_SIZE(in); i++) {
+		put_s24(&in_buf[i * 3], in[i]);
+	}
+
+	convert(48000, 24);
+
+	for (int i = 0; i < ARRAY_SIZE(expected); i++) {
+		TEST_ASSERT_EQ(out_buf[i], expected[i]);
+	}
+}
+
+/* A DC level passes the filter unchanged, full scale without overflow */
+static void test_decimate_dc(void)
+{
+	const int32_t levels[] = { INT16_MAX, INT16_MIN, 1000 };
+
+	for (int bits = 16; bits <= 24; bits += 8) {
+		for (int l = 0; l < ARRAY_SIZE(levels); l++) {
+			TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(48000, 16)), 0);
+			TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(96000, bits)), 0);
+
+			for (int p = 0; p < 3; p++) {
+				for (int i = 0; i < 96 * CH_NUM; i++) {
+					if (bits == 16) {
+						sys_put_le16(levels[l], &in_buf[i * 2]);
+					} else {
+						put_s24(&in_buf[i * 3], levels[l] * 256);
+					}
+				}
+
+				convert(96000, bits);
+
+				/* The filter starts from silence after a format change */
+				if (p == 0) {
+					continue;
+				}
+
+				for (int i = 0; i < OUT_FRAMES; i++) {
+					TEST_ASSERT_EQ(out_buf[i * 2], levels[l]);
+					TEST_ASSERT_EQ(out_buf[i * 2 + 1], levels[l]);
+				}
+			}
+		}
+	}
+}
+
+/* Content at the input Nyquist frequency would alias to DC, the filter has a zero there */
+static void test_decimate_nyquist(void)
+{
+	TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(48000, 16)), 0);
+	TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(96000, 16)), 0);
+
+	for (int p = 0; p < 3; p++) {
+		for (int i = 0; i < 96; i++) {
+			int16_t x = (i % 2) ? -16000 : 16000;
+
+			sys_put_le16(x, &in_buf[i * 4]);
+			sys_put_le16(x, &in_buf[i * 4 + 2]);
+		}
+
+		convert(96000, 16);
+
+		if (p == 0) {
+			continue;
+		}
+
+		for (int i = 0; i < OUT_FRAMES * CH_NUM; i++) {
+			TEST_ASSERT_EQ(out_buf[i], 0);
+		}
+	}
+}
+
+/* Decimate a tone and return the largest error against the delayed tone scaled by gain */
+static int32_t decimate_sine(uint8_t bits, double freq_hz, double gain)
+{
+	const double amplitude = 20000;
+	int32_t err_max = 0;
+
+	TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(48000, 16)), 0);
+	TEST_ASSERT_EQ(audio_usb_format_detect(packet_size(96000, bits)), 0);
+
+	for (int p = 0; p < PACKETS; p++) {
+		sine_packet(96000, bits, freq_hz, amplitude, p * 96);
+		convert(96000, bits);
+
+		/* Skip the start from silence */
+		if (p == 0) {
+			continue;
+		}
+
+		for (int i = 0; i < OUT_FRAMES; i++) {
+			int32_t frame = p * OUT_FRAMES + i - DEC_DELAY_FRAMES;
+			double ref = gain * amplitude * sin(2 * PI * freq_hz * frame / 48000);
+
+			err_max = MAX(err_max, abs(out_buf[i * 2] - (int32_t)lround(ref)));
+			err_max = MAX(err_max, abs(out_buf[i * 2 + 1] + (int32_t)lround(ref)));
+		}
+	}
+
+	return err_max;
+}
+
+/* Tones in the passband are kept, without glitches at the packet boundaries */
+static void test_decimate_passband(void)
+{
+	const double freqs_hz[] = { 1000, 10000, 18000, 20000 };
+
+	for (int bits = 16; bits <= 24; bits += 8) {
+		for (int f = 0; f < ARRAY_SIZE(freqs_hz); f++) {
+			int32_t err_max = decimate_sine(bits, freqs_hz[f], 1.0);
+
+			printf("\t%d bit, %.0f Hz: max error %d LSB\n", bits, freqs_hz[f], err_max);
+			TEST_ASSERT(err_max <= 3);
+		}
+	}
+}
+
+/* Tones in the stopband would alias into the audio band, they are removed */
+static void test_decimate_stopband(void)
+{
+	const double freqs_hz[] = { 28000, 30000, 40000, 47000 };
+
+	for (int f = 0; f < ARRAY_SIZE(freqs_hz); f++) {
+		/* The output is compared against silence */
+		int32_t out_max = decimate_sine(24, freqs_hz[f], 0.0);
+
+		printf("\t%.0f Hz: max output %d LSB\n", freqs_hz[f], out_max);
+		TEST_ASSERT(out_max <= 4);
+	}
+}
+
+int main(void)
+{
+	TEST_RUN(test_detect);
+	TEST_RUN(test_convert_errors);
+	TEST_RUN(test_s24_to_s16);
+	TEST_RUN(test_decimate_dc);
+	TEST_RUN(test_decimate_nyquist);
+	TEST_RUN(test_decimate_passband);
+	TEST_RUN(test_decimate_stopband);
+
+	return 0;
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <pthread.h>
+
+#include "audio_usb_out.h"
+#include "channel_assignment.h"
+#include "test_common.h"
+
+#define SAMPLES_PER_MS (CONFIG_AUDIO_SAMPLE_RATE_HZ / 1000)
+#define CHUNKS_PER_FRAME (CONFIG_AUDIO_FRAME_DURATION_US / 1000)
+#define SAMPLES_PER_FRAME (SAMPLES_PER_MS * CHUNKS_PER_FRAME)
+#define FRAME_NUM (CONFIG_FIFO_RX_FRAME_COUNT + 1)
+#define STREAM_FRAMES 2000
+
+static int16_t packet[SAMPLES_PER_MS * 2];
+/* Sample index of the next packet written, the left channel carries it */
+static uint32_t wr_pos;
+static uint32_t rd_pos;
+
+static int write_packet(void)
+{
+	int ret;
+
+	for (int i = 0; i < SAMPLES_PER_MS; i++) {
+		packet[i * 2] = (int16_t)(wr_pos + i);
+		packet[i * 2 + 1] = (int16_t)~(wr_pos + i);
+	}
+
+	ret = audio_usb_out_write(packet, sizeof(packet));
+	if (ret == 0) {
+		wr_pos += SAMPLES_PER_MS;
+	}
+
+	return ret;
+}
+
+static void write_frames(int num)
+{
+	for (int i = 0; i < num * CHUNKS_PER_FRAME; i++) {
+		TEST_ASSERT_EQ(write_packet(), 0);
+	}
+}
+
+static void check_frame(void *pcm_data_mono[], size_t pcm_size_mono, uint32_t pos)
+{
+	int16_t *left = pcm_data_mono[AUDIO_CH_L];
+	int16_t *right = pcm_data_mono[AUDIO_CH_R];
+
+	TEST_ASSERT_EQ(pcm_size_mono, SAMPLES_PER_FRAME * sizeof(int16_t));
+
+	for (int i = 0; i < SAMPLES_PER_FRAME; i++) {
+		TEST_ASSERT_EQ(left[i], (int16_t)(pos + i));
+		TEST_ASSERT_EQ(right[i], (int16_t)~(pos + i));
+	}
+}
+
+static void read_frame(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT), 0);
+	check_frame(pcm_data_mono, pcm_size_mono, rd_pos);
+	audio_usb_out_frame_free();
+	rd_pos += SAMPLES_PER_FRAME;
+}
+
+/* Read out all complete frames and drop a partial one, so each test starts empty */
+static void setup(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	audio_usb_out_restart();
+
+	while (audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT) == 0) {
+		audio_usb_out_frame_free();
+	}
+
+	wr_pos = 0;
+	rd_pos = 0;
+}
+
+static void test_split(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	setup();
+
+	for (int i = 0; i < CHUNKS_PER_FRAME - 1; i++) {
+		TEST_ASSERT_EQ(write_packet(), 0);
+	}
+
+	/* Only complete frames are handed to the encoder */
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT),
+		       -EBUSY);
+
+	TEST_ASSERT_EQ(write_packet(), 0);
+	read_frame();
+
+	write_frames(2);
+	read_frame();
+	read_frame();
+}
+
+static void test_wrong_size(void)
+{
+	uint32_t capacity_us;
+
+	setup();
+
+	TEST_ASSERT_EQ(audio_usb_out_write(packet, sizeof(packet) - 4), -EINVAL);
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), 0);
+}
+
+static void test_fill(void)
+{
+	uint32_t capacity_us;
+
+	setup();
+
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), 0);
+	TEST_ASSERT_EQ(capacity_us, FRAME_NUM * CONFIG_AUDIO_FRAME_DURATION_US);
+
+	for (int i = 0; i < CHUNKS_PER_FRAME + 3; i++) {
+		TEST_ASSERT_EQ(write_packet(), 0);
+	}
+
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us),
+		       CONFIG_AUDIO_FRAME_DURATION_US + 3000);
+
+	/* A frame held by the encoder is still buffered */
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT), 0);
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us),
+		       CONFIG_AUDIO_FRAME_DURATION_US + 3000);
+	audio_usb_out_frame_free();
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), 3000);
+}
+
+/* When full, the newest packets are dropped and the frame held by the encoder stays intact */
+static void test_overrun(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+	uint32_t capacity_us;
+
+	setup();
+
+	write_frames(FRAME_NUM);
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), capacity_us);
+
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT), 0);
+
+	for (int i = 0; i < 3 * CHUNKS_PER_FRAME; i++) {
+		TEST_ASSERT_EQ(write_packet(), -ENOMEM);
+	}
+
+	check_frame(pcm_data_mono, pcm_size_mono, rd_pos);
+	audio_usb_out_frame_free();
+	rd_pos += SAMPLES_PER_FRAME;
+
+	/* Reception continues where it was dropped */
+	write_frames(1);
+
+	for (int i = 0; i < FRAME_NUM; i++) {
+		read_frame();
+	}
+
+	TEST_ASSERT_EQ(rd_pos, wr_pos);
+}
+
+/* A restart drops all received audio, complete frames included */
+static void test_restart(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+	uint32_t capacity_us;
+
+	setup();
+
+	write_frames(2);
+
+	for (int i = 0; i < 4; i++) {
+		TEST_ASSERT_EQ(write_packet(), 0);
+	}
+
+	audio_usb_out_restart();
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), 0);
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT),
+		       -EBUSY);
+
+	/* The next frame starts with the first packet after the restart */
+	rd_pos = wr_pos;
+	write_frames(FRAME_NUM);
+
+	for (int i = 0; i < FRAME_NUM; i++) {
+		read_frame();
+	}
+}
+
+/* A frame held by the encoder survives a restart and is not written again */
+static void test_restart_held(void)
+{
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+	uint32_t capacity_us;
+
+	setup();
+
+	write_frames(FRAME_NUM);
+
+	TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_NO_WAIT), 0);
+
+	audio_usb_out_restart();
+	TEST_ASSERT_EQ(audio_usb_out_fill_us_get(&capacity_us), CONFIG_AUDIO_FRAME_DURATION_US);
+
+	/* Fill the rest of the ring, the held frame stays intact */
+	write_frames(FRAME_NUM - 1);
+	TEST_ASSERT_EQ(write_packet(), -ENOMEM);
+
+	check_frame(pcm_data_mono, pcm_size_mono, 0);
+	audio_usb_out_frame_free();
+
+	rd_pos = FRAME_NUM * SAMPLES_PER_FRAME;
+
+	for (int i = 0; i < FRAME_NUM - 1; i++) {
+		read_frame();
+	}
+
+	TEST_ASSERT_EQ(rd_pos, wr_pos);
+}
+
+static atomic_t waiter_ret;
+
+static void *restart_waiter(void *arg)
+{
+	ARG_UNUSED(arg);
+
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	atomic_set(&waiter_ret,
+		   audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_FOREVER));
+
+	return NULL;
+}
+
+/* An encoder waiting for a frame is released by a restart */
+static void test_restart_waiting(void)
+{
+	pthread_t thread;
+
+	setup();
+
+	atomic_set(&waiter_ret, 1);
+	TEST_ASSERT_EQ(pthread_create(&thread, NULL, restart_waiter, NULL), 0);
+
+	/* Repeated until the waiter has blocked on the empty ring and is released */
+	while (atomic_get(&waiter_ret) == 1) {
+		audio_usb_out_restart();
+		k_yield();
+	}
+
+	pthread_join(thread, NULL);
+
+	TEST_ASSERT_EQ(atomic_get(&waiter_ret), -EAGAIN);
+}
+
+static void *encoder(void *arg)
+{
+	ARG_UNUSED(arg);
+
+	void *pcm_data_mono[AUDIO_CH_NUM];
+	size_t pcm_size_mono;
+
+	for (int i = 0; i < STREAM_FRAMES; i++) {
+		TEST_ASSERT_EQ(audio_usb_out_frame_get(pcm_data_mono, &pcm_size_mono, K_FOREVER),
+			       0);
+		check_frame(pcm_data_mono, pcm_size_mono, rd_pos);
+		rd_pos += SAMPLES_PER_FRAME;
+		audio_usb_out_frame_free();
+	}
+
+	return NULL;
+}
+
+/* USB and the encoder run concurrently, every frame arrives whole and in order */
+static void test_stream(void)
+{
+	pthread_t thread;
+	uint32_t overruns = 0;
+
+	setup();
+
+	TEST_ASSERT_EQ(pthread_create(&thread, NULL, encoder, NULL), 0);
+
+	while (wr_pos < STREAM_FRAMES * SAMPLES_PER_FRAME) {
+		int ret = write_packet();
+
+		if (ret == -ENOMEM) {
+			overruns++;
+			k_yield();
+			continue;
+		}
+
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	pthread_join(thread, NULL);
+
+	printf("\t%d frames, %u packets dropped\n", STREAM_FRAMES, overruns);
+	TEST_ASSERT_EQ(rd_pos, wr_pos);
+}
+
+int main(void)
+{
+	TEST_RUN(test_split);
+	TEST_RUN(test_wrong_size);
+	TEST_RUN(test_fill);
+	TEST_RUN(test_overrun);
+	TEST_RUN(test_restart);
+	TEST_RUN(test_restart_held);
+	TEST_RUN(test_restart_waiting);
+	TEST_RUN(test_stream);
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _TEST_COMMON_H_
+#define _TEST_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* A failed check ends the test program with a non-zero exit code */
+#define TEST_ASSERT(cond)                                                                          \
+	do {                                                                                       \
+		if (!(cond)) {                                                                     \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+			exit(1);                                                                   \
+		}                                                                                  \
+	} while (0)
+
+#define TEST_ASSERT_EQ(a, b)                                                                       \
+	do {                                                                                       \
+		long long _a = (long long)(a);                                                     \
+		long long _b = (long long)(b);                                                     \
+		if (_a != _b) {                                                                    \
+			fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n", __FILE__,        \
+				__LINE__, #a, #b, _a, _b);                                         \
+			exit(1);                                                                   \
+		}                                                                                  \
+	} while (0)
+
+#define TEST_RUN(test)                                                                             \
+	do {                                                                                       \
+		printf("%s\n", #test);                                                             \
+		test();                                                                            \
+	} while (0)
+
+#endif /* _TEST_COMMON_H_ */
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/*
+ * Flood the control event queues as a burst of button interrupts would, and
+ * check that stream state events are never lost, UI events overflow cleanly
+ * and volume presses are coalesced into their net sum.
+ */
+
+#include "ctrl_events.h"
+#include "button_assignments.h"
+#include "test_common.h"
+
+#define FLOOD_PRESSES 100000
+
+static int button_put(button_pin_t pin)
+{
+	struct event_t event = {
+		.event_source = EVT_SRC_BUTTON,
+		.button_activity = { .button_pin = pin, .button_action = BUTTON_PRESS },
+	};
+
+	return ctrl_events_put(&event);
+}
+
+static void drain(void)
+{
+	struct event_t event;
+
+	while (ctrl_events_get(&event, K_NO_WAIT) == 0) {
+	}
+
+	TEST_ASSERT(ctrl_events_queue_empty());
+}
+
+static void test_ui_overflow_keeps_state_events(void)
+{
+	int ret;
+	int accepted = 0;
+	struct event_t event;
+
+	drain();
+
+	for (int i = 0; i < 100; i++) {
+		ret = button_put(BUTTON_PLAY_PAUSE);
+		if (ret == 0) {
+			accepted++;
+		} else {
+			TEST_ASSERT_EQ(ret, -ENOMSG);
+		}
+	}
+
+	TEST_ASSERT_EQ(accepted, CONFIG_CTRL_EVENTS_UI_QUEUE_SIZE);
+
+	/* State events have their own queue, and are returned first */
+	ret = ctrl_events_le_audio_event_send(LE_AUDIO_EVT_NOT_STREAMING);
+	TEST_ASSERT_EQ(ret, 0);
+
+	ret = ctrl_events_get(&event, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+	TEST_ASSERT_EQ(event.event_source, EVT_SRC_LE_AUDIO);
+	TEST_ASSERT_EQ(event.le_audio_activity.le_audio_evt_type, LE_AUDIO_EVT_NOT_STREAMING);
+
+	for (int i = 0; i < CONFIG_CTRL_EVENTS_UI_QUEUE_SIZE; i++) {
+		ret = ctrl_events_get(&event, K_NO_WAIT);
+		TEST_ASSERT_EQ(ret, 0);
+		TEST_ASSERT_EQ(event.event_source, EVT_SRC_BUTTON);
+		TEST_ASSERT_EQ(event.button_activity.button_pin, BUTTON_PLAY_PAUSE);
+	}
+
+	ret = ctrl_events_get(&event, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, -ENOMSG);
+}
+
+static void test_volume_coalescing(void)
+{
+	int ret;
+	struct event_t event;
+
+	drain();
+
+	for (int i = 0; i < 50; i++) {
+		TEST_ASSERT_EQ(button_put(BUTTON_VOLUME_UP), 0);
+	}
+
+	for (int i = 0; i < 20; i++) {
+		TEST_ASSERT_EQ(button_put(BUTTON_VOLUME_DOWN), 0);
+	}
+
+	ret = ctrl_events_get(&event, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+	TEST_ASSERT_EQ(event.event_source, EVT_SRC_VOLUME);
+	TEST_ASSERT_EQ(event.volume_delta, 30);
+	TEST_ASSERT(ctrl_events_queue_empty());
+
+	/* Presses which cancel out give no event */
+	for (int i = 0; i < 5; i++) {
+		TEST_ASSERT_EQ(button_put(BUTTON_VOLUME_UP), 0);
+		TEST_ASSERT_EQ(button_put(BUTTON_VOLUME_DOWN), 0);
+	}
+
+	ret = ctrl_events_get(&event, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, -ENOMSG);
+}
+
+static void test_class_priority(void)
+{
+	struct event_t event;
+
+	drain();
+
+	TEST_ASSERT_EQ(button_put(BUTTON_MUTE), 0);
+	TEST_ASSERT_EQ(button_put(BUTTON_VOLUME_DOWN), 0);
+	TEST_ASSERT_EQ(ctrl_events_le_audio_event_send(LE_AUDIO_EVT_STREAMING), 0);
+
+	TEST_ASSERT_EQ(ctrl_events_get(&event, K_NO_WAIT), 0);
+	TEST_ASSERT_EQ(event.event_source, EVT_SRC_LE_AUDIO);
+	TEST_ASSERT_EQ(ctrl_events_get(&event, K_NO_WAIT), 0);
+	TEST_ASSERT_EQ(event.event_source, EVT_SRC_VOLUME);
+	TEST_ASSERT_EQ(event.volume_delta, -1);
+	TEST_ASSERT_EQ(ctrl_events_get(&event, K_NO_WAIT), 0);
+	TEST_ASSERT_EQ(event.event_source, EVT_SRC_BUTTON);
+	TEST_ASSERT_EQ(event.button_activity.button_pin, BUTTON_MUTE);
+}
+
+struct flood_arg {
+	button_pin_t pin;
+	int presses;
+	int ui_dropped;
+};
+
+static void *flood(void *arg)
+{
+	struct flood_arg *f = arg;
+
+	for (int i = 0; i < f->presses; i++) {
+		if (button_put(f->pin) != 0) {
+			f->ui_dropped++;
+		}
+	}
+
+	return NULL;
+}
+
+/* Presses from two "ISRs" race with the event handler taking events */
+static void test_concurrent_flood(void)
+{
+	int ret;
+	pthread_t threads[3];
+	struct flood_arg args[] = {
+		{ .pin = BUTTON_VOLUME_UP, .presses = FLOOD_PRESSES },
+		{ .pin = BUTTON_VOLUME_DOWN, .presses = FLOOD_PRESSES / 4 },
+		{ .pin = BUTTON_TEST_TONE, .presses = 1000 },
+	};
+	int32_t volume_sum = 0;
+	int volume_events = 0;
+	int ui_events = 0;
+	int state_events = 0;
+	struct event_t event;
+
+	drain();
+
+	for (int i = 0; i < ARRAY_SIZE(threads); i++) {
+		TEST_ASSERT_EQ(pthread_create(&threads[i], NULL, flood, &args[i]), 0);
+	}
+
+	for (int i = 0; i < CONFIG_CTRL_EVENTS_STATE_QUEUE_SIZE; i++) {
+		TEST_ASSERT_EQ(ctrl_events_le_audio_event_send(LE_AUDIO_EVT_STREAMING), 0);
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(threads); i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	while ((ret = ctrl_events_get(&event, K_NO_WAIT)) == 0) {
+		switch (event.event_source) {
+		case EVT_SRC_VOLUME:
+			volume_sum += event.volume_delta;
+			volume_events++;
+			break;
+		case EVT_SRC_BUTTON:
+			ui_events++;
+			break;
+		case EVT_SRC_LE_AUDIO:
+			state_events++;
+			break;
+		}
+	}
+
+	TEST_ASSERT_EQ(ret, -ENOMSG);
+	TEST_ASSERT(ctrl_events_queue_empty());
+	TEST_ASSERT_EQ(state_events, CONFIG_CTRL_EVENTS_STATE_QUEUE_SIZE);
+	TEST_ASSERT_EQ(volume_sum, FLOOD_PRESSES - FLOOD_PRESSES / 4);
+	TEST_ASSERT_EQ(ui_events + args[2].ui_dropped, args[2].presses);
+	TEST_ASSERT_EQ(ui_events, CONFIG_CTRL_EVENTS_UI_QUEUE_SIZE);
+	TEST_ASSERT_EQ(args[0].ui_dropped + args[1].ui_dropped, 0);
+
+	printf("\t%d volume presses in %d event(s), %d UI presses dropped\n",
+	       args[0].presses + args[1].presses, volume_events, args[2].ui_dropped);
+}
+
+/* The event handler drains while presses keep arriving */
+static void test_concurrent_drain(void)
+{
+	pthread_t thread;
+	struct flood_arg arg = { .pin = BUTTON_VOLUME_DOWN, .presses = FLOOD_PRESSES };
+	int32_t volume_sum = 0;
+	struct event_t event;
+
+	drain();
+
+	TEST_ASSERT_EQ(pthread_create(&thread, NULL, flood, &arg), 0);
+
+	while (volume_sum > -FLOOD_PRESSES) {
+		if (ctrl_events_get(&event, K_MSEC(1000)) != 0) {
+			break;
+		}
+
+		TEST_ASSERT_EQ(event.event_source, EVT_SRC_VOLUME);
+		volume_sum += event.volume_delta;
+	}
+
+	pthread_join(thread, NULL);
+
+	TEST_ASSERT_EQ(volume_sum, -FLOOD_PRESSES);
+	TEST_ASSERT_EQ(ctrl_events_get(&event, K_NO_WAIT), -ENOMSG);
+}
+
+int main(void)
+{
+	TEST_RUN(test_ui_overflow_keeps_state_events);
+	TEST_RUN(test_volume_coalescing);
+	TEST_RUN(test_class_priority);
+	TEST_RUN(test_concurrent_flood);
+	TEST_RUN(test_concurrent_drain);
+
+	return 0;
+}
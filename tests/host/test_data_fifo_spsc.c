@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/*
+ * Concurrent producer/consumer test of the SPSC data_fifo. Each block carries
+ * a sequence number, and the consumer checks that every block arrives once and
+ * in order. Throughput is printed as a micro-benchmark.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "data_fifo.h"
+#include "test_common.h"
+
+#define BLK_SIZE 16
+#define BLK_WORDS (BLK_SIZE / sizeof(uint32_t))
+#define STRESS_BLKS 200000
+#define BENCH_ROUNDS 1000000
+#define SPAN_NUM 3
+
+DATA_FIFO_SPSC_DEFINE(fifo_blk, 8, BLK_SIZE);
+/* Spans of a ring which is a multiple of the span size never wrap */
+DATA_FIFO_SPSC_SPAN_DEFINE(fifo_span, 12, BLK_SIZE, SPAN_NUM);
+/* Spans of this ring wrap, and are copied into the slack */
+DATA_FIFO_SPSC_SPAN_DEFINE(fifo_span_wrap, 10, BLK_SIZE, SPAN_NUM);
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void blk_fill(uint32_t *blk, uint32_t seq)
+{
+	for (int i = 0; i < BLK_WORDS; i++) {
+		blk[i] = seq + i;
+	}
+}
+
+static void blk_check(const uint32_t *blk, uint32_t seq)
+{
+	for (int i = 0; i < BLK_WORDS; i++) {
+		TEST_ASSERT_EQ(blk[i], seq + i);
+	}
+}
+
+/* Block size varies with the sequence number, to check that it is passed on */
+static size_t blk_size(uint32_t seq)
+{
+	return sizeof(uint32_t) * (1 + seq % BLK_WORDS);
+}
+
+struct producer_arg {
+	struct data_fifo *fifo;
+	uint32_t num;
+	bool full_blocks;
+	uint32_t overruns;
+};
+
+static void *producer(void *arg)
+{
+	int ret;
+	struct producer_arg *p = arg;
+	uint32_t *blk;
+
+	for (uint32_t seq = 0; seq < p->num; seq++) {
+		/* Alternate between polling, as from an ISR, and blocking */
+		if (seq & 0x400) {
+			while (data_fifo_pointer_first_vacant_get(p->fifo, (void **)&blk,
+								  K_NO_WAIT) == -ENOMEM) {
+				p->overruns++;
+				k_yield();
+			}
+		} else {
+			ret = data_fifo_pointer_first_vacant_get(p->fifo, (void **)&blk, K_FOREVER);
+			TEST_ASSERT_EQ(ret, 0);
+		}
+
+		blk_fill(blk, seq);
+
+		ret = data_fifo_block_lock(p->fifo, (void **)&blk,
+					   p->full_blocks ? BLK_SIZE : blk_size(seq));
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	return NULL;
+}
+
+static void producer_start(pthread_t *thread, struct producer_arg *arg)
+{
+	TEST_ASSERT_EQ(pthread_create(thread, NULL, producer, arg), 0);
+}
+
+static void test_block_stress(void)
+{
+	int ret;
+	pthread_t thread;
+	struct producer_arg arg = { .fifo = &fifo_blk, .num = STRESS_BLKS };
+	uint64_t start = now_ns();
+
+	producer_start(&thread, &arg);
+
+	for (uint32_t seq = 0; seq < STRESS_BLKS; seq++) {
+		uint32_t *blk;
+		size_t size;
+
+		ret = data_fifo_pointer_last_filled_get(&fifo_blk, (void **)&blk, &size, K_FOREVER);
+		TEST_ASSERT_EQ(ret, 0);
+		TEST_ASSERT_EQ(size, blk_size(seq));
+		TEST_ASSERT_EQ(blk[0], seq);
+		blk_check(blk, seq);
+
+		ret = data_fifo_block_free(&fifo_blk, (void **)&blk);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	pthread_join(thread, NULL);
+
+	/* Nothing left over, and nothing duplicated */
+	uint32_t alloced;
+	uint32_t locked;
+
+	ret = data_fifo_num_used_get(&fifo_blk, &alloced, &locked);
+	TEST_ASSERT_EQ(ret, 0);
+	TEST_ASSERT_EQ(alloced, 0);
+	TEST_ASSERT_EQ(locked, 0);
+
+	printf("\t%u blocks across threads: %llu ns/block, %u producer overruns\n", STRESS_BLKS,
+	       (unsigned long long)((now_ns() - start) / STRESS_BLKS), arg.overruns);
+}
+
+static void span_stress(struct data_fifo *fifo)
+{
+	int ret;
+	pthread_t thread;
+	struct producer_arg arg = { .fifo = fifo, .num = STRESS_BLKS, .full_blocks = true };
+	uint64_t start = now_ns();
+
+	producer_start(&thread, &arg);
+
+	for (uint32_t seq = 0; seq + SPAN_NUM <= STRESS_BLKS; seq += SPAN_NUM) {
+		uint32_t *span;
+		size_t size;
+
+		ret = data_fifo_span_get(fifo, (void **)&span, &size, SPAN_NUM, K_FOREVER);
+		TEST_ASSERT_EQ(ret, 0);
+		TEST_ASSERT_EQ(size, SPAN_NUM * BLK_SIZE);
+
+		/* The blocks must be contiguous, also when the span wraps */
+		for (int i = 0; i < SPAN_NUM; i++) {
+			blk_check(&span[i * BLK_WORDS], seq + i);
+		}
+
+		ret = data_fifo_span_free(fifo, (void **)&span, SPAN_NUM);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	/* Drain the last blocks one by one */
+	for (uint32_t seq = STRESS_BLKS - (STRESS_BLKS % SPAN_NUM); seq < STRESS_BLKS; seq++) {
+		uint32_t *blk;
+		size_t size;
+
+		ret = data_fifo_pointer_last_filled_get(fifo, (void **)&blk, &size, K_FOREVER);
+		TEST_ASSERT_EQ(ret, 0);
+		blk_check(blk, seq);
+
+		ret = data_fifo_block_free(fifo, (void **)&blk);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	pthread_join(thread, NULL);
+
+	printf("\t%u blocks as spans of %d: %llu ns/block\n", STRESS_BLKS, SPAN_NUM,
+	       (unsigned long long)((now_ns() - start) / STRESS_BLKS));
+}
+
+static void test_span_stress(void)
+{
+	span_stress(&fifo_span);
+}
+
+static void test_span_wrap_stress(void)
+{
+	span_stress(&fifo_span_wrap);
+}
+
+static void *span_waiter(void *arg)
+{
+	void *span;
+	size_t size;
+
+	return (void *)(intptr_t)data_fifo_span_get(arg, &span, &size, SPAN_NUM, K_FOREVER);
+}
+
+static void test_empty_wakes_consumer(void)
+{
+	int ret;
+	void *thread_ret;
+	pthread_t thread;
+	uint32_t *blk;
+	size_t size;
+
+	ret = data_fifo_empty(&fifo_span);
+	TEST_ASSERT_EQ(ret, 0);
+
+	/* One block is not enough for a span, so the consumer blocks */
+	ret = data_fifo_pointer_first_vacant_get(&fifo_span, (void **)&blk, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+	ret = data_fifo_block_lock(&fifo_span, (void **)&blk, BLK_SIZE);
+	TEST_ASSERT_EQ(ret, 0);
+
+	TEST_ASSERT_EQ(pthread_create(&thread, NULL, span_waiter, &fifo_span), 0);
+
+	while (!atomic_get(&fifo_span.ring.consumer_waiting)) {
+		k_yield();
+	}
+
+	k_msleep(10);
+
+	ret = data_fifo_empty(&fifo_span);
+	TEST_ASSERT_EQ(ret, 0);
+
+	pthread_join(thread, &thread_ret);
+	TEST_ASSERT_EQ((intptr_t)thread_ret, -ECANCELED);
+
+	/* Usable again after the reset */
+	for (uint32_t seq = 0; seq < SPAN_NUM; seq++) {
+		ret = data_fifo_pointer_first_vacant_get(&fifo_span, (void **)&blk, K_NO_WAIT);
+		TEST_ASSERT_EQ(ret, 0);
+		blk_fill(blk, seq);
+		ret = data_fifo_block_lock(&fifo_span, (void **)&blk, BLK_SIZE);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	ret = data_fifo_span_get(&fifo_span, (void **)&blk, &size, SPAN_NUM, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+	blk_check(blk, 0);
+	ret = data_fifo_span_free(&fifo_span, (void **)&blk, SPAN_NUM);
+	TEST_ASSERT_EQ(ret, 0);
+}
+
+static void span_produce(struct data_fifo *fifo, uint32_t seq)
+{
+	int ret;
+	uint32_t *blk;
+
+	for (int i = 0; i < SPAN_NUM; i++) {
+		ret = data_fifo_pointer_first_vacant_get(fifo, (void **)&blk, K_NO_WAIT);
+		TEST_ASSERT_EQ(ret, 0);
+		blk_fill(blk, seq + i);
+		ret = data_fifo_block_lock(fifo, (void **)&blk, BLK_SIZE);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+}
+
+/* A span or block held by the consumer across a reset is dropped on free */
+static void test_free_after_empty(void)
+{
+	int ret;
+	uint32_t *span;
+	uint32_t *blk;
+	size_t size;
+	uint32_t alloced;
+	uint32_t locked;
+
+	ret = data_fifo_empty(&fifo_span);
+	TEST_ASSERT_EQ(ret, 0);
+
+	span_produce(&fifo_span, 0);
+	ret = data_fifo_span_get(&fifo_span, (void **)&span, &size, SPAN_NUM, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+
+	ret = data_fifo_empty(&fifo_span);
+	TEST_ASSERT_EQ(ret, 0);
+
+	/* The producer restarts before the consumer is done with the old span */
+	span_produce(&fifo_span, 100);
+
+	ret = data_fifo_span_free(&fifo_span, (void **)&span, SPAN_NUM);
+	TEST_ASSERT_EQ(ret, 0);
+
+	ret = data_fifo_num_used_get(&fifo_span, &alloced, &locked);
+	TEST_ASSERT_EQ(ret, 0);
+	TEST_ASSERT_EQ(alloced, SPAN_NUM);
+	TEST_ASSERT_EQ(locked, SPAN_NUM);
+
+	/* Same for a single block */
+	ret = data_fifo_pointer_last_filled_get(&fifo_span, (void **)&blk, &size, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+	blk_check(blk, 100);
+
+	ret = data_fifo_empty(&fifo_span);
+	TEST_ASSERT_EQ(ret, 0);
+	span_produce(&fifo_span, 200);
+
+	ret = data_fifo_block_free(&fifo_span, (void **)&blk);
+	TEST_ASSERT_EQ(ret, 0);
+
+	/* The new generation is untouched */
+	ret = data_fifo_span_get(&fifo_span, (void **)&span, &size, SPAN_NUM, K_NO_WAIT);
+	TEST_ASSERT_EQ(ret, 0);
+
+	for (int i = 0; i < SPAN_NUM; i++) {
+		blk_check(&span[i * BLK_WORDS], 200 + i);
+	}
+
+	ret = data_fifo_span_free(&fifo_span, (void **)&span, SPAN_NUM);
+	TEST_ASSERT_EQ(ret, 0);
+
+	ret = data_fifo_num_used_get(&fifo_span, &alloced, &locked);
+	TEST_ASSERT_EQ(ret, 0);
+	TEST_ASSERT_EQ(alloced, 0);
+	TEST_ASSERT_EQ(locked, 0);
+}
+
+/* Cost of one alloc/lock/get/free round trip without contention */
+static void test_bench_single_thread(void)
+{
+	int ret;
+	uint64_t start;
+
+	ret = data_fifo_empty(&fifo_blk);
+	TEST_ASSERT_EQ(ret, 0);
+
+	start = now_ns();
+
+	for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+		void *blk;
+		size_t size;
+
+		ret = data_fifo_pointer_first_vacant_get(&fifo_blk, &blk, K_NO_WAIT);
+		ret |= data_fifo_block_lock(&fifo_blk, &blk, BLK_SIZE);
+		ret |= data_fifo_pointer_last_filled_get(&fifo_blk, &blk, &size, K_NO_WAIT);
+		ret |= data_fifo_block_free(&fifo_blk, &blk);
+		TEST_ASSERT_EQ(ret, 0);
+	}
+
+	printf("\t%u round trips: %llu ns each\n", BENCH_ROUNDS,
+	       (unsigned long long)((now_ns() - start) / BENCH_ROUNDS));
+}
+
+int main(void)
+{
+	TEST_ASSERT_EQ(data_fifo_init(&fifo_blk), 0);
+	TEST_ASSERT_EQ(data_fifo_init(&fifo_span), 0);
+	TEST_ASSERT_EQ(data_fifo_init(&fifo_span_wrap), 0);
+
+	TEST_RUN(test_block_stress);
+	TEST_RUN(test_span_stress);
+	TEST_RUN(test_span_wrap_stress);
+	TEST_RUN(test_empty_wakes_consumer);
+	TEST_RUN(test_free_after_empty);
+	TEST_RUN(test_bench_single_thread);
+
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/*
+ * Closed loop model of the encode scheduler. Each encoded frame is ready a
+ * fixed time after its I2S blocks, so the time it is ready follows the I2S
+ * phase. Locked drift compensation moves the I2S phase towards the offset set
+ * by the scheduler, by half the error every measurement period. The margin
+ * must settle at the target without unlocking drift compensation and without
+ * a frame crossing an anchor.
+ */
+
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "encode_sched.h"
+#include "audio_sync_timer.h"
+#include "test_common.h"
+
+#define ISO_INTERVAL_US CONFIG_AUDIO_FRAME_DURATION_US
+#define BLK_PERIOD_US 1000
+#define DRIFT_MEAS_PERIOD_US 100000
+/* Compared to the halved error in audio_datapath.c */
+#define DRIFT_ERR_THRESH_UNLOCK 32
+#define TARGET_US CONFIG_ENCODE_SCHED_MARGIN_US
+
+static uint32_t now_us;
+
+/* Phase offset set by the scheduler, unwrapped */
+static int64_t cmd_us;
+static uint32_t cmd_mod_us;
+
+uint32_t audio_sync_timer_curr_time_get(void)
+{
+	return now_us;
+}
+
+void audio_datapath_i2s_phase_offset_set(uint32_t offset_us)
+{
+	cmd_us += audio_sync_timer_phase_us(offset_us, cmd_mod_us, BLK_PERIOD_US);
+	cmd_mod_us = offset_us;
+}
+
+struct model {
+	/* Physical I2S phase shift, unwrapped */
+	double phase_us;
+	/* Phase change per frame, set by drift compensation */
+	double rate_us;
+	/* Ready time of the first frame relative to its anchor period */
+	int32_t ready0_us;
+	uint32_t frame;
+	int32_t err_max_us;
+	uint32_t margin_min_us;
+	uint32_t margin_max_us;
+};
+
+static void model_init(struct model *m, uint32_t margin0_us)
+{
+	*m = (struct model){
+		.ready0_us = ISO_INTERVAL_US - margin0_us,
+		.margin_min_us = UINT32_MAX,
+	};
+
+	now_us = 0;
+	cmd_us = 0;
+	cmd_mod_us = 0;
+	encode_sched_reset();
+}
+
+static uint32_t margin_get(struct model *m)
+{
+	int64_t ready_us = m->ready0_us + llround(m->phase_us);
+
+	return ISO_INTERVAL_US - (uint32_t)(ready_us % ISO_INTERVAL_US);
+}
+
+static void model_run(struct model *m, uint32_t frames)
+{
+	const uint32_t frames_per_meas = DRIFT_MEAS_PERIOD_US / ISO_INTERVAL_US;
+
+	for (uint32_t i = 0; i < frames; i++, m->frame++) {
+		uint32_t anchor_us = m->frame * ISO_INTERVAL_US;
+		uint32_t margin_us = margin_get(m);
+
+		m->margin_min_us = MIN(m->margin_min_us, margin_us);
+		m->margin_max_us = MAX(m->margin_max_us, margin_us);
+
+		now_us = anchor_us + ISO_INTERVAL_US - margin_us;
+		encode_sched_anchor_update(anchor_us);
+
+		/* Drift compensation measures the block phase error */
+		if (m->frame % frames_per_meas == 0) {
+			int32_t err_us = audio_sync_timer_phase_us(
+				(uint32_t)cmd_us, (uint32_t)llround(m->phase_us), BLK_PERIOD_US);
+
+			err_us /= 2;
+			m->err_max_us = MAX(m->err_max_us, abs(err_us));
+			m->rate_us = (double)err_us / frames_per_meas;
+		}
+
+		m->phase_us += m->rate_us;
+	}
+}
+
+static void test_acquire(void)
+{
+	const uint32_t margins[] = { 9900, 7000, 5000, 3100, 2000, 400 };
+	struct model m;
+
+	for (int i = 0; i < ARRAY_SIZE(margins); i++) {
+		model_init(&m, margins[i]);
+		model_run(&m, 5000);
+
+		printf("\tfrom %4u us: margin %4u us, range %4u-%4u us, max drift error %2d us\n",
+		       margins[i], margin_get(&m), m.margin_min_us, m.margin_max_us, m.err_max_us);
+
+		TEST_ASSERT(abs((int32_t)margin_get(&m) - TARGET_US) <= 40);
+		TEST_ASSERT(m.err_max_us <= DRIFT_ERR_THRESH_UNLOCK);
+		/* No frame crossed an anchor */
+		TEST_ASSERT(m.margin_min_us >= MIN(margins[i], TARGET_US) - 100);
+		TEST_ASSERT(m.margin_max_us <= MAX(margins[i], TARGET_US) + 100);
+	}
+}
+
+/* Once tracking, the margin stays put */
+static void test_track(void)
+{
+	struct model m;
+
+	model_init(&m, 6000);
+	model_run(&m, 5000);
+
+	m.margin_min_us = UINT32_MAX;
+	m.margin_max_us = 0;
+	model_run(&m, 5000);
+
+	TEST_ASSERT(m.margin_max_us - m.margin_min_us <= 60);
+}
+
+/* A reset after a stream restart acquires from scratch */
+static void test_reset(void)
+{
+	struct model m;
+
+	model_init(&m, 8000);
+	model_run(&m, 5000);
+	TEST_ASSERT(abs((int32_t)margin_get(&m) - TARGET_US) <= 40);
+
+	model_init(&m, 1500);
+	TEST_ASSERT_EQ(cmd_mod_us, 0);
+	model_run(&m, 5000);
+	TEST_ASSERT(abs((int32_t)margin_get(&m) - TARGET_US) <= 40);
+}
+
+int main(void)
+{
+	TEST_RUN(test_acquire);
+	TEST_RUN(test_track);
+	TEST_RUN(test_reset);
+
+	return 0;
+}
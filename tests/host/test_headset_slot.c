@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+
+#include "headset_slot.h"
+#include "test_common.h"
+
+#define SLOT_NUM 4
+
+/* Connections are only compared, any distinct addresses will do */
+static char conn_objs[8];
+#define CONN(n) ((struct bt_conn *)&conn_objs[n])
+
+static struct bt_conn *slots[SLOT_NUM];
+
+static int take(int n, enum audio_channel channel)
+{
+	return headset_slot_take(slots, SLOT_NUM, CONN(n), channel);
+}
+
+static void setup(void)
+{
+	memset(slots, 0, sizeof(slots));
+}
+
+static void test_pairs(void)
+{
+	setup();
+
+	TEST_ASSERT_EQ(take(0, AUDIO_CH_L), 0);
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_L), 2);
+	TEST_ASSERT_EQ(take(2, AUDIO_CH_R), 1);
+	TEST_ASSERT_EQ(take(3, AUDIO_CH_R), 3);
+
+	for (int i = 0; i < SLOT_NUM; i++) {
+		TEST_ASSERT_EQ(HEADSET_SLOT_CH(i), i % 2 ? AUDIO_CH_R : AUDIO_CH_L);
+	}
+
+	/* Both slots of each channel are taken */
+	TEST_ASSERT_EQ(take(4, AUDIO_CH_L), -ENOMEM);
+	TEST_ASSERT_EQ(take(4, AUDIO_CH_R), -ENOMEM);
+}
+
+static void test_retake_keeps_slot(void)
+{
+	setup();
+
+	TEST_ASSERT_EQ(take(0, AUDIO_CH_L), 0);
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_L), 2);
+
+	/* Slot 0 is freed, the headset in slot 2 must not take it as well */
+	TEST_ASSERT_EQ(headset_slot_release(slots, SLOT_NUM, CONN(0)), 1);
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_L), 2);
+	TEST_ASSERT(slots[0] == NULL);
+
+	/* A new headset gets the lowest free slot */
+	TEST_ASSERT_EQ(take(5, AUDIO_CH_L), 0);
+}
+
+/* The cached location was left, the PACS location read says right */
+static void test_location_change(void)
+{
+	setup();
+
+	TEST_ASSERT_EQ(take(0, AUDIO_CH_L), 0);
+	TEST_ASSERT_EQ(take(0, AUDIO_CH_R), 1);
+	TEST_ASSERT(slots[0] == NULL);
+
+	/* All slots of the new channel are taken, the old one is still released */
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_L), 0);
+	TEST_ASSERT_EQ(take(2, AUDIO_CH_L), 2);
+	TEST_ASSERT_EQ(take(3, AUDIO_CH_R), 3);
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_R), -ENOMEM);
+	TEST_ASSERT(slots[0] == NULL);
+}
+
+static void test_release(void)
+{
+	setup();
+
+	TEST_ASSERT_EQ(headset_slot_release(slots, SLOT_NUM, CONN(0)), 0);
+
+	TEST_ASSERT_EQ(take(0, AUDIO_CH_R), 1);
+	TEST_ASSERT_EQ(take(1, AUDIO_CH_R), 3);
+	TEST_ASSERT_EQ(headset_slot_release(slots, SLOT_NUM, CONN(0)), 1);
+	TEST_ASSERT(slots[1] == NULL);
+	TEST_ASSERT(slots[3] == CONN(1));
+}
+
+/* With two headsets there is one slot per channel */
+static void test_two_slots(void)
+{
+	setup();
+
+	TEST_ASSERT_EQ(headset_slot_take(slots, 2, CONN(0), AUDIO_CH_R), 1);
+	TEST_ASSERT_EQ(headset_slot_take(slots, 2, CONN(1), AUDIO_CH_R), -ENOMEM);
+	TEST_ASSERT_EQ(headset_slot_take(slots, 2, CONN(1), AUDIO_CH_L), 0);
+	TEST_ASSERT(slots[2] == NULL);
+}
+
+int main(void)
+{
+	TEST_RUN(test_pairs);
+	TEST_RUN(test_retake_keeps_slot);
+	TEST_RUN(test_location_change);
+	TEST_RUN(test_release);
+	TEST_RUN(test_two_slots);
+
+	return 0;
+}
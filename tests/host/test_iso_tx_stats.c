@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+
+#include "iso_tx_stats.h"
+#include "test_common.h"
+
+static struct iso_tx_stats stats;
+
+static void get(uint8_t chan_idx)
+{
+	TEST_ASSERT_EQ(iso_tx_stats_get(chan_idx, &stats), 0);
+}
+
+static void test_send_sent(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, 1);
+	iso_tx_stats_send(0, 2);
+	iso_tx_stats_send(0, 2);
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 3);
+	TEST_ASSERT_EQ(stats.sent, 0);
+	TEST_ASSERT_EQ(stats.depth_max, 2);
+	TEST_ASSERT_EQ(stats.depth_hist[0], 1);
+	TEST_ASSERT_EQ(stats.depth_hist[1], 2);
+	TEST_ASSERT_EQ(stats.latency_min_us, UINT32_MAX);
+
+	iso_tx_stats_sent(0);
+	iso_tx_stats_sent(0);
+	iso_tx_stats_sent(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 0);
+	TEST_ASSERT_EQ(stats.sent, 3);
+	TEST_ASSERT(stats.latency_min_us <= stats.latency_max_us);
+
+	/* Other channels are untouched */
+	get(1);
+	TEST_ASSERT_EQ(stats.sent, 0);
+	TEST_ASSERT_EQ(stats.depth_max, 0);
+}
+
+static void test_depth_hist_saturates(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, ISO_TX_STATS_DEPTH_BINS);
+	iso_tx_stats_send(0, ISO_TX_STATS_DEPTH_BINS + 5);
+	iso_tx_stats_send(0, 0);
+	get(0);
+	TEST_ASSERT_EQ(stats.depth_hist[ISO_TX_STATS_DEPTH_BINS - 1], 2);
+	TEST_ASSERT_EQ(stats.depth_max, ISO_TX_STATS_DEPTH_BINS + 5);
+	TEST_ASSERT_EQ(stats.in_flight, 3);
+
+	iso_tx_stats_stream_stopped(0);
+}
+
+/* Latency is measured from the oldest send, in order */
+static void test_latency(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, 1);
+	k_busy_wait(1200);
+	iso_tx_stats_send(0, 2);
+	iso_tx_stats_sent(0);
+	k_busy_wait(300);
+	iso_tx_stats_sent(0);
+	get(0);
+
+	TEST_ASSERT_EQ(stats.sent, 2);
+	TEST_ASSERT(stats.latency_max_us >= 1200);
+	TEST_ASSERT(stats.latency_min_us >= 300);
+	TEST_ASSERT(stats.latency_min_us < stats.latency_max_us);
+	TEST_ASSERT_EQ(stats.latency_total_us, stats.latency_min_us + stats.latency_max_us);
+	TEST_ASSERT_EQ(stats.latency_hist[stats.latency_max_us / ISO_TX_STATS_LATENCY_BIN_US],
+		       1);
+	TEST_ASSERT(stats.latency_max_us / ISO_TX_STATS_LATENCY_BIN_US >= 2);
+}
+
+/* A rejected SDU is withdrawn and does not take the latency of the next one */
+static void test_send_cancel(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, 1);
+	iso_tx_stats_send(0, 2);
+	iso_tx_stats_send_cancel(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 1);
+
+	iso_tx_stats_sent(0);
+	iso_tx_stats_send_cancel(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 0);
+	TEST_ASSERT_EQ(stats.sent, 1);
+}
+
+static void test_unmatched_and_overrun(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_sent(0);
+	iso_tx_stats_overrun(0);
+	iso_tx_stats_overrun(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.unmatched, 1);
+	TEST_ASSERT_EQ(stats.overruns, 2);
+	TEST_ASSERT_EQ(stats.sent, 0);
+}
+
+/* SDUs in flight when the stream stops are forgotten */
+static void test_stream_stopped(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, 1);
+	iso_tx_stats_send(0, 2);
+	iso_tx_stats_stream_stopped(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 0);
+
+	iso_tx_stats_sent(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.sent, 0);
+	TEST_ASSERT_EQ(stats.unmatched, 1);
+}
+
+/* A reset keeps SDUs in flight, so their sent callbacks are still matched */
+static void test_reset_keeps_in_flight(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(0, 1);
+	iso_tx_stats_sent(0);
+	iso_tx_stats_send(0, 1);
+	iso_tx_stats_reset();
+	get(0);
+	TEST_ASSERT_EQ(stats.sent, 0);
+	TEST_ASSERT_EQ(stats.in_flight, 1);
+	TEST_ASSERT_EQ(stats.depth_max, 0);
+
+	iso_tx_stats_sent(0);
+	get(0);
+	TEST_ASSERT_EQ(stats.sent, 1);
+	TEST_ASSERT_EQ(stats.unmatched, 0);
+}
+
+/* More SDUs in flight than timestamps are kept */
+static void test_pending_full(void)
+{
+	iso_tx_stats_reset();
+
+	for (int i = 0; i < 20; i++) {
+		iso_tx_stats_send(0, i + 1);
+	}
+
+	get(0);
+	TEST_ASSERT(stats.in_flight < 20);
+	TEST_ASSERT_EQ(stats.depth_max, 20);
+
+	for (int i = 0; i < 20; i++) {
+		iso_tx_stats_sent(0);
+	}
+
+	get(0);
+	TEST_ASSERT_EQ(stats.in_flight, 0);
+	TEST_ASSERT_EQ(stats.sent + stats.unmatched, 20);
+}
+
+static void test_invalid_channel(void)
+{
+	iso_tx_stats_reset();
+
+	iso_tx_stats_send(CONFIG_BT_ISO_MAX_CHAN, 1);
+	iso_tx_stats_sent(CONFIG_BT_ISO_MAX_CHAN);
+	iso_tx_stats_overrun(CONFIG_BT_ISO_MAX_CHAN);
+	TEST_ASSERT_EQ(iso_tx_stats_get(CONFIG_BT_ISO_MAX_CHAN, &stats), -EINVAL);
+
+	for (uint8_t i = 0; i < CONFIG_BT_ISO_MAX_CHAN; i++) {
+		get(i);
+		TEST_ASSERT_EQ(stats.sent + stats.in_flight + stats.unmatched + stats.overruns, 0);
+	}
+}
+
+int main(void)
+{
+	TEST_RUN(test_send_sent);
+	TEST_RUN(test_depth_hist_saturates);
+	TEST_RUN(test_latency);
+	TEST_RUN(test_send_cancel);
+	TEST_RUN(test_unmatched_and_overrun);
+	TEST_RUN(test_stream_stopped);
+	TEST_RUN(test_reset_keeps_in_flight);
+	TEST_RUN(test_pending_full);
+	TEST_RUN(test_invalid_channel);
+
+	return 0;
+}
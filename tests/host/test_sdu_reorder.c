@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+
+#include "sdu_reorder.h"
+#include "test_common.h"
+
+#define INTERVAL_US CONFIG_AUDIO_FRAME_DURATION_US
+#define GAP ((void *)-1)
+
+/* Frames are identified by their index into frames[] */
+static int frames[64];
+static void *out_log[64];
+static uint32_t out_ref_log[64];
+static int out_num;
+static void *drop_log[64];
+static int drop_num;
+
+static void out_cb(void *frame, uint32_t sdu_ref_us)
+{
+	out_ref_log[out_num] = sdu_ref_us;
+	out_log[out_num++] = (frame == NULL) ? GAP : frame;
+}
+
+static void drop_cb(void *frame)
+{
+	drop_log[drop_num++] = frame;
+}
+
+static void setup(void)
+{
+	out_num = 0;
+	drop_num = 0;
+	TEST_ASSERT_EQ(sdu_reorder_init(out_cb, drop_cb), 0);
+}
+
+static void put(int idx, uint32_t sdu_ref_us)
+{
+	sdu_reorder_put(&frames[idx], sdu_ref_us);
+}
+
+static void test_in_order(void)
+{
+	setup();
+
+	for (int i = 0; i < 4; i++) {
+		put(i, 1000 + i * INTERVAL_US);
+	}
+
+	TEST_ASSERT_EQ(out_num, 4);
+
+	for (int i = 0; i < 4; i++) {
+		TEST_ASSERT(out_log[i] == &frames[i]);
+	}
+}
+
+static void test_swap_and_gap(void)
+{
+	setup();
+
+	put(0, 0);
+	/* Frame 1 arrives after frame 2 */
+	put(2, 2 * INTERVAL_US);
+	TEST_ASSERT_EQ(out_num, 1);
+	put(1, INTERVAL_US);
+	TEST_ASSERT_EQ(out_num, 3);
+	TEST_ASSERT(out_log[1] == &frames[1]);
+	TEST_ASSERT(out_log[2] == &frames[2]);
+
+	/* Frame 3 never arrives, and is handed out as a gap */
+	put(4, 4 * INTERVAL_US);
+	put(5, 5 * INTERVAL_US);
+	TEST_ASSERT(out_log[3] == GAP);
+	TEST_ASSERT_EQ(out_ref_log[3], 3 * INTERVAL_US);
+	TEST_ASSERT(out_log[4] == &frames[4]);
+
+	/* Late and duplicate frames are dropped */
+	put(3, 4 * INTERVAL_US);
+	put(6, 5 * INTERVAL_US);
+	TEST_ASSERT_EQ(drop_num, 2);
+	TEST_ASSERT_EQ(out_num, 6);
+}
+
+/* A restart must not play frames of the old stream ahead of the new one */
+static void test_restart_jump_drops_held(void)
+{
+	setup();
+
+	put(0, 0);
+	put(2, 2 * INTERVAL_US);
+	TEST_ASSERT_EQ(out_num, 1);
+
+	put(10, 1000 * INTERVAL_US);
+
+	TEST_ASSERT_EQ(drop_num, 1);
+	TEST_ASSERT(drop_log[0] == &frames[2]);
+	TEST_ASSERT_EQ(out_num, 2);
+	TEST_ASSERT(out_log[1] == &frames[10]);
+}
+
+static void test_reset_drops_held(void)
+{
+	setup();
+
+	put(0, 0);
+	put(2, 2 * INTERVAL_US);
+	sdu_reorder_reset();
+
+	TEST_ASSERT_EQ(drop_num, 1);
+	TEST_ASSERT(drop_log[0] == &frames[2]);
+
+	/* Resynchronizes on any sdu_ref after a reset */
+	put(3, 7 * INTERVAL_US + 123);
+	TEST_ASSERT_EQ(out_num, 2);
+	TEST_ASSERT(out_log[1] == &frames[3]);
+}
+
+/* sdu_ref_us wraps at 2^32 */
+static void test_wrap(void)
+{
+	uint32_t ref = UINT32_MAX - INTERVAL_US / 2;
+
+	setup();
+
+	put(0, ref);
+	put(2, ref + 2 * INTERVAL_US);
+	put(1, ref + INTERVAL_US);
+
+	TEST_ASSERT_EQ(out_num, 3);
+	TEST_ASSERT_EQ(drop_num, 0);
+	TEST_ASSERT(out_log[1] == &frames[1]);
+	TEST_ASSERT(out_log[2] == &frames[2]);
+}
+
+int main(void)
+{
+	TEST_RUN(test_in_order);
+	TEST_RUN(test_swap_and_gap);
+	TEST_RUN(test_restart_jump_drops_held);
+	TEST_RUN(test_reset_drops_held);
+	TEST_RUN(test_wrap);
+
+	return 0;
+}
@@ -0,0 +1,267 @@
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""
+Decode an audio timing trace dumped by the audio_trace shell command
+
+Recording starts disabled. Start it with "audio_trace start", then capture
+the output of "audio_trace dump" from the UART or RTT terminal to a file and
+run:
+
+    python audio_trace_decode.py capture.log [--timeline]
+
+The record layout and event IDs must match src/utils/audio_trace.h
+"""
+
+import argparse
+import math
+import re
+import struct
+import sys
+
+RECORD_FMT = "<IBBHI"
+RECORD_RE = re.compile(r"AT:([0-9a-fA-F]{24})")
+BEGIN_RE = re.compile(r"AT_BEGIN (\d+)")
+
+I2S_FRAME_START = 1
+SDU_RECV = 2
+DRIFT_STATE = 3
+PRES_STATE = 4
+PRES_ADJ = 5
+I2S_UNDERRUN = 6
+I2S_OVERRUN = 7
+
+EVENT_NAMES = {
+    I2S_FRAME_START: "I2S_FRAME_START",
+    SDU_RECV: "SDU_RECV",
+    DRIFT_STATE: "DRIFT_STATE",
+    PRES_STATE: "PRES_STATE",
+    PRES_ADJ: "PRES_ADJ",
+    I2S_UNDERRUN: "I2S_UNDERRUN",
+    I2S_OVERRUN: "I2S_OVERRUN",
+}
+
+# Same order as the state enums in audio_datapath.c
+DRIFT_STATE_NAMES = ["INIT", "CALIB", "OFFSET", "LOCKED"]
+PRES_STATE_NAMES = ["INIT", "MEAS", "WAIT", "LOCKED"]
+
+I2S_BLOCK_US = 1000
+
+
+class Event:
+    def __init__(self, ts_us, evt_id, a8, a16, a32):
+        self.ts_us = ts_us
+        self.evt_id = evt_id
+        self.a8 = a8
+        self.a16 = a16
+        self.a32 = a32
+
+    def details(self):
+        if self.evt_id == I2S_FRAME_START:
+            return f"cons_blk={self.a16} prod_blk={self.a32}"
+        if self.evt_id == SDU_RECV:
+            bad = " bad" if self.a8 else ""
+            return f"sdu_ref={self.a32} recv-sdu_ref={s32(self.ts_us - self.a32)} us{bad}"
+        if self.evt_id == DRIFT_STATE:
+            return state_name(DRIFT_STATE_NAMES, self.a8)
+        if self.evt_id == PRES_STATE:
+            return state_name(PRES_STATE_NAMES, self.a8)
+        if self.evt_id == PRES_ADJ:
+            return f"{s32(self.a32)} us"
+        if self.evt_id == I2S_UNDERRUN:
+            return f"total={self.a32}"
+        return ""
+
+
+def s32(value):
+    """Interpret a 32 bit value as signed"""
+    value &= 0xFFFFFFFF
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def state_name(names, idx):
+    return names[idx] if idx < len(names) else str(idx)
+
+
+def records_parse(lines, all_dumps):
+    """Get the records of the last dump, or of all dumps"""
+    dumps = []
+    records = []
+
+    for line in lines:
+        if BEGIN_RE.search(line):
+            records = []
+            dumps.append(records)
+            continue
+
+        match = RECORD_RE.search(line)
+        if match:
+            if not dumps:
+                dumps.append(records)
+            records.append(struct.unpack(RECORD_FMT, bytes.fromhex(match.group(1))))
+
+    if not dumps:
+        return []
+
+    if all_dumps:
+        return [rec for dump in dumps for rec in dump]
+
+    return dumps[-1]
+
+
+def events_build(records):
+    """Extend the 32 bit timestamps and sort the events in time"""
+    events = []
+    prev_ts = None
+    ext_ts = 0
+
+    for ts_us, evt_id, a8, a16, a32 in records:
+        if prev_ts is None:
+            ext_ts = ts_us
+        else:
+            ext_ts += s32(ts_us - prev_ts)
+        prev_ts = ts_us
+        events.append(Event(ext_ts, evt_id, a8, a16, a32))
+
+    # Events from ISRs can be recorded slightly out of order
+    events.sort(key=lambda evt: evt.ts_us)
+
+    return events
+
+
+def stats_print(name, values, unit="us"):
+    if not values:
+        print(f"{name}: no data")
+        return
+
+    mean = sum(values) / len(values)
+    std = math.sqrt(sum((val - mean) ** 2 for val in values) / len(values))
+    srt = sorted(values)
+    p99 = srt[min(len(srt) - 1, int(len(srt) * 0.99))]
+
+    print(
+        f"{name}: n={len(values)} mean={mean:.1f} std={std:.1f} "
+        f"min={srt[0]} p99={p99} max={srt[-1]} {unit}"
+    )
+
+
+def intervals_get(stamps):
+    return [b - a for a, b in zip(stamps, stamps[1:])]
+
+
+def jitter_get(intervals, nominal):
+    return [abs(val - nominal) for val in intervals]
+
+
+def timeline_print(events):
+    start = events[0].ts_us
+    prev = start
+
+    for evt in events:
+        name = EVENT_NAMES.get(evt.evt_id, f"ID_{evt.evt_id}")
+        print(
+            f"{(evt.ts_us - start) / 1000:12.3f} ms  +{evt.ts_us - prev:7d} us  "
+            f"{name:16s} {evt.details()}"
+        )
+        prev = evt.ts_us
+
+
+def summary_print(events, frame_us):
+    i2s = [evt.ts_us for evt in events if evt.evt_id == I2S_FRAME_START]
+    sdu = [evt for evt in events if evt.evt_id == SDU_RECV]
+    sdu_ref = []
+    prev_ref = None
+
+    # sdu_ref is a NET core timestamp, extend it on its own
+    for evt in sdu:
+        if prev_ref is None:
+            sdu_ref.append(evt.a32)
+        else:
+            sdu_ref.append(sdu_ref[-1] + s32(evt.a32 - prev_ref))
+        prev_ref = evt.a32
+
+    span_ms = (events[-1].ts_us - events[0].ts_us) / 1000
+    print(f"Events: {len(events)} over {span_ms:.1f} ms")
+
+    i2s_intervals = intervals_get(i2s)
+    stats_print("I2S frame start interval", i2s_intervals)
+    stats_print("I2S frame start jitter", jitter_get(i2s_intervals, I2S_BLOCK_US))
+
+    ref_intervals = intervals_get(sdu_ref)
+    stats_print("sdu_ref interval", ref_intervals)
+    stats_print(
+        "sdu_ref jitter",
+        jitter_get([val for val in ref_intervals if val < frame_us * 1.5], frame_us),
+    )
+
+    recv_intervals = intervals_get([evt.ts_us for evt in sdu])
+    stats_print("SDU receive interval", recv_intervals)
+    stats_print("SDU receive after sdu_ref", [s32(evt.ts_us - evt.a32) for evt in sdu])
+
+    bad = sum(1 for evt in sdu if evt.a8)
+    print(f"Bad frames: {bad}")
+
+    for evt_id in (I2S_UNDERRUN, I2S_OVERRUN, PRES_ADJ):
+        count = sum(1 for evt in events if evt.evt_id == evt_id)
+        print(f"{EVENT_NAMES[evt_id]}: {count}")
+
+    print("State changes:")
+    start = events[0].ts_us
+    for evt in events:
+        if evt.evt_id in (DRIFT_STATE, PRES_STATE):
+            print(
+                f"\t{(evt.ts_us - start) / 1000:12.3f} ms  "
+                f"{EVENT_NAMES[evt.evt_id]:12s} {evt.details()}"
+            )
+
+
+def __main():
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        description=(
+            "Decode the output of the audio_trace dump shell command into a "
+            "timeline and jitter statistics"
+        ),
+    )
+    parser.add_argument(
+        "file",
+        nargs="?",
+        type=argparse.FileType("r"),
+        default=sys.stdin,
+        help="Captured terminal output, default stdin",
+    )
+    parser.add_argument(
+        "-t", "--timeline", action="store_true", help="Print all events in time order"
+    )
+    parser.add_argument(
+        "-a",
+        "--all",
+        action="store_true",
+        help="Decode all dumps in the file, not only the last one",
+    )
+    parser.add_argument(
+        "-f",
+        "--frame_us",
+        type=int,
+        default=10000,
+        help="Audio frame duration in us, default 10000",
+    )
+    options = parser.parse_args()
+
+    events = events_build(records_parse(options.file, options.all))
+    if not events:
+        print("No trace records found")
+        sys.exit(1)
+
+    if options.timeline:
+        timeline_print(events)
+        print()
+
+    summary_print(events, options.frame_us)
+
+
+if __name__ == "__main__":
+    __main()